@@ -18,6 +18,8 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
+#include <error.h>
 #include <extension/action.h>
 #include <gtkmm_utility.h>
 #include <gui/comboboxtextcolumns.h>
@@ -226,6 +228,17 @@ class ChangeFrameratePlugin : public Action {
 
       g_return_if_fail(doc);
 
+      apply_framerate(doc, src_fps, dest_fps);
+
+      doc->flash_message(_("The new framerate was applied. (%s to %s)"), to_string(src_fps).c_str(), to_string(dest_fps).c_str());
+   }
+
+  public:
+   // Change the time of all subtitles from the source framerate to the
+   // destination framerate. It's also the batch step "change-framerate".
+   static void apply_framerate(Document* doc, double src_fps, double dest_fps) {
+      se_dbg(SE_DBG_PLUGINS);
+
       doc->start_command(_("Change Framerate"));
 
       Subtitles subtitles = doc->subtitles();
@@ -243,11 +256,9 @@ class ChangeFrameratePlugin : public Action {
 
       doc->emit_signal("subtitle-time-changed");
       doc->finish_command();
-
-      doc->flash_message(_("The new framerate was applied. (%s to %s)"), to_string(src_fps).c_str(), to_string(dest_fps).c_str());
    }
 
-   SubtitleTime change_fps(const SubtitleTime& time, double src, double dest) {
+   static SubtitleTime change_fps(const SubtitleTime& time, double src, double dest) {
       se_dbg(SE_DBG_PLUGINS);
 
       double frame = time.totalmsecs * src;
@@ -261,4 +272,23 @@ class ChangeFrameratePlugin : public Action {
    Glib::RefPtr<Gtk::ActionGroup> action_group;
 };
 
+// Batch step "change-framerate:SRC:DEST"
+static void batch_change_framerate(Document* doc, const std::vector<Glib::ustring>& args) {
+   double src = (args.size() == 2) ? utility::string_to_double(args[0]) : 0;
+   double dest = (args.size() == 2) ? utility::string_to_double(args[1]) : 0;
+
+   if (src <= 0 || dest <= 0)
+      throw SubtitleError(_("The step change-framerate needs the source and the destination framerates (change-framerate:23.976:25)."));
+
+   ChangeFrameratePlugin::apply_framerate(doc, src, dest);
+}
+
+static void register_batch_steps() {
+   se::batch::register_step("change-framerate",
+                            "SRC:DEST",
+                            _("Convert the subtitles synced to a video at SRC fps to a video at DEST fps"),
+                            sigc::ptr_fun(&batch_change_framerate));
+}
+
 REGISTER_EXTENSION(ChangeFrameratePlugin)
+REGISTER_BATCH_STEPS(register_batch_steps)
@@ -26,6 +26,7 @@
 #include <extension/action.h>
 #include <i18n.h>
 #include <subtitleformatsystem.h>
+#include <subtitletimeindex.h>
 #include <utility.h>
 
 #include <memory>
@@ -780,38 +781,31 @@ class ClipboardPlugin : public Action {
          return;
       }
 
+      // the subtitles of the document which overlap one of the clipboard
+      std::vector<Subtitle> subs, clipsubs;
+      SubtitleTimeIndex index, clipindex;
+      index_times(doc, index, subs);
+      index_times(clipdoc, clipindex, clipsubs);
+
       std::vector<Subtitle> selection;
-      Subtitles subtitles = doc->subtitles();
+      for (unsigned int row : index.find_overlaps(clipindex)) selection.push_back(subs[row]);
 
-      Subtitle clipsub = clipdoc->subtitles().get_first();
-      while (clipsub) {
-         add_overlaps(selection, clipsub, subtitles);
-         clipsub = clipdoc->subtitles().get_next(clipsub);
-      }
+      Subtitles subtitles = doc->subtitles();
       subtitles.unselect_all();
       subtitles.select(selection);
       doc->flash_message(_("Selected %i subtitles."), selection.size());
    }
 
-   bool subs_overlap(const Subtitle& a, const Subtitle& b) {
-      long astart = a.get_start().totalmsecs;
-      long aend = a.get_end().totalmsecs;
-      long bstart = b.get_start().totalmsecs;
-      long bend = b.get_end().totalmsecs;
-      if ((astart < bend) && (bstart < aend)) {
-         return true;
-      }
-      return false;
-   };
-
-   void add_overlaps(std::vector<Subtitle>& dst, const Subtitle& selsub, Subtitles& subs) {
-      Subtitle cursub = subs.get_first();
-      while (cursub) {
-         if (subs_overlap(cursub, selsub)) {
-            dst.push_back(cursub);
-         }
-         cursub = subs.get_next(cursub);
+   // Index the times of the subtitles of the document, in msecs because the
+   // documents can have different timing modes. The subtitles are in subs by row.
+   void index_times(Document* doc, SubtitleTimeIndex& index, std::vector<Subtitle>& subs) {
+      std::vector<long> starts, ends;
+      for (Subtitle sub = doc->subtitles().get_first(); sub; ++sub) {
+         subs.push_back(sub);
+         starts.push_back(sub.get_start().totalmsecs);
+         ends.push_back(sub.get_end().totalmsecs);
       }
+      index.build(starts, ends);
    }
 
    // ================= PASTE COMMANDS =====================
@@ -95,7 +95,10 @@ class CommandPlugin : public Action {
 
       Glib::ustring description = doc->get_command_system().get_undo_description();
 
-      se_dbg_msg(SE_DBG_PLUGINS, "description=%s", description.c_str());
+      se_dbg_msg(SE_DBG_PLUGINS,
+                 "description=%s history=%s",
+                 description.c_str(),
+                 Glib::format_size(doc->get_command_system().get_memory_size()).c_str());
 
       if (!description.empty()) {
          doc->get_command_system().undo();
@@ -112,7 +115,10 @@ class CommandPlugin : public Action {
 
       Glib::ustring description = doc->get_command_system().get_redo_description();
 
-      se_dbg_msg(SE_DBG_PLUGINS, "description=%s", description.c_str());
+      se_dbg_msg(SE_DBG_PLUGINS,
+                 "description=%s history=%s",
+                 description.c_str(),
+                 Glib::format_size(doc->get_command_system().get_memory_size()).c_str());
 
       if (!description.empty()) {
          doc->get_command_system().redo();
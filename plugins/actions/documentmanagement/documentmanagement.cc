@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <documentloader.h>
 #include <documents.h>
 #include <extension/action.h>
 #include <gui/dialogfilechooser.h>
@@ -252,9 +253,12 @@ class DocumentManagementPlugin : public Action {
 
       std::vector<Glib::ustring> uris = dialog->get_uris();
 
+      // The files are read in parallel, the files already open are skipped
+      DocumentLoader loader;
       for (const auto& uri : uris) {
-         open_document(uri, charset);
+         loader.add(uri, charset);
       }
+      loader.run();
 
       Glib::ustring video_uri = dialog->get_video_uri();
       if (video_uri.empty() == false) {
@@ -266,23 +270,12 @@ class DocumentManagementPlugin : public Action {
    bool open_document(const Glib::ustring& uri, const Glib::ustring& charset) {
       se_dbg_msg(SE_DBG_PLUGINS, "uri=%s charset=%s", uri.c_str(), charset.c_str());
 
-      Glib::ustring filename = Glib::filename_from_uri(uri);
-
-      // check if is not already open
-      Document* already = se::documents::find_by_name(filename);
-
-      if (already) {
-         already->flash_message(_("I am already open"));
-         return false;
-      }
-      // Don't need to catch error, create_from_file catch and
-      // display errors messages if needs.
-      Document* doc = Document::create_from_file(uri, charset);
-      if (!doc)
+      // The loader checks if the file is not already open, the errors
+      // messages are displayed by Document::create_from_file if needs.
+      DocumentLoader loader;
+      if (!loader.add(uri, charset))
          return false;
-
-      se::documents::append(doc);
-      return true;
+      return loader.run() == 1;
    }
 
    // Save a document. If file doesn't exist use save_as
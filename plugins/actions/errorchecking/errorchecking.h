@@ -21,11 +21,69 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gtkmm.h>
+#include <utility.h>
+
+#include <cmath>
+#include <utility>
+#include <vector>
 
 #include "document.h"
+#include "subtitleerrors.h"
 
 class ErrorChecking {
   public:
+   // The timing and the text of a subtitle, the only values read by the
+   // checkers to detect an error. It's a copy, the checkers can run on it
+   // out of the main thread.
+   class SubtitleData {
+     public:
+      SubtitleData() {
+      }
+
+      // Copy the values of the subtitle.
+      // The text values are computed by update_text_values().
+      explicit SubtitleData(const Subtitle& sub) {
+         num = sub.get_num();
+         start = sub.get_start();
+         end = sub.get_end();
+         text = sub.get_text();
+      }
+
+      // Compute the characters per second and per line from the text and the times.
+      void update_text_values() {
+         characters_per_second = utility::get_characters_per_second(text, (end - start).totalmsecs);
+         characters_per_line = utility::get_characters_per_line(text);
+      }
+
+      SubtitleTime get_duration() const {
+         return end - start;
+      }
+
+      // Like Subtitle::check_cps_text.
+      // Return -1 if the characters per second are lower than mincps,
+      // 1 if they are higher than maxcps, otherwise 0.
+      int check_cps(double mincps, double maxcps) const {
+         // round cps to 1/10 precision and ignore the fuzz left
+         double cps = round(10.0 * characters_per_second) / 10.0;
+         if ((mincps - cps) > 0.0001)
+            return -1;
+         if ((cps - maxcps) > 0.0001)
+            return 1;
+         return 0;
+      }
+
+     public:
+      unsigned int num{0};
+      SubtitleTime start;
+      SubtitleTime end;
+      Glib::ustring text;
+      double characters_per_second{0};
+      std::vector<int> characters_per_line;
+      // The subtitles after this one which overlap it, found by the engine
+      // on all the document: their number and the overlap in msecs.
+      std::vector<std::pair<unsigned int, long>> overlaps;
+   };
+
    class Info {
      public:
       Document* document;
@@ -34,6 +92,13 @@ class ErrorChecking {
       Subtitle nextSub;
       Subtitle previousSub;
 
+      // The data of the subtitles used to detect the error,
+      // next and previous are null when there's no subtitle.
+      // The handles (currentSub...) are only needed to fix it.
+      const SubtitleData* current{nullptr};
+      const SubtitleData* next{nullptr};
+      const SubtitleData* previous{nullptr};
+
       bool tryToFix;
 
       Glib::ustring error;
@@ -41,7 +106,7 @@ class ErrorChecking {
    };
 
    ErrorChecking(const Glib::ustring& name, const Glib::ustring& label, const Glib::ustring& description)
-       : m_name(name), m_label(label), m_description(description), m_has_configuration(false) {
+       : m_name(name), m_label(label), m_description(description), m_has_configuration(false), m_flag(SUBTITLE_ERROR_NONE) {
    }
 
    virtual ~ErrorChecking() {
@@ -59,6 +124,11 @@ class ErrorChecking {
       return m_description;
    }
 
+   // Return the flag of the error in the bitmask of SubtitleErrors.
+   guint get_flag() const {
+      return m_flag;
+   }
+
    void set_active(bool state) {
       cfg::set_boolean(get_name(), "enabled", state);
    }
@@ -82,6 +152,9 @@ class ErrorChecking {
       // init from your preferences values
    }
 
+   // Detect (or fix with tryToFix) the error on info.current.
+   // Without tryToFix it only reads the data of the subtitles and can be
+   // called by several threads at the same time.
    virtual bool execute(Info&) {
       return false;
    }
@@ -91,4 +164,5 @@ class ErrorChecking {
    Glib::ustring m_label;
    Glib::ustring m_description;
    bool m_has_configuration;
+   guint m_flag;
 };
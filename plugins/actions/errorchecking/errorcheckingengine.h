@@ -0,0 +1,455 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <subtitlesnapshot.h>
+#include <subtitletimeindex.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "errorchecking.h"
+
+// Find the errors of the subtitles of a document with a group of checkers.
+// The timing and the text of the subtitles are copied once in a flat array
+// (the snapshot), the checkers are run over chunks of it by worker threads.
+// The rows changed in the model are followed and, when the document emits
+// "subtitle-time-changed" or "document-changed", only these rows and their
+// neighbours are checked again.
+class ErrorCheckingEngine {
+  public:
+   // An error found by a checker on a subtitle.
+   struct Error {
+      ErrorChecking* checker;
+      Glib::ustring error;
+      Glib::ustring solution;
+   };
+
+   explicit ErrorCheckingEngine(const std::vector<ErrorChecking*>& checkers) : m_checkers(checkers) {
+   }
+
+   ~ErrorCheckingEngine() {
+      set_document(nullptr);
+   }
+
+   // Follow the changes of the document (or none).
+   // The errors are cleared, call check_all().
+   void set_document(Document* doc) {
+      for (auto& connection : m_connections) connection.disconnect();
+      m_connections.clear();
+      m_update_connection.disconnect();
+
+      m_document = doc;
+      m_rows.clear();
+      m_errors.clear();
+      m_checked_rows.clear();
+      m_dirty.clear();
+      m_rebuild = false;
+      m_count = 0;
+
+      if (doc == nullptr)
+         return;
+
+      m_connections.push_back(doc->subtitles().connect_row_changed(sigc::mem_fun(*this, &ErrorCheckingEngine::on_row_changed)));
+      m_connections.push_back(doc->subtitles().connect_rows_changed(sigc::mem_fun(*this, &ErrorCheckingEngine::invalidate)));
+
+      m_connections.push_back(doc->get_signal("subtitle-time-changed").connect(sigc::mem_fun(*this, &ErrorCheckingEngine::queue_update)));
+      m_connections.push_back(doc->get_signal("document-changed").connect(sigc::mem_fun(*this, &ErrorCheckingEngine::queue_update)));
+   }
+
+   Document* get_document() const {
+      return m_document;
+   }
+
+   // Snapshot the whole document and check all the subtitles.
+   // The signal "changed" is emitted.
+   void check_all() {
+      m_update_connection.disconnect();
+
+      if (m_document == nullptr) {
+         m_rows.clear();
+         m_errors.clear();
+         m_checked_rows.clear();
+         m_count = 0;
+      } else {
+         check_document();
+      }
+
+      m_signal_changed.emit();
+   }
+
+   // Check again the subtitles changed since the last check and their neighbours.
+   // If a subtitle has been inserted, removed or moved, all the document is checked.
+   // The signal "changed" is emitted if something was checked.
+   void update() {
+      m_update_connection.disconnect();
+
+      if (check_changes())
+         m_signal_changed.emit();
+   }
+
+   // Fix the errors found by the checkers on all the subtitles.
+   // See fix_rows().
+   unsigned int fix_all(const std::vector<ErrorChecking*>& checkers, const Glib::ustring& description) {
+      m_update_connection.disconnect();
+
+      std::set<unsigned int> checked;
+      check_changes(checked);
+
+      std::vector<unsigned int> rows(m_rows.size());
+      std::iota(rows.begin(), rows.end(), 0);
+      return fix_rows(checkers, rows, description, checked);
+   }
+
+   // Fix the errors found by the checkers on the rows (sorted).
+   // The fixes are computed from the snapshot, the checkers one after the
+   // other, the rows changed by a checker are checked again before the next.
+   // All the fixes are recorded in one command and the signals of the
+   // document are emitted once at the end. get_checked_rows() returns all
+   // the rows checked again since the call.
+   // Return the number of errors fixed.
+   unsigned int fix_rows(const std::vector<ErrorChecking*>& checkers, const std::vector<unsigned int>& rows, const Glib::ustring& description) {
+      std::set<unsigned int> checked;
+      return fix_rows(checkers, rows, description, checked);
+   }
+
+   // Return the number of subtitles checked.
+   unsigned int size() const {
+      return m_rows.size();
+   }
+
+   // Return the number of the subtitle of the row.
+   unsigned int get_num(unsigned int row) const {
+      return m_rows[row].num;
+   }
+
+   // Return the errors of the row, in the order of the checkers.
+   const std::vector<Error>& get_errors(unsigned int row) const {
+      return m_errors[row];
+   }
+
+   // Return the errors of the row as a bitmask (SubtitleErrorFlags).
+   guint get_flags(unsigned int row) const {
+      guint flags = SUBTITLE_ERROR_NONE;
+      for (const auto& error : m_errors[row]) flags |= error.checker->get_flag();
+      return flags;
+   }
+
+   // Return the number of errors.
+   unsigned int count() const {
+      return m_count;
+   }
+
+   // Return the rows checked by the last check, in order.
+   const std::vector<unsigned int>& get_checked_rows() const {
+      return m_checked_rows;
+   }
+
+   // Emitted after a check, the errors have changed.
+   sigc::signal<void>& signal_changed() {
+      return m_signal_changed;
+   }
+
+  protected:
+   // See fix_rows(), checked has the rows already checked by the caller.
+   unsigned int fix_rows(const std::vector<ErrorChecking*>& checkers,
+                         const std::vector<unsigned int>& rows,
+                         const Glib::ustring& description,
+                         std::set<unsigned int>& checked) {
+      if (m_document == nullptr)
+         return 0;
+
+      // the snapshot must be the document
+      m_update_connection.disconnect();
+      check_changes(checked);
+
+      unsigned int count = 0;
+      m_document->start_command(description);
+      for (const auto& checker : checkers) {
+         for (unsigned int row : rows) {
+            if (row >= m_rows.size())
+               continue;
+
+            for (const auto& error : m_errors[row]) {
+               if (error.checker == checker && fix_row(checker, row))
+                  ++count;
+            }
+         }
+         check_changes(checked);
+      }
+      m_document->finish_command();
+
+      if (count > 0)
+         m_document->emit_signal("subtitle-time-changed");
+
+      // the listeners update the rows checked by all the steps
+      m_checked_rows.clear();
+      for (unsigned int row : checked) {
+         if (row < m_rows.size())
+            m_checked_rows.push_back(row);
+      }
+
+      m_update_connection.disconnect();
+      m_signal_changed.emit();
+
+      return count;
+   }
+
+   // Snapshot the whole document and check all the subtitles.
+   void check_document() {
+      m_dirty.clear();
+      m_rebuild = false;
+
+      SubtitleSnapshot snapshot;
+      m_document->subtitles().get_snapshot(snapshot);
+
+      // the times are in the timing mode of the document
+      const bool frame = (m_document->get_timing_mode() == FRAME);
+      const float framerate = get_framerate_value(m_document->get_framerate());
+      auto to_time = [frame, framerate](gint64 value) {
+         return frame ? SubtitleTime::frame_to_time(static_cast<long>(value), framerate) : SubtitleTime(static_cast<long>(value));
+      };
+
+      m_rows.assign(snapshot.size(), ErrorChecking::SubtitleData());
+      for (unsigned int i = 0; i < snapshot.size(); ++i) {
+         ErrorChecking::SubtitleData& row = m_rows[i];
+         row.num = snapshot.num(i);
+         row.start = to_time(snapshot.start(i));
+         row.end = to_time(snapshot.end(i));
+         row.text = snapshot.text(i);
+      }
+
+      update_overlaps();
+      update_active_checkers();
+
+      parallel_for(m_rows.size(), [this](unsigned int i) { m_rows[i].update_text_values(); });
+
+      m_errors.assign(m_rows.size(), std::vector<Error>());
+      parallel_for(m_rows.size(), [this](unsigned int i) { check_row(i); });
+
+      m_count = 0;
+      for (const auto& errors : m_errors) m_count += errors.size();
+
+      m_checked_rows.resize(m_rows.size());
+      std::iota(m_checked_rows.begin(), m_checked_rows.end(), 0);
+   }
+
+   // Check the subtitles changed since the last check and their neighbours,
+   // or all the document if the rows have changed.
+   // Return false if there was nothing to check.
+   bool check_changes() {
+      if (m_document == nullptr)
+         return false;
+
+      if (m_rebuild || m_rows.size() != m_document->subtitles().size()) {
+         check_document();
+         return true;
+      }
+
+      if (m_dirty.empty())
+         return false;
+
+      // copy the changed subtitles, then the rows to check
+      std::vector<unsigned int> changed(m_dirty.begin(), m_dirty.end());
+      m_dirty.clear();
+
+      std::set<unsigned int> to_check;
+      for (unsigned int row : changed) {
+         m_rows[row] = ErrorChecking::SubtitleData(Subtitle(m_document, to_string(row)));
+
+         // the checkers read the next and the previous subtitles
+         if (row > 0)
+            to_check.insert(row - 1);
+         to_check.insert(row);
+         if (row + 1 < m_rows.size())
+            to_check.insert(row + 1);
+      }
+      // and the subtitles which overlap them now or before
+      for (unsigned int row : update_overlaps()) to_check.insert(row);
+      std::vector<unsigned int> rows(to_check.begin(), to_check.end());
+
+      update_active_checkers();
+
+      parallel_for(changed.size(), [this, &changed](unsigned int i) { m_rows[changed[i]].update_text_values(); });
+
+      for (unsigned int row : rows) m_count -= m_errors[row].size();
+      parallel_for(rows.size(), [this, &rows](unsigned int i) { check_row(rows[i]); });
+      for (unsigned int row : rows) m_count += m_errors[row].size();
+
+      m_checked_rows.swap(rows);
+      return true;
+   }
+
+   // Check the changes and add the rows checked to checked.
+   void check_changes(std::set<unsigned int>& checked) {
+      if (check_changes())
+         checked.insert(m_checked_rows.begin(), m_checked_rows.end());
+   }
+
+   // Fix the error of the checker on the row, the values are read from
+   // the snapshot and written in the subtitles.
+   bool fix_row(ErrorChecking* checker, unsigned int row) {
+      ErrorChecking::Info info;
+      info.document = m_document;
+      info.currentSub = Subtitle(m_document, to_string(row));
+      info.current = &m_rows[row];
+      if (row + 1 < m_rows.size()) {
+         info.nextSub = Subtitle(m_document, to_string(row + 1));
+         info.next = &m_rows[row + 1];
+      }
+      if (row > 0) {
+         info.previousSub = Subtitle(m_document, to_string(row - 1));
+         info.previous = &m_rows[row - 1];
+      }
+      info.tryToFix = true;
+
+      return checker->execute(info);
+   }
+
+   // Find all the overlapping subtitles of the snapshot with a sweep line,
+   // each pair is kept by the row of its first subtitle.
+   // Return the rows whose overlaps have changed.
+   std::vector<unsigned int> update_overlaps() {
+      std::vector<long> starts(m_rows.size()), ends(m_rows.size());
+      for (unsigned int i = 0; i < m_rows.size(); ++i) {
+         starts[i] = std::min(m_rows[i].start, m_rows[i].end).totalmsecs;
+         ends[i] = std::max(m_rows[i].start, m_rows[i].end).totalmsecs;
+      }
+
+      SubtitleTimeIndex index;
+      index.build(starts, ends);
+
+      std::vector<std::vector<std::pair<unsigned int, long>>> overlaps(m_rows.size());
+      for (const auto& pair : index.find_overlaps()) {
+         long overlap = std::min(ends[pair.first], ends[pair.second]) - std::max(starts[pair.first], starts[pair.second]);
+         overlaps[pair.first].push_back({m_rows[pair.second].num, overlap});
+      }
+
+      std::vector<unsigned int> changed;
+      for (unsigned int row = 0; row < m_rows.size(); ++row) {
+         if (m_rows[row].overlaps != overlaps[row]) {
+            m_rows[row].overlaps.swap(overlaps[row]);
+            changed.push_back(row);
+         }
+      }
+      return changed;
+   }
+
+   // The checkers are enabled in the config, read it once by check.
+   void update_active_checkers() {
+      m_active.clear();
+      for (const auto& checker : m_checkers) {
+         if (checker->get_active())
+            m_active.push_back(checker);
+      }
+
+      // get_stripped_text initializes its regex with the config on the
+      // first call, do it before the worker threads
+      utility::get_stripped_text(Glib::ustring());
+   }
+
+   // Run the active checkers on the row.
+   // Only the data of the row and its neighbours are read, only the errors
+   // of the row are written, several rows can be checked at the same time.
+   void check_row(unsigned int row) {
+      std::vector<Error>& errors = m_errors[row];
+      errors.clear();
+
+      for (const auto& checker : m_active) {
+         ErrorChecking::Info info;
+         info.document = m_document;
+         info.current = &m_rows[row];
+         info.next = (row + 1 < m_rows.size()) ? &m_rows[row + 1] : nullptr;
+         info.previous = (row > 0) ? &m_rows[row - 1] : nullptr;
+         info.tryToFix = false;
+
+         if (checker->execute(info))
+            errors.push_back({checker, info.error, info.solution});
+      }
+   }
+
+   // Call func(i) for each i in [0, count).
+   // The range is split in chunks which are shared by the worker threads
+   // and the calling thread, a small range is done without thread.
+   template <typename Func>
+   static void parallel_for(unsigned int count, Func func) {
+      const unsigned int chunk_size = 512;
+      const unsigned int chunks = (count + chunk_size - 1) / chunk_size;
+
+      std::atomic<unsigned int> next_chunk{0};
+      auto work = [&]() {
+         for (unsigned int chunk = next_chunk++; chunk < chunks; chunk = next_chunk++) {
+            const unsigned int last = std::min(count, (chunk + 1) * chunk_size);
+            for (unsigned int i = chunk * chunk_size; i < last; ++i) func(i);
+         }
+      };
+
+      unsigned int count_threads = std::min(std::max(1u, std::thread::hardware_concurrency()), chunks);
+
+      std::vector<std::thread> threads;
+      for (unsigned int i = 1; i < count_threads; ++i) threads.push_back(std::thread(work));
+      work();
+      for (auto& thread : threads) thread.join();
+   }
+
+   void on_row_changed(unsigned int row) {
+      m_dirty.insert(row);
+   }
+
+   // A subtitle has been inserted, removed or moved, the rows of the
+   // snapshot are no longer the rows of the model.
+   void invalidate() {
+      m_rebuild = true;
+   }
+
+   // Check the changes when the main loop is idle, several signals
+   // emitted by the same action are handled once.
+   void queue_update() {
+      if (!m_update_connection.connected())
+         m_update_connection = Glib::signal_idle().connect(sigc::mem_fun(*this, &ErrorCheckingEngine::on_update_idle));
+   }
+
+   bool on_update_idle() {
+      update();
+      return false;
+   }
+
+  protected:
+   const std::vector<ErrorChecking*>& m_checkers;
+   std::vector<ErrorChecking*> m_active;
+
+   Document* m_document{nullptr};
+   std::vector<ErrorChecking::SubtitleData> m_rows;
+   std::vector<std::vector<Error>> m_errors;
+   std::vector<unsigned int> m_checked_rows;
+   unsigned int m_count{0};
+
+   std::set<unsigned int> m_dirty;
+   bool m_rebuild{false};
+
+   std::vector<sigc::connection> m_connections;
+   sigc::connection m_update_connection;
+   sigc::signal<void> m_signal_changed;
+};
@@ -18,13 +18,20 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
+#include <documents.h>
+#include <error.h>
 #include <extension/action.h>
 #include <gtkmm_utility.h>
 #include <utility.h>
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
+#include <set>
 
 #include "errorchecking.h"
+#include "errorcheckingengine.h"
 #include "errorcheckingpreferences.h"
 #include "maxcharactersperline.h"
 #include "maxcharacterspersecond.h"
@@ -108,7 +115,7 @@ class DialogErrorChecking : public Gtk::Dialog {
       return m_static_instance;
    }
 
-   DialogErrorChecking(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& builder) : Gtk::Dialog(cobject) {
+   DialogErrorChecking(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& builder) : Gtk::Dialog(cobject), m_engine(m_checker_list) {
       se_dbg(SE_DBG_PLUGINS);
 
       m_sort_type = BY_CATEGORIES;
@@ -119,6 +126,11 @@ class DialogErrorChecking : public Gtk::Dialog {
       builder->get_widget("statusbar", m_statusbar);
 
       create_treeview();
+
+      // The errors are checked again when the document changes,
+      // the model is updated from them.
+      m_engine.signal_changed().connect(sigc::mem_fun(*this, &DialogErrorChecking::on_errors_changed));
+      m_engine.set_document(get_document());
       refresh();
    }
 
@@ -219,7 +231,10 @@ class DialogErrorChecking : public Gtk::Dialog {
       m_action_group->get_action("ExpandAll")->set_sensitive(state);
       m_action_group->get_action("CollapseAll")->set_sensitive(state);
 
-      refresh();
+      if (doc != m_engine.get_document()) {
+         m_engine.set_document(doc);
+         refresh();
+      }
    }
 
    // Return the current document.
@@ -231,7 +246,7 @@ class DialogErrorChecking : public Gtk::Dialog {
    void set_sort_type(SortType type) {
       m_sort_type = type;
 
-      refresh();
+      rebuild_model();
    }
 
    // Return the sort type.
@@ -263,7 +278,8 @@ class DialogErrorChecking : public Gtk::Dialog {
       m_treeview->set_rules_hint(true);
 
       // signals
-      m_treeview->get_selection()->signal_changed().connect(sigc::mem_fun(*this, &DialogErrorChecking::on_selection_changed));
+      m_selection_connection =
+         m_treeview->get_selection()->signal_changed().connect(sigc::mem_fun(*this, &DialogErrorChecking::on_selection_changed));
 
       m_treeview->signal_row_activated().connect(sigc::mem_fun(*this, &DialogErrorChecking::on_row_activated));
       // tooltip
@@ -309,261 +325,308 @@ class DialogErrorChecking : public Gtk::Dialog {
    }
 
    // Add an error in the node.
+   void add_error(Gtk::TreeModel::Row& node, unsigned int num, const ErrorCheckingEngine::Error& error) {
+      Gtk::TreeModel::Row row = *m_model->append(node.children());
+      set_error(row, num, error);
+   }
+
+   // Set the values of the error to the row.
    // The label depend of the sort type.
-   void add_error(Gtk::TreeModel::Row& node, ErrorChecking::Info& info, ErrorChecking* checker) {
+   void set_error(Gtk::TreeModel::Row& row, unsigned int num, const ErrorCheckingEngine::Error& error) {
       Glib::ustring text;
 
       if (get_sort_type() == BY_CATEGORIES) {
-         Glib::ustring subtitle = build_message(_("Subtitle n°<b>%d</b>"), info.currentSub.get_num());
-         Glib::ustring error = info.error;
+         Glib::ustring subtitle = build_message(_("Subtitle n°<b>%d</b>"), num);
 
-         text = build_message("%s\n%s", subtitle.c_str(), error.c_str());
+         text = build_message("%s\n%s", subtitle.c_str(), error.error.c_str());
       } else if (get_sort_type() == BY_SUBTITLES) {
-         Glib::ustring checker_label = checker->get_label();
-         Glib::ustring error = info.error;
+         Glib::ustring checker_label = error.checker->get_label();
 
-         text = build_message("%s\n%s", checker_label.c_str(), error.c_str());
+         text = build_message("%s\n%s", checker_label.c_str(), error.error.c_str());
       }
 
-      Gtk::TreeIter it = m_model->append(node.children());
-
-      (*it)[m_column.num] = to_string(info.currentSub.get_num());
-      (*it)[m_column.checker] = checker;
-      (*it)[m_column.text] = text;
-      (*it)[m_column.solution] = info.solution;
+      row[m_column.num] = to_string(num);
+      row[m_column.checker] = error.checker;
+      row[m_column.text] = text;
+      row[m_column.solution] = error.solution;
    }
 
-   // Rebuild the model.
-   // Check errors.
+   // Check all the errors of the document.
+   // The model is rebuilt when it's done.
    void refresh() {
-      m_model->clear();
-      m_statusbar->push("");
+      m_engine.check_all();
+   }
 
-      Document* doc = get_document();
-      if (doc == NULL)
+   // The errors have been checked again.
+   // Only the rows of the subtitles checked are updated in the model, it's
+   // rebuilt when all the document has been checked.
+   void on_errors_changed() {
+      if (m_engine.get_document() == NULL || m_engine.get_checked_rows().size() == m_engine.size()) {
+         rebuild_model();
          return;
+      }
 
+      // The rows of the errors fixed can be removed, that's not a choice
+      // of the user in the subtitle view.
+      m_selection_connection.block();
       if (get_sort_type() == BY_CATEGORIES)
-         check_by_categories(doc, m_checker_list);
+         update_by_categories(m_engine.get_checked_rows());
       else  // BY_SUBTITLES
-         check_by_subtitle(doc, m_checker_list);
+         update_by_subtitle(m_engine.get_checked_rows());
+      m_selection_connection.unblock();
+
+      set_statusbar_error(m_engine.count());
    }
 
-   // Check errors by organizing them by type of error.
-   void check_by_categories(Document* doc, const std::vector<ErrorChecking*>& checkers) {
-      unsigned int count_error = 0;
+   // Rebuild the model from the errors found.
+   // The expanded nodes and the selected row are restored from their key.
+   void rebuild_model() {
+      std::set<Glib::ustring> expanded;
+      for (const auto& node : m_model->children()) {
+         if (m_treeview->row_expanded(m_model->get_path(node)))
+            expanded.insert(get_key(node));
+      }
 
-      Subtitles subtitles = doc->subtitles();
+      Glib::ustring selected;
+      Gtk::TreeIter it = m_treeview->get_selection()->get_selected();
+      if (it)
+         selected = get_key(*it);
 
-      for (const auto& checker : checkers) {
-         if (checker->get_active() == false)
-            continue;
+      m_selection_connection.block();
 
-         // Check all subtitles with the current checker
-         Gtk::TreeModel::Row row = *(m_model->append());
+      m_model->clear();
+      m_statusbar->push("");
 
-         Subtitle current, previous, next;
-         for (current = subtitles.get_first(); current; ++current) {
-            // get next
-            next = current;
-            ++next;
-
-            // info
-            ErrorChecking::Info info;
-            info.document = doc;
-            info.currentSub = current;
-            info.nextSub = next;
-            info.previousSub = previous;
-            info.tryToFix = false;
-
-            if (checker->execute(info)) {
-               add_error(row, info, checker);
-               ++count_error;
-            }
+      if (m_engine.get_document() != NULL) {
+         if (get_sort_type() == BY_CATEGORIES)
+            fill_by_categories();
+         else  // BY_SUBTITLES
+            fill_by_subtitle();
 
-            previous = current;
+         for (const auto& node : m_model->children()) {
+            if (expanded.count(get_key(node)))
+               m_treeview->expand_row(m_model->get_path(node), false);
+
+            if (!selected.empty())
+               select_by_key(node, selected);
          }
 
-         // Update the node label or delete if it empty
-         if (row.children().empty()) {
-            m_model->erase(row);
-         } else {
-            row[m_column.checker] = checker;
+         set_statusbar_error(m_engine.count());
+      }
 
-            update_node_label(row);
+      m_selection_connection.unblock();
+   }
+
+   // Return a key of the row which doesn't depend of its position,
+   // "num/checker" with an empty num or checker for a node.
+   Glib::ustring get_key(const Gtk::TreeModel::Row& row) {
+      ErrorChecking* checker = row[m_column.checker];
+      return Glib::ustring(row[m_column.num]) + "/" + (checker ? checker->get_name() : Glib::ustring());
+   }
+
+   // Select the node or its child which has the key.
+   void select_by_key(const Gtk::TreeModel::Row& node, const Glib::ustring& key) {
+      if (get_key(node) == key) {
+         m_treeview->get_selection()->select(node);
+         return;
+      }
+      for (const auto& child : node.children()) {
+         if (get_key(child) == key) {
+            m_treeview->get_selection()->select(child);
+            return;
          }
       }
+   }
 
-      set_statusbar_error(count_error);
+   // Update in place the errors of the rows (sorted) checked again.
+   // The nodes of the categories and their errors are sorted like the
+   // checkers and the subtitles.
+   void update_by_categories(const std::vector<unsigned int>& rows) {
+      Gtk::TreeIter node = m_model->children().begin();
+      for (const auto& checker : m_checker_list) {
+         ErrorChecking* node_checker = nullptr;
+         if (node)
+            node_checker = (*node)[m_column.checker];
+
+         if (node_checker != checker) {
+            bool has_error = std::any_of(rows.begin(), rows.end(), [&](unsigned int row) { return find_error(row, checker) != nullptr; });
+            if (!has_error)
+               continue;
+
+            node = node ? m_model->insert(node) : m_model->append();
+            (*node)[m_column.checker] = checker;
+         }
+
+         Gtk::TreeIter child = node->children().begin();
+         for (unsigned int row : rows) {
+            unsigned int num = m_engine.get_num(row);
+            while (child && get_num(*child) < num) ++child;
+
+            bool has_child = child && get_num(*child) == num;
+
+            const ErrorCheckingEngine::Error* error = find_error(row, checker);
+            if (error != nullptr) {
+               if (!has_child)
+                  child = child ? m_model->insert(child) : m_model->append(node->children());
+               Gtk::TreeModel::Row child_row = *child;
+               set_error(child_row, num, *error);
+               ++child;
+            } else if (has_child) {
+               child = m_model->erase(child);
+            }
+         }
+
+         // Update the node label or delete if it empty
+         if (node->children().empty()) {
+            node = m_model->erase(node);
+         } else {
+            update_node_label(*node);
+            ++node;
+         }
+      }
    }
 
-   // Check errors by organizing them by subtitle.
-   void check_by_subtitle(Document* doc, const std::vector<ErrorChecking*>& checkers) {
-      std::vector<ErrorChecking*>::const_iterator checker_it;
+   // Update in place the errors of the rows (sorted) checked again.
+   // The nodes of the subtitles are sorted like the subtitles.
+   void update_by_subtitle(const std::vector<unsigned int>& rows) {
+      Gtk::TreeIter node = m_model->children().begin();
+      for (unsigned int row : rows) {
+         unsigned int num = m_engine.get_num(row);
+         while (node && get_num(*node) < num) ++node;
 
-      Subtitles subtitles = doc->subtitles();
+         bool has_node = node && get_num(*node) == num;
 
-      unsigned int count_error = 0;
-      Subtitle current, previous, next;
-      for (current = subtitles.get_first(); current; ++current) {
-         // get next
-         next = current;
-         ++next;
+         const std::vector<ErrorCheckingEngine::Error>& errors = m_engine.get_errors(row);
+         if (errors.empty()) {
+            if (has_node)
+               node = m_model->erase(node);
+            continue;
+         }
 
-         Gtk::TreeModel::Row row = *(m_model->append());
+         if (!has_node) {
+            node = node ? m_model->insert(node) : m_model->append();
+            (*node)[m_column.checker] = NULL;  // do not needs because is sort by subtitles
+            (*node)[m_column.num] = to_string(num);
+         }
 
-         for (const auto& checker : checkers) {
-            if (checker->get_active() == false)
-               continue;
+         // The children are replaced, the node stays expanded
+         Gtk::TreeIter child = node->children().begin();
+         for (const auto& error : errors) {
+            if (!child)
+               child = m_model->append(node->children());
+            Gtk::TreeModel::Row child_row = *child;
+            set_error(child_row, num, error);
+            ++child;
+         }
+         while (child) child = m_model->erase(child);
 
-            // info
-            ErrorChecking::Info info;
-            info.document = doc;
-            info.currentSub = current;
-            info.nextSub = next;
-            info.previousSub = previous;
-            info.tryToFix = false;
+         update_node_label(*node);
+         ++node;
+      }
+   }
 
-            if (checker->execute(info) == false)
-               continue;
+   // Return the error of the checker on the row or NULL.
+   const ErrorCheckingEngine::Error* find_error(unsigned int row, ErrorChecking* checker) {
+      for (const auto& error : m_engine.get_errors(row)) {
+         if (error.checker == checker)
+            return &error;
+      }
+      return nullptr;
+   }
 
-            add_error(row, info, checker);
+   // Add the errors by organizing them by type of error.
+   void fill_by_categories() {
+      for (const auto& checker : m_checker_list) {
+         Gtk::TreeModel::Row row = *(m_model->append());
 
-            ++count_error;
+         for (unsigned int i = 0; i < m_engine.size(); ++i) {
+            for (const auto& error : m_engine.get_errors(i)) {
+               if (error.checker == checker)
+                  add_error(row, m_engine.get_num(i), error);
+            }
          }
 
-         // Update the row label or remove the node if it's empty
+         // Update the node label or delete if it empty
          if (row.children().empty()) {
             m_model->erase(row);
          } else {
-            row[m_column.checker] = NULL;  // do not needs because is sort by subtitles
-            row[m_column.num] = to_string(current.get_num());
+            row[m_column.checker] = checker;
 
             update_node_label(row);
          }
-
-         previous = current;
       }
-
-      set_statusbar_error(count_error);
    }
 
-   // FIXME
-   void try_to_fix_all() {
-      Document* doc = get_document();
-      if (doc == NULL)
-         return;
+   // Add the errors by organizing them by subtitle.
+   void fill_by_subtitle() {
+      for (unsigned int i = 0; i < m_engine.size(); ++i) {
+         const std::vector<ErrorCheckingEngine::Error>& errors = m_engine.get_errors(i);
+         if (errors.empty())
+            continue;
 
-      ErrorCheckingGroup group;
-      for (const auto& c : group) {
-         if (c->get_active())
-            fix_error(c, doc);
-      }
-      refresh();
-   }
+         Gtk::TreeModel::Row row = *(m_model->append());
 
-   // FIXME
-   void fix_row(Gtk::TreeModel::Row& row) {
-      Gtk::TreeIter it = row.children().begin();
-      while (it) {
-         if (fix_selected(it))
-            it = m_model->erase(it);
-         else
-            ++it;
-      }
+         for (const auto& error : errors) add_error(row, m_engine.get_num(i), error);
 
-      // All children have been corrected, the node is no longer useful.
-      if (row.children().empty())
-         m_model->erase(row);
+         row[m_column.checker] = NULL;  // do not needs because is sort by subtitles
+         row[m_column.num] = to_string(m_engine.get_num(i));
+
+         update_node_label(row);
+      }
    }
 
-   // Fix the error with the support of the Command Recorder.
-   bool error_checking_fix(ErrorChecking* checker, ErrorChecking::Info& info) {
-      info.document->start_command(checker->get_label());
+   // Try to fix all the errors of the document in one command.
+   void try_to_fix_all() {
+      m_engine.fix_all(m_checker_list, _("Try To Fix All"));
+   }
 
-      bool res = checker->execute(info);
+   // Try to fix all the errors of the node, a category or a subtitle.
+   // The node is updated in place from the rows checked again by fix_rows.
+   void fix_row(Gtk::TreeModel::Row& row) {
+      ErrorChecking* checker = row[m_column.checker];
 
-      info.document->finish_command();
+      if (checker != nullptr) {  // BY_CATEGORIES
+         std::vector<unsigned int> rows;
+         for (const auto& child : row.children()) rows.push_back(get_row(child));
 
-      return res;
+         m_engine.fix_rows({checker}, rows, checker->get_label());
+      } else {  // BY_SUBTITLES
+         m_engine.fix_rows(m_checker_list, {get_row(row)}, _("Try To Fix All"));
+      }
    }
 
-   // FIXME
-   bool fix_selected(Gtk::TreeIter& iter) {
+   // Try to fix the error of the iter.
+   // The error is updated in place or removed from the rows checked again
+   // by fix_rows, the iter can be no longer valid.
+   void fix_selected(const Gtk::TreeIter& iter) {
       ErrorChecking* checker = (*iter)[m_column.checker];
 
       if (checker == nullptr)
-         return false;
-
-      Document* doc = get_document();
-
-      Glib::ustring num = (*iter)[m_column.num];
-
-      Subtitle current = doc->subtitles().get(utility::string_to_int(num));
-      Subtitle previous = doc->subtitles().get_previous(current);
-      Subtitle next = doc->subtitles().get_next(current);
-
-      // info
-      ErrorChecking::Info info;
-      info.document = doc;
-      info.currentSub = current;
-      info.nextSub = next;
-      info.previousSub = previous;
-      info.tryToFix = true;
+         return;
 
-      return error_checking_fix(checker, info);
+      m_engine.fix_rows({checker}, {get_row(*iter)}, checker->get_label());
    }
 
-   // FIXME
-   unsigned int fix_error(ErrorChecking* checker, Document* doc) {
-      Subtitles subtitles = doc->subtitles();
-
-      unsigned int count = 0;
-      Subtitle current, previous, next;
-      for (current = subtitles.get_first(); current; ++current) {
-         // get next
-         next = current;
-         ++next;
-
-         // info
-         ErrorChecking::Info info;
-         info.document = doc;
-         info.currentSub = current;
-         info.nextSub = next;
-         info.previousSub = previous;
-         info.tryToFix = true;
-
-         if (error_checking_fix(checker, info))
-            ++count;
-
-         previous = current;
-      }
+   // Return the row of the subtitle of the error.
+   unsigned int get_row(const Gtk::TreeModel::Row& row) {
+      return get_num(row) - 1;
+   }
 
-      return count;
+   // Return the num of the subtitle of the error or the node (by subtitles).
+   unsigned int get_num(const Gtk::TreeModel::Row& row) {
+      return utility::string_to_int(Glib::ustring(row[m_column.num]));
    }
 
-   // FIXME
+   // Try to fix the error or the errors of the node.
+   // The node is updated in place from the errors checked again.
    void on_row_activated(const Gtk::TreePath& path, Gtk::TreeViewColumn*) {
-      Gtk::TreeIter it = m_model->get_iter(path);
-
-      Gtk::TreeModel::Row row = *it;
+      Gtk::TreeModel::Row row = *m_model->get_iter(path);
 
       // check if it's not a node
-      if (row.children().empty()) {  // this is an error
-         // If the fix succeeds, we need to remove it.
-         if (fix_selected(it)) {
-            Gtk::TreeModel::Row parent = *row.parent();
-
-            m_model->erase(it);
-
-            if (parent.children().empty())
-               m_model->erase(parent);
-            else
-               update_node_label(parent);
-         }
-      } else {  // this is a node
+      if (row.children().empty())  // this is an error
+         fix_selected(row);
+      else  // this is a node
          fix_row(row);
-      }
    }
 
    // Update the label of the node.
@@ -626,13 +689,87 @@ class DialogErrorChecking : public Gtk::Dialog {
    Gtk::Statusbar* m_statusbar;
 
    ErrorCheckingGroup m_checker_list;
+   ErrorCheckingEngine m_engine;
 
    Glib::RefPtr<Gtk::ActionGroup> m_action_group;
+   sigc::connection m_selection_connection;
 };
 
 // static instance of the dialog
 DialogErrorChecking* DialogErrorChecking::m_static_instance = nullptr;
 
+// Check the active document in background while it's edited, if the option
+// "timing/do-auto-timing-check" is enabled. The errors of each subtitle are
+// kept in the document (SubtitleErrors) as a bitmask, the subtitle view, the
+// waveform and the statusbar read them.
+class ErrorCheckingService {
+  public:
+   ErrorCheckingService() : m_engine(m_checkers) {
+      m_engine.signal_changed().connect(sigc::mem_fun(*this, &ErrorCheckingService::on_errors_changed));
+
+      // The checkers are configured in the group "timing" and enabled in their
+      // own group. get_active() sets the missing key, do it before connecting.
+      m_connections.push_back(cfg::signal_changed("timing").connect(sigc::mem_fun(*this, &ErrorCheckingService::on_config_changed)));
+      for (const auto& checker : m_checkers) {
+         checker->get_active();
+         m_connections.push_back(cfg::signal_changed(checker->get_name()).connect(sigc::mem_fun(*this, &ErrorCheckingService::on_config_changed)));
+      }
+
+      m_connections.push_back(se::documents::signal_active_changed().connect(sigc::mem_fun(*this, &ErrorCheckingService::set_document)));
+
+      set_document(se::documents::active());
+   }
+
+   ~ErrorCheckingService() {
+      for (auto& connection : m_connections) connection.disconnect();
+      set_document(nullptr);
+   }
+
+   // Check the document (or none).
+   // The errors of the previous document are no longer valid.
+   void set_document(Document* doc) {
+      if (m_document != nullptr) {
+         m_engine.set_document(nullptr);
+         m_document->get_subtitle_errors().set_valid(false);
+         m_document->emit_signal("subtitle-errors-changed");
+      }
+
+      m_document = doc;
+
+      if (m_document == nullptr || cfg::get_boolean("timing", "do-auto-timing-check") == false)
+         return;
+
+      m_document->get_subtitle_errors().set_valid(true);
+      m_engine.set_document(m_document);
+      m_engine.check_all();
+   }
+
+  protected:
+   // A value used by the checkers has changed, all the document is checked again.
+   void on_config_changed(const Glib::ustring&, const Glib::ustring&) {
+      m_checkers.init_settings();
+      set_document(m_document);
+   }
+
+   // Copy the errors of the rows checked in the document.
+   void on_errors_changed() {
+      if (m_document == nullptr)
+         return;
+
+      SubtitleErrors& errors = m_document->get_subtitle_errors();
+      errors.resize(m_engine.size());
+      for (unsigned int row : m_engine.get_checked_rows()) errors.set(row, m_engine.get_flags(row));
+
+      m_document->emit_signal("subtitle-errors-changed");
+   }
+
+  protected:
+   ErrorCheckingGroup m_checkers;
+   ErrorCheckingEngine m_engine;
+   Document* m_document{nullptr};
+   std::vector<sigc::connection> m_connections;
+};
+
 // Error Checking Plugin
 class ErrorCheckingPlugin : public Action {
   public:
@@ -662,6 +799,8 @@ class ErrorCheckingPlugin : public Action {
       ui->insert_action_group(action_group);
 
       ui->add_ui(ui_id, "/menubar/menu-tools/checking", "error-checking", "error-checking");
+
+      m_service.reset(new ErrorCheckingService);
    }
 
    void deactivate() {
@@ -675,6 +814,8 @@ class ErrorCheckingPlugin : public Action {
       DialogErrorChecking* dialog = DialogErrorChecking::get_instance();
       if (dialog != nullptr)
          dialog->on_quit();
+
+      m_service.reset();
    }
 
    void update_ui() {
@@ -697,6 +838,47 @@ class ErrorCheckingPlugin : public Action {
   protected:
    Gtk::UIManager::ui_merge_id ui_id;
    Glib::RefPtr<Gtk::ActionGroup> action_group;
+   std::unique_ptr<ErrorCheckingService> m_service;
 };
 
+// Batch step "error-checking[:fix]"
+// The errors of the active checkers are reported on the standard error.
+// With "fix" the automatic corrections are applied first.
+static void batch_error_checking(Document* doc, const std::vector<Glib::ustring>& args) {
+   bool fix = (args.size() == 1 && args[0] == "fix");
+   if (!args.empty() && !fix)
+      throw SubtitleError(_("The only argument of the step error-checking is 'fix'."));
+
+   ErrorCheckingGroup group;
+   Glib::RefPtr<Glib::Regex> markup = Glib::Regex::create("<[^>]*>");
+
+   // The errors are fixed and the remaining errors are found on a snapshot of the document
+   ErrorCheckingEngine engine(group);
+   engine.set_document(doc);
+   engine.check_all();
+
+   if (fix) {
+      engine.fix_all(group, _("Try To Fix All"));
+   }
+
+   for (const auto& checker : group) {
+      for (unsigned int i = 0; i < engine.size(); ++i) {
+         for (const auto& error : engine.get_errors(i)) {
+            if (error.checker != checker)
+               continue;
+            std::cerr << doc->getFilename() << ": " << engine.get_num(i) << ": "
+                      << markup->replace(error.error, 0, "", static_cast<Glib::RegexMatchFlags>(0)) << std::endl;
+         }
+      }
+   }
+}
+
+static void register_batch_steps() {
+   se::batch::register_step("error-checking",
+                            "[fix]",
+                            _("Report the errors of the active checkers, with 'fix' try to correct them first"),
+                            sigc::ptr_fun(&batch_error_checking));
+}
+
 REGISTER_EXTENSION(ErrorCheckingPlugin)
+REGISTER_BATCH_STEPS(register_batch_steps)
@@ -27,6 +27,7 @@ class MaxCharactersPerLine : public ErrorChecking {
    MaxCharactersPerLine()
        : ErrorChecking("max-characters-per-line", _("Maximum Characters per Line"), _("An error is detected if a line is too long.")) {
       m_maxCPL = 40;
+      m_flag = SUBTITLE_ERROR_MAX_CPL;
    }
 
    virtual void init() {
@@ -34,21 +35,16 @@ class MaxCharactersPerLine : public ErrorChecking {
    }
 
    virtual bool execute(Info& info) {
-      std::istringstream iss(info.currentSub.get_characters_per_line_text());
-      std::string line;
-
-      while (std::getline(iss, line)) {
-         int number = utility::string_to_int(line);
-
+      for (int number : info.current->characters_per_line) {
          if (number > m_maxCPL) {
             if (info.tryToFix) {
-               info.currentSub.set_text(word_wrap(info.currentSub.get_text(), m_maxCPL));
+               info.currentSub.set_text(word_wrap(info.current->text, m_maxCPL));
                return true;
             }
 
             info.error = build_message(
                ngettext("Subtitle has a too long line: <b>1 character</b>", "Subtitle has a too long line: <b>%i characters</b>", number), number);
-            info.solution = build_message(_("<b>Automatic correction:</b>\n%s"), word_wrap(info.currentSub.get_text(), m_maxCPL).c_str());
+            info.solution = build_message(_("<b>Automatic correction:</b>\n%s"), word_wrap(info.current->text, m_maxCPL).c_str());
             return true;
          }
       }
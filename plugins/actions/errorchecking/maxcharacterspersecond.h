@@ -32,6 +32,7 @@ class MaxCharactersPerSecond : public ErrorChecking {
                        _("Detects and fixes subtitles when the number of characters per "
                          "second is superior to the specified value.")) {
       m_maxCPS = 25;
+      m_flag = SUBTITLE_ERROR_MAX_CPS;
    }
 
    virtual void init() {
@@ -39,18 +40,17 @@ class MaxCharactersPerSecond : public ErrorChecking {
    }
 
    bool execute(Info& info) {
-      if ((info.currentSub.check_cps_text(0, m_maxCPS) <= 0) || m_maxCPS == 0)
+      if ((info.current->check_cps(0, m_maxCPS) <= 0) || m_maxCPS == 0)
          return false;
 
-      SubtitleTime duration(utility::get_min_duration_msecs(info.currentSub.get_text(), m_maxCPS));
+      SubtitleTime duration(utility::get_min_duration_msecs(info.current->text, m_maxCPS));
 
       if (info.tryToFix) {
          info.currentSub.set_duration(duration);
          return true;
       }
 
-      info.error =
-         build_message(_("There are too many characters per second: <b>%.1f chars/s</b>"), info.currentSub.get_characters_per_second_text());
+      info.error = build_message(_("There are too many characters per second: <b>%.1f chars/s</b>"), info.current->characters_per_second);
 
       info.solution = build_message(_("<b>Automatic correction:</b> change "
                                       "current subtitle duration to %s."),
@@ -27,6 +27,7 @@ class MaxLinePerSubtitle : public ErrorChecking {
    MaxLinePerSubtitle()
        : ErrorChecking("max-line-per-subtitle", _("Maximum Lines per Subtitle"), _("An error is detected if a subtitle has too many lines.")) {
       m_maxLPS = 2;
+      m_flag = SUBTITLE_ERROR_MAX_LINES;
    }
 
    virtual void init() {
@@ -34,13 +35,7 @@ class MaxLinePerSubtitle : public ErrorChecking {
    }
 
    virtual bool execute(Info& info) {
-      std::istringstream iss(info.currentSub.get_characters_per_line_text());
-      std::string line;
-
-      int count = 0;
-      while (std::getline(iss, line)) {
-         ++count;
-      }
+      int count = static_cast<int>(info.current->characters_per_line.size());
 
       if (count <= m_maxLPS)
          return false;
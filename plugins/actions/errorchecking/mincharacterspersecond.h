@@ -32,6 +32,7 @@ class MinCharactersPerSecond : public ErrorChecking {
                        _("Detects and fixes subtitles when the number of characters per "
                          "second is inferior to the specified value.")) {
       m_minCPS = 5;
+      m_flag = SUBTITLE_ERROR_MIN_CPS;
    }
 
    virtual void init() {
@@ -39,17 +40,17 @@ class MinCharactersPerSecond : public ErrorChecking {
    }
 
    bool execute(Info& info) {
-      if ((info.currentSub.check_cps_text(m_minCPS, (m_minCPS + 1)) >= 0) || m_minCPS == 0)
+      if ((info.current->check_cps(m_minCPS, (m_minCPS + 1)) >= 0) || m_minCPS == 0)
          return false;
 
-      SubtitleTime duration(utility::get_min_duration_msecs(info.currentSub.get_text(), m_minCPS));
+      SubtitleTime duration(utility::get_min_duration_msecs(info.current->text, m_minCPS));
 
       if (info.tryToFix) {
          info.currentSub.set_duration(duration);
          return true;
       }
 
-      info.error = build_message(_("There are too few characters per second: <b>%.1f chars/s</b>"), info.currentSub.get_characters_per_second_text());
+      info.error = build_message(_("There are too few characters per second: <b>%.1f chars/s</b>"), info.current->characters_per_second);
 
       info.solution = build_message(_("<b>Automatic correction:</b> change "
                                       "current subtitle duration to %s."),
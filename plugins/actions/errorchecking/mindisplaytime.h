@@ -30,6 +30,7 @@ class MinDisplayTime : public ErrorChecking {
                        _("Detects and fixes subtitles when the duration is "
                          "inferior to the specified value.")) {
       m_min_display = 1000;  // a second
+      m_flag = SUBTITLE_ERROR_MIN_DISPLAY_TIME;
    }
 
    virtual void init() {
@@ -37,12 +38,12 @@ class MinDisplayTime : public ErrorChecking {
    }
 
    bool execute(Info& info) {
-      SubtitleTime duration = info.currentSub.get_duration();
+      SubtitleTime duration = info.current->get_duration();
 
       if (duration.totalmsecs >= m_min_display)
          return false;
 
-      SubtitleTime new_end = info.currentSub.get_start() + SubtitleTime(m_min_display);
+      SubtitleTime new_end = info.current->start + SubtitleTime(m_min_display);
 
       if (info.tryToFix) {
          info.currentSub.set_end(new_end);
@@ -30,6 +30,7 @@ class MinGapBetweenSubtitles : public ErrorChecking {
                        _("Detects and fixes subtitles when the minimum gap "
                          "between subtitles is too short.")) {
       m_minGBS = 100;
+      m_flag = SUBTITLE_ERROR_MIN_GAP;
    }
 
    virtual void init() {
@@ -37,15 +38,15 @@ class MinGapBetweenSubtitles : public ErrorChecking {
    }
 
    bool execute(Info& info) {
-      if (!info.nextSub)
+      if (info.next == nullptr)
          return false;
 
-      long gap = (info.nextSub.get_start() - info.currentSub.get_end()).totalmsecs;
+      long gap = (info.next->start - info.current->end).totalmsecs;
 
       if (gap >= m_minGBS)
          return false;
 
-      long middle = info.currentSub.get_end().totalmsecs + (gap / 2);
+      long middle = info.current->end.totalmsecs + (gap / 2);
       long halfGBS = m_minGBS / 2;
 
       SubtitleTime new_current(middle - halfGBS);
@@ -28,29 +28,36 @@ class Overlapping : public ErrorChecking {
        : ErrorChecking("overlapping",
                        _("Overlapping"),
                        _("An error is detected when the subtitle overlap on "
-                         "next subtitle.")) {
+                         "another subtitle.")) {
+      m_flag = SUBTITLE_ERROR_OVERLAPPING;
    }
 
    virtual void init() {
       // mode = number
    }
 
-   // Check if the currentSub overlap on the next.
+   // Check if the current subtitle overlap on the subtitles after it,
+   // not only the next one (see SubtitleData::overlaps).
    bool execute(Info& info) {
-      if (!info.nextSub)
+      if (info.current->overlaps.empty())
          return false;
 
-      if (info.currentSub.get_end() <= info.nextSub.get_start())
-         return false;
-
-      long overlap = (info.currentSub.get_end() - info.nextSub.get_start()).totalmsecs;
-
       if (info.tryToFix) {
          // not implemented
          return false;
       }
 
-      info.error = build_message(_("Subtitle overlap on next subtitle: <b>%ims overlap</b>"), overlap);
+      Glib::ustring error;
+      for (const auto& overlap : info.current->overlaps) {
+         if (!error.empty())
+            error += "\n";
+
+         if (overlap.first == info.current->num + 1)
+            error += build_message(_("Subtitle overlap on next subtitle: <b>%ims overlap</b>"), static_cast<int>(overlap.second));
+         else
+            error += build_message(_("Subtitle overlap on subtitle n°%d: <b>%ims overlap</b>"), overlap.first, static_cast<int>(overlap.second));
+      }
+      info.error = error;
 
       info.solution =
          _("<b>Automatic correction:</b> unavailable, correct the error "
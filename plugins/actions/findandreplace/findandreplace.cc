@@ -27,7 +27,10 @@
 #include <utility.h>
 #include <widget_config_utility.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 // FIXME: gtkmm3
 // FIXME:
@@ -43,7 +46,6 @@ class MatchInfo {
 
    void reset() {
       text = Glib::ustring();
-      replacement = Glib::ustring();
       column = 0;
       found = false;
       start = len = Glib::ustring::npos;
@@ -52,7 +54,6 @@ class MatchInfo {
   public:
    int column;
    Glib::ustring text;
-   Glib::ustring replacement;
    bool found;
    Glib::ustring::size_type start;
    Glib::ustring::size_type len;
@@ -62,6 +63,232 @@ enum PatternOptions { USE_REGEX = 1 << 1, IGNORE_CASE = 1 << 2 };
 
 enum ColumnOptions { TEXT = 1 << 1, TRANSLATION = 1 << 2 };
 
+// The pattern of a search, compiled once and used on all the subtitles.
+// A regular expression is compiled with REGEX_OPTIMIZE (the JIT of PCRE
+// when it's available). A text is searched with Boyer-Moore-Horspool on the
+// characters, lowercased once by text for a case insensitive search.
+// The offsets are in characters, like Glib::ustring.
+class SearchPattern {
+  public:
+   // Compile the pattern with the options (PatternOptions).
+   // Nothing is done if they are the same as the last time.
+   // Return false if the pattern is empty or invalid.
+   bool compile(const Glib::ustring& pattern, int options) {
+      if (m_compiled_once && pattern == m_pattern && options == m_options)
+         return m_compiled;
+
+      clear();
+      m_pattern = pattern;
+      m_options = options;
+      m_compiled_once = true;
+
+      if (pattern.empty())
+         return false;
+
+      if (options & USE_REGEX) {
+         Glib::RegexCompileFlags compile_flags = Glib::REGEX_OPTIMIZE;
+         if (options & IGNORE_CASE)
+            compile_flags |= Glib::REGEX_CASELESS;
+         try {
+            m_regex = Glib::Regex::create(pattern, compile_flags);
+         } catch (const Glib::Error& ex) {
+            std::cerr << "SearchPattern::compile error: " << ex.what() << std::endl;
+            return false;
+         }
+      } else {
+         to_chars(pattern, m_chars);
+
+         // the shift of the bad character, by the low byte of the characters,
+         // the smallest shift is kept when several characters share it
+         m_shift.assign(256, m_chars.size());
+         for (std::vector<gunichar>::size_type i = 0; i + 1 < m_chars.size(); ++i) m_shift[m_chars[i] & 0xFF] = m_chars.size() - 1 - i;
+      }
+      m_compiled = true;
+      return true;
+   }
+
+   bool is_compiled() const {
+      return m_compiled;
+   }
+
+   // Search the pattern in the text from the character 'from'.
+   // Return true with the character offset and the length of the match.
+   bool find(const Glib::ustring& text, Glib::ustring::size_type from, Glib::ustring::size_type& start, Glib::ustring::size_type& len) {
+      if (!m_compiled)
+         return false;
+
+      if (!m_regex)
+         return find_chars(get_chars(text), from, start, len);
+
+      const gchar* str = text.c_str();
+      const gchar* end = str + text.bytes();
+      const gchar* begin = str;
+      // the offset can be after the text
+      for (Glib::ustring::size_type i = 0; i < from; ++i) {
+         if (begin >= end)
+            return false;
+         begin = g_utf8_next_char(begin);
+      }
+
+      Glib::MatchInfo match_info;
+      if (!m_regex->match(text, text.bytes(), begin - str, match_info))
+         return false;
+
+      int start_pos, end_pos;
+      if (!match_info.fetch_pos(0, start_pos, end_pos))
+         return false;
+
+      // We need to convert the position from the byte position to a
+      // character position.
+      start = from + g_utf8_pointer_to_offset(begin, str + start_pos);
+      len = g_utf8_pointer_to_offset(str + start_pos, str + end_pos);
+      return true;
+   }
+
+   // Expand the references (\0, \1...) of the replacement with the match of
+   // the regular expression at the character 'start' of the text.
+   // Nothing is done without regular expression.
+   void expand_references(const Glib::ustring& text, Glib::ustring::size_type start, Glib::ustring& replacement) {
+      if (!m_regex)
+         return;
+
+      GError* error = NULL;
+      gboolean references = FALSE;
+      if (!g_regex_check_replacement(replacement.c_str(), &references, &error)) {
+         g_error_free(error);
+         return;
+      }
+      if (!references)
+         return;
+
+      const gchar* str = text.c_str();
+      gssize start_pos = g_utf8_offset_to_pointer(str, start) - str;
+
+      Glib::MatchInfo match_info;
+      if (!m_regex->match(text, text.bytes(), start_pos, match_info, Glib::REGEX_MATCH_ANCHORED))
+         return;
+
+      try {
+         replacement = match_info.expand_references(replacement);
+      } catch (const Glib::Error& ex) {  // the replacement is used as it is
+         std::cerr << "SearchPattern::expand_references error: " << ex.what() << std::endl;
+      }
+   }
+
+   // Replace all the matches of the text by the replacement,
+   // the references of a regular expression are expanded.
+   // Return false if there's no match.
+   bool replace_all(Glib::ustring& text, const Glib::ustring& replacement) {
+      if (!m_compiled)
+         return false;
+
+      if (m_regex) {
+         if (!m_regex->match(text))
+            return false;
+
+         try {
+            text = m_regex->replace(text, 0, replacement, Glib::RegexMatchFlags(0));
+         } catch (const Glib::Error&) {  // invalid references, the replacement is used as it is
+            text = m_regex->replace_literal(text, 0, replacement, Glib::RegexMatchFlags(0));
+         }
+         return true;
+      }
+
+      // the matches are copied with the text between them, without substrings
+      const std::vector<gunichar>& chars = get_chars(text);
+      const gchar* str = text.c_str();
+      const gchar* copied = str;
+
+      std::string result;
+      Glib::ustring::size_type from = 0, start, len;
+      while (find_chars(chars, from, start, len)) {
+         const gchar* match = g_utf8_offset_to_pointer(copied, start - from);
+         result.append(copied, match - copied);
+         result.append(replacement.raw());
+
+         copied = g_utf8_offset_to_pointer(match, len);
+         from = start + len;
+      }
+      if (copied == str)
+         return false;
+
+      result.append(copied);
+      text = result;
+      return true;
+   }
+
+  protected:
+   void clear() {
+      m_regex.reset();
+      m_compiled = false;
+      m_chars.clear();
+      m_shift.clear();
+      m_text.clear();
+      m_text_chars.clear();
+   }
+
+   // Decode the characters of the text, lowercased for a case insensitive search.
+   void to_chars(const Glib::ustring& text, std::vector<gunichar>& chars) const {
+      const bool lower = (m_options & IGNORE_CASE);
+
+      chars.clear();
+      const gchar* end = text.c_str() + text.bytes();
+      for (const gchar* p = text.c_str(); p < end; p = g_utf8_next_char(p)) {
+         gunichar c = g_utf8_get_char(p);
+         chars.push_back(lower ? g_unichar_tolower(c) : c);
+      }
+   }
+
+   // The characters of the text, the last text is kept because the next
+   // matches of a subtitle are searched in the same text.
+   const std::vector<gunichar>& get_chars(const Glib::ustring& text) {
+      if (text.raw() != m_text) {
+         m_text = text.raw();
+         to_chars(text, m_text_chars);
+      }
+      return m_text_chars;
+   }
+
+   // Boyer-Moore-Horspool, compare the last character of the pattern
+   // and shift by the character of the text under it.
+   bool find_chars(const std::vector<gunichar>& chars,
+                   Glib::ustring::size_type from,
+                   Glib::ustring::size_type& start,
+                   Glib::ustring::size_type& len) const {
+      const Glib::ustring::size_type size = m_chars.size();
+      if (size == 0)
+         return false;
+
+      for (Glib::ustring::size_type pos = from; pos + size <= chars.size();) {
+         gunichar last = chars[pos + size - 1];
+         if (last == m_chars[size - 1] && std::equal(m_chars.begin(), m_chars.end() - 1, chars.begin() + pos)) {
+            start = pos;
+            len = size;
+            return true;
+         }
+         pos += m_shift[last & 0xFF];
+      }
+      return false;
+   }
+
+  protected:
+   Glib::ustring m_pattern;
+   int m_options{0};
+   bool m_compiled_once{false};
+   bool m_compiled{false};
+
+   // shared by the copies, a compiled regex isn't modified
+   Glib::RefPtr<Glib::Regex> m_regex;
+
+   // the characters of the pattern and the shifts of Boyer-Moore-Horspool
+   std::vector<gunichar> m_chars;
+   std::vector<std::vector<gunichar>::size_type> m_shift;
+
+   // the last text searched and its characters
+   std::string m_text;
+   std::vector<gunichar> m_text_chars;
+};
+
 // FaR Find and Replace
 class FaR {
   public:
@@ -107,24 +334,32 @@ class FaR {
       return cfg::get_string("find-and-replace", "replacement");
    }
 
+   // Read the options of the search and compile the pattern, call it once
+   // before searching in the subtitles. The pattern is only compiled again
+   // when it or its options have changed.
+   // Return false if there's nothing to search.
+   bool prepare() {
+      m_columns = get_columns_options();
+      return m_pattern.compile(get_pattern(), get_pattern_options());
+   }
+
    // Try to find the pattern in the subtitle.
    // A MatchInfo is used to get information on the match,
    // is stored in matchinfo if not NULL.
    bool find_in_subtitle(const Subtitle& sub, MatchInfo* matchinfo) {
-      if (!sub)
+      if (!sub || !m_pattern.is_compiled())
          return false;
 
-      int columns_options = get_columns_options();
       int current_column = (matchinfo) ? matchinfo->column : 0;
 
-      if (columns_options & TEXT && current_column <= TEXT) {
+      if (m_columns & TEXT && current_column <= TEXT) {
          if (find_in_text(sub.get_text(), matchinfo)) {
             if (matchinfo)
                matchinfo->column = TEXT;
             return true;
          }
       }
-      if (columns_options & TRANSLATION && current_column <= TRANSLATION) {
+      if (m_columns & TRANSLATION && current_column <= TRANSLATION) {
          if (find_in_text(sub.get_translation(), matchinfo)) {
             if (matchinfo)
                matchinfo->column = TRANSLATION;
@@ -152,6 +387,8 @@ class FaR {
       Glib::ustring text = info.text;
       Glib::ustring replacement = get_replacement();
 
+      m_pattern.expand_references(info.text, info.start, replacement);
+
       try {
          text.replace(info.start, info.len, replacement);
       } catch (const std::exception& ex) {
@@ -173,122 +410,78 @@ class FaR {
       return true;
    }
 
-  protected:
-   bool find_in_text(const Glib::ustring& otext, MatchInfo* info) {
-      Glib::ustring text = otext;
-      Glib::ustring::size_type beginning = Glib::ustring::npos;
+   // Replace all the matches in the subtitles of the document,
+   // it's recorded in one command.
+   // Return the subtitles modified.
+   std::vector<Subtitle> replace_all(Document& doc) {
+      std::vector<Subtitle> modified;
 
-      try {
-         if (info) {
-            if (info->start != Glib::ustring::npos && info->len != Glib::ustring::npos)
-               beginning = info->start + info->len;
-            // We reset some values
-            info->start = info->len = Glib::ustring::npos;
-            info->found = false;
-            info->text = Glib::ustring();
-         }
+      if (!m_pattern.is_compiled())
+         return modified;
 
-         if (beginning != Glib::ustring::npos)
-            text = text.substr(beginning, text.size());
+      Glib::ustring replacement = get_replacement();
 
-         if (!find(get_pattern(), get_pattern_options(), text, info))
-            return false;
+      for (Subtitle sub = doc.subtitles().get_first(); sub; ++sub) {
+         Glib::ustring text, translation;
+         bool text_replaced = false, translation_replaced = false;
 
-         if (info) {                      // Found, update matchinfo values
-            info->text = otext;
-            if (beginning != Glib::ustring::npos)
-               info->start += beginning;  // if we used a substring (start != 0)n we
-                                          // need to update the beginning
+         if (m_columns & TEXT) {
+            text = sub.get_text();
+            text_replaced = m_pattern.replace_all(text, replacement);
          }
-         return true;
-      } catch (std::exception& ex) {
-         std::cerr << "# Exception: " << ex.what() << std::endl;
-      }
-      return false;
-   }
+         if (m_columns & TRANSLATION) {
+            translation = sub.get_translation();
+            translation_replaced = m_pattern.replace_all(translation, replacement);
+         }
+         if (!text_replaced && !translation_replaced)
+            continue;
 
-   bool find(const Glib::ustring& pattern, int pattern_options, const Glib::ustring& text, MatchInfo* info) {
-      if (pattern.empty())
-         return false;
+         if (modified.empty())
+            doc.start_command(_("Replace All"));
 
-      bool found = false;
-      Glib::ustring::size_type start, len;
+         if (text_replaced)
+            sub.set_text(text);
+         if (translation_replaced)
+            sub.set_translation(translation);
 
-      if (pattern_options & USE_REGEX) {  // Search with regular expression
-         found = regex_exec(pattern, text, (pattern_options & IGNORE_CASE), start, len, info->replacement);
-      } else {                            // Without regular expression
-         Glib::ustring pat = (pattern_options & IGNORE_CASE) ? pattern.lowercase() : pattern;
-         Glib::ustring txt = (pattern_options & IGNORE_CASE) ? text.lowercase() : text;
-
-         Glib::ustring::size_type res = txt.find(pat);
-         if (res != Glib::ustring::npos) {
-            found = true;
-            start = res;
-            len = pattern.size();
-         }
+         modified.push_back(sub);
       }
 
-      if (found && info) {
-         info->found = true;
-         info->start = start;
-         info->len = len;
-      }
-      return found;
+      if (!modified.empty())
+         doc.finish_command();
+      return modified;
    }
 
-   // FIXME: Remove Me
-   // Waiting the Glib::MatchInfo API in glibmm.
-   bool regex_exec(const Glib::ustring& pattern,
-                   const Glib::ustring& string,
-                   bool caseless,
-                   Glib::ustring::size_type& start,
-                   Glib::ustring::size_type& len,
-                   Glib::ustring& replacement) {
-      bool found = false;
-      GRegex* regex = NULL;
-      GMatchInfo* match_info = NULL;
-      GError* error = NULL;
-      gboolean references = FALSE;
-
-      int compile_flags = (GRegexMatchFlags)0;
-      if (caseless)
-         compile_flags |= G_REGEX_CASELESS;
-      regex = g_regex_new(pattern.c_str(), (GRegexCompileFlags)compile_flags, (GRegexMatchFlags)0, &error);
-      if (error != NULL) {
-         std::cerr << "regex_exec error: " << error->message << std::endl;
-         g_error_free(error);
-         return false;
+  protected:
+   bool find_in_text(const Glib::ustring& text, MatchInfo* info) {
+      Glib::ustring::size_type beginning = 0;
+
+      if (info) {
+         // search after the last match
+         if (info->start != Glib::ustring::npos && info->len != Glib::ustring::npos)
+            beginning = info->start + info->len;
+         // We reset some values
+         info->start = info->len = Glib::ustring::npos;
+         info->found = false;
+         info->text = Glib::ustring();
       }
 
-      if (g_regex_match(regex, string.c_str(), (GRegexMatchFlags)0, &match_info)) {
-         if (g_match_info_matches(match_info)) {
-            int start_pos, end_pos;
-            // check the return
-            if (g_match_info_fetch_pos(match_info,
-                                       0,  // match_num 0 is full text of the match
-                                       &start_pos,
-                                       &end_pos)) {
-               // We need to convert the position from the byte position to a
-               // character position.
-               start_pos = g_utf8_pointer_to_offset(string.c_str(), string.c_str() + start_pos);
-               end_pos = g_utf8_pointer_to_offset(string.c_str(), string.c_str() + end_pos);
-
-               start = start_pos;
-               len = end_pos - start_pos;
-               found = true;
-            }
+      Glib::ustring::size_type start, len;
+      if (!m_pattern.find(text, beginning, start, len))
+         return false;
 
-            // Expand any references in the replacement string
-            references = TRUE;
-            g_regex_check_replacement(replacement.c_str(), &references, &error);
-            if (error == NULL && references)
-               replacement = g_match_info_expand_references(match_info, replacement.c_str(), &error);
-         }
+      if (info) {  // Found, update matchinfo values
+         info->found = true;
+         info->start = start;
+         info->len = len;
+         info->text = text;
       }
-      g_match_info_free(match_info);
-      g_regex_unref(regex);
-      return found;
+      return true;
    }
+
+  protected:
+   SearchPattern m_pattern;
+   int m_columns{0};
 };
 
 class ComboBoxEntryHistory : public Gtk::ComboBoxText {
@@ -535,6 +728,10 @@ class DialogFindAndReplace : public DialogActionMultiDoc {
    // Response handler for signals:
    // FIND, REPLACE, REPLACE_ALL and (RESPONSE_CLOSE & RESPONSE_DELETE_EVENT)
    void on_response(int response) {
+      // the pattern is compiled once for the search
+      if (response == FIND || response == REPLACE || response == REPLACE_ALL)
+         FaR::instance().prepare();
+
       if (response == FIND) {
          if (find_forwards(m_subtitle, &m_info)) {
             m_document->subtitles().select(m_subtitle);
@@ -576,26 +773,18 @@ class DialogFindAndReplace : public DialogActionMultiDoc {
    }
 
    // Find the next pattern from the current subtitle and the current info.
-   // Recrusive function.
    bool find_forwards(Subtitle& sub, MatchInfo* info) {
       se_dbg(SE_DBG_SEARCH);
 
-      if (!sub)
-         return false;
-
-      // search again in the subtitle
-      if (FaR::instance().find_in_subtitle(sub, info))
-         return true;
-
-      if (info)
-         info->reset();
-
-      ++sub;  // next subtitle
-
-      if (!sub)
-         return false;
+      for (; sub; ++sub) {
+         // search again in the subtitle, then in the next ones
+         if (FaR::instance().find_in_subtitle(sub, info))
+            return true;
 
-      return find_forwards(sub, info);
+         if (info)
+            info->reset();
+      }
+      return false;
    }
 
    // Start with the beginning of all documents and try to replace all.
@@ -609,18 +798,13 @@ class DialogFindAndReplace : public DialogActionMultiDoc {
 
       for (const auto& doc : docs) {
          set_current_document(doc);
-         // List of the modified subtitles
-         std::list<Subtitle> selection;
 
-         m_subtitle = m_document->subtitles().get_first();
+         // All the matches are replaced in one command
+         std::vector<Subtitle> selection = FaR::instance().replace_all(*m_document);
+
+         m_subtitle = Subtitle();
          m_info.reset();
 
-         while (m_subtitle) {
-            while (find_forwards(m_subtitle, &m_info)) {
-               if (FaR::instance().replace(*m_document, m_subtitle, m_info))
-                  selection.push_back(m_subtitle);
-            }
-         }
          // We select the modified subtitles
          m_document->subtitles().select(selection);
       }
@@ -821,6 +1005,8 @@ class FindAndReplacePlugin : public Action {
          return;
       }
 
+      FaR::instance().prepare();
+
       Subtitle sub;
       if (search_from_current_position(sub, backwards) || search_from_beginning(sub, backwards)) {
          subtitles.select(sub);
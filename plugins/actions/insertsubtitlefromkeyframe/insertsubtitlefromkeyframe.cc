@@ -148,18 +148,18 @@ class InsertSubtitleFromKeyframePlugin : public Action {
 
       long pos = player()->get_position();
 
-      auto prev = keyframes->begin();
-      for (auto it = keyframes->begin(); it != keyframes->end(); ++it) {
-         if (*it > pos) {
-            if (*it != *prev) {
-               start = *prev;
-               end = *it;
-               return true;
-            }
-         }
-         prev = it;
-      }
-      return false;
+      // the first keyframe after the position which has a different previous one
+      auto it = keyframes->upper_bound(pos);
+      if (it == keyframes->begin() && it != keyframes->end())
+         ++it;
+      while (it != keyframes->end() && *it == *(it - 1)) ++it;
+
+      if (it == keyframes->end())
+         return false;
+
+      start = *(it - 1);
+      end = *it;
+      return true;
    }
 
    void on_insert_subtitle_between_each_keyframes() {
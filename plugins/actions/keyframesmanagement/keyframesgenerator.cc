@@ -20,35 +20,71 @@
 
 #include <gtkmm.h>
 #include <keyframes.h>
+#include <subtitleeditorwindow.h>
 #include <utility.h>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 
 #include "mediadecoder.h"
 
-class KeyframesGenerator : public Gtk::Dialog, public MediaDecoder {
+// Read the keyframes of the media.
+// The progress and the end of the work are displayed by the subclass,
+// in a dialog (DialogKeyframesGenerator) or in the statusbar
+// (KeyframesBackgroundGenerator).
+class KeyframesGenerator : public MediaDecoder {
   public:
-   KeyframesGenerator(const Glib::ustring& uri, Glib::RefPtr<KeyFrames>& keyframes) : Gtk::Dialog(_("Generate Keyframes"), true), MediaDecoder(1000) {
-      set_border_width(12);
-      set_default_size(300, -1);
-      get_vbox()->pack_start(m_progressbar, false, false);
-      add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
-      m_progressbar.set_show_text(true);
-      m_progressbar.set_text(_("Waiting..."));
-      show_all();
+   KeyframesGenerator() : MediaDecoder(1000) {
+   }
 
-      try {
-         create_pipeline(uri);
+   // Called with the position and the duration of the stream.
+   virtual void on_progress(gint64 pos, gint64 len) = 0;
 
-         if (run() == Gtk::RESPONSE_OK) {
-            keyframes = Glib::RefPtr<KeyFrames>(new KeyFrames);
-            keyframes->insert(keyframes->end(), m_values.begin(), m_values.end());
-            keyframes->set_video_uri(uri);
-         }
-      } catch (const std::runtime_error& ex) {
-         std::cerr << ex.what() << std::endl;
-      }
+   // Called when the work is finished or cancelled.
+   virtual void on_done(bool finished) = 0;
+
+   // The keyframes are read from the flags of the parsed stream,
+   // the video is decoded only if the stream can't be parsed
+   // or if the parser doesn't flag the delta units (see need_decoder).
+   // Return false if the pipeline can't be created.
+   bool start(const Glib::ustring& uri) {
+      m_demux_only = create_pipeline(uri, "parsebin");
+      return m_demux_only || create_pipeline(uri);
+   }
+
+   // Return true if the work with the parser is over ('finished' or not)
+   // and the keyframes must be read again with the decoder.
+   // Some parsers never set the delta flag, every frame looks like a keyframe.
+   // Only the decoder knows the keyframes of these streams.
+   bool need_decoder(bool finished) {
+      bool no_delta = finished && m_n_delta == 0 && m_values.size() > 1;
+      return m_demux_only && (m_demux_failed || (finished && m_values.empty()) || no_delta);
+   }
+
+   // Read the keyframes again, with the decoder.
+   // Return false if the pipeline can't be created.
+   bool restart_with_decoder(const Glib::ustring& uri) {
+      se_dbg_msg(SE_DBG_PLUGINS, "demux only failed, fallback to the decoder");
+
+      // stop the streaming thread before clearing the values
+      destroy_pipeline();
+      m_demux_only = false;
+      m_values.clear();
+      m_n_delta = 0;
+      return create_pipeline(uri);
+   }
+
+   // Build the keyframes of the media from the values, the work must be finished.
+   Glib::RefPtr<KeyFrames> create_keyframes(const Glib::ustring& uri) {
+      Glib::RefPtr<KeyFrames> keyframes(new KeyFrames);
+      keyframes->insert(keyframes->end(), m_values.begin(), m_values.end());
+      // the lookups need sorted keyframes, the stream order isn't always the time order
+      std::sort(keyframes->begin(), keyframes->end());
+      keyframes->set_video_uri(uri);
+      keyframes->set_media_hash(utility::compute_media_hash(uri));
+      return keyframes;
    }
 
    static void static_handoff_callback(GstElement* fakesink, GstBuffer* buffer, GstPad* pad, gpointer data) {
@@ -56,9 +92,15 @@ class KeyframesGenerator : public Gtk::Dialog, public MediaDecoder {
       kfg->on_video_identity_handoff(fakesink, buffer, pad);
    }
    // Check buffer and try to catch keyframes.
+   // A parsed buffer can have only a decoding timestamp.
    void on_video_identity_handoff(GstElement*, GstBuffer* buf, GstPad*) {
-      if (!GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
-         long pos = GST_BUFFER_PTS(buf) / GST_MSECOND;
+      if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+         ++m_n_delta;
+      } else {
+         GstClockTime time = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf) : GST_BUFFER_DTS(buf);
+         if (!GST_CLOCK_TIME_IS_VALID(time))
+            return;
+         long pos = time / GST_MSECOND;
          m_values.push_back(pos);
       }
    }
@@ -83,19 +125,14 @@ class KeyframesGenerator : public Gtk::Dialog, public MediaDecoder {
       return fakesink;
    }
 
-   // Update the progress bar
+   // Update the progress
    bool on_timeout() {
       if (!m_pipeline)
          return false;
 
       gint64 pos = 0, len = 0;
       if (gst_element_query_position(m_pipeline, GST_FORMAT_TIME, &pos) && gst_element_query_duration(m_pipeline, GST_FORMAT_TIME, &len)) {
-         double percent = static_cast<double>(pos) / static_cast<double>(len);
-
-         percent = CLAMP(percent, 0.0, 1.0);
-
-         m_progressbar.set_fraction(percent);
-         m_progressbar.set_text(time_to_string(pos) + " / " + time_to_string(len));
+         on_progress(pos, len);
          m_duration = len;
 
          return pos != len;
@@ -104,22 +141,146 @@ class KeyframesGenerator : public Gtk::Dialog, public MediaDecoder {
    }
 
    void on_work_finished() {
-      response(Gtk::RESPONSE_OK);
+      on_done(true);
    }
 
    void on_work_cancel() {
-      response(Gtk::RESPONSE_CANCEL);
+      on_done(false);
+   }
+
+   // An error with the parsebin isn't reported, the decoder is tried next.
+   bool on_bus_message_error(GstMessage* msg) {
+      if (!m_demux_only)
+         return MediaDecoder::on_bus_message_error(msg);
+
+      m_missing_plugins.clear();
+      m_demux_failed = true;
+      on_work_cancel();
+      return true;
    }
 
   protected:
-   Gtk::ProgressBar m_progressbar;
+   bool m_demux_only{false};
+   bool m_demux_failed{false};
 
    std::list<long> m_values;
+   // number of buffers which are not keyframes
+   guint64 m_n_delta{0};
    guint64 m_duration;
 };
 
+// Read the keyframes in a modal dialog, the user can cancel it.
+class DialogKeyframesGenerator : public Gtk::Dialog, public KeyframesGenerator {
+  public:
+   DialogKeyframesGenerator(const Glib::ustring& uri, Glib::RefPtr<KeyFrames>& keyframes) : Gtk::Dialog(_("Generate Keyframes"), true) {
+      set_border_width(12);
+      set_default_size(300, -1);
+      get_vbox()->pack_start(m_progressbar, false, false);
+      add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+      m_progressbar.set_show_text(true);
+      m_progressbar.set_text(_("Waiting..."));
+      show_all();
+
+      try {
+         start(uri);
+
+         int response = run();
+         if (need_decoder(response == Gtk::RESPONSE_OK)) {
+            restart_with_decoder(uri);
+            response = run();
+         }
+
+         if (response == Gtk::RESPONSE_OK)
+            keyframes = create_keyframes(uri);
+      } catch (const std::runtime_error& ex) {
+         std::cerr << ex.what() << std::endl;
+      }
+   }
+
+   void on_progress(gint64 pos, gint64 len) {
+      double percent = static_cast<double>(pos) / static_cast<double>(len);
+
+      percent = CLAMP(percent, 0.0, 1.0);
+
+      m_progressbar.set_fraction(percent);
+      m_progressbar.set_text(time_to_string(pos) + " / " + time_to_string(len));
+   }
+
+   void on_done(bool finished) {
+      response(finished ? Gtk::RESPONSE_OK : Gtk::RESPONSE_CANCEL);
+   }
+
+  protected:
+   Gtk::ProgressBar m_progressbar;
+};
+
+// Read the keyframes without blocking the user, the progress is
+// displayed in the statusbar of the window.
+class KeyframesBackgroundGenerator : public KeyframesGenerator {
+  public:
+   KeyframesBackgroundGenerator(const Glib::ustring& uri, const sigc::slot<void, Glib::RefPtr<KeyFrames>>& slot_done)
+       : m_uri(uri), m_slot_done(slot_done) {
+      m_statusbar = SubtitleEditorWindow::get_instance()->get_statusbar();
+      m_context_id = m_statusbar->get_context_id("keyframes-generator");
+
+      if (start(uri))
+         set_status(_("Generating the keyframes..."));
+      else
+         on_done(false);
+   }
+
+   ~KeyframesBackgroundGenerator() {
+      // the streaming thread must be stopped before the values are released
+      destroy_pipeline();
+      set_status(Glib::ustring());
+   }
+
+   void on_progress(gint64 pos, gint64 len) {
+      int percent = (len > 0) ? static_cast<int>(CLAMP(100.0 * pos / len, 0.0, 100.0)) : 0;
+      set_status(build_message(_("Generating the keyframes... %d%%"), percent));
+   }
+
+   // The slot can't release the generator, it's called from the bus watch.
+   void on_done(bool finished) {
+      if (need_decoder(finished)) {
+         if (restart_with_decoder(m_uri))
+            return;
+         finished = false;
+      }
+
+      Glib::RefPtr<KeyFrames> keyframes;
+      if (finished)
+         keyframes = create_keyframes(m_uri);
+
+      destroy_pipeline();
+      set_status(Glib::ustring());
+      m_slot_done(keyframes);
+   }
+
+  protected:
+   // Replace the message of the generator in the statusbar, an empty text removes it.
+   // Only this message is removed, another generator can use the same context.
+   void set_status(const Glib::ustring& text) {
+      if (m_message_id != 0)
+         m_statusbar->remove_message(m_message_id, m_context_id);
+      m_message_id = text.empty() ? 0 : m_statusbar->push(text, m_context_id);
+   }
+
+  protected:
+   Glib::ustring m_uri;
+   sigc::slot<void, Glib::RefPtr<KeyFrames>> m_slot_done;
+   Gtk::Statusbar* m_statusbar{nullptr};
+   guint m_context_id{0};
+   guint m_message_id{0};
+};
+
 Glib::RefPtr<KeyFrames> generate_keyframes_from_file(const Glib::ustring& uri) {
    Glib::RefPtr<KeyFrames> kf;
-   KeyframesGenerator ui(uri, kf);
+   DialogKeyframesGenerator ui(uri, kf);
    return kf;
 }
+
+std::unique_ptr<MediaDecoder> generate_keyframes_in_background(const Glib::ustring& uri,
+                                                               const sigc::slot<void, Glib::RefPtr<KeyFrames>>& slot_done) {
+   return std::unique_ptr<MediaDecoder>(new KeyframesBackgroundGenerator(uri, slot_done));
+}
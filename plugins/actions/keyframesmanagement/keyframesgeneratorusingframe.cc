@@ -23,6 +23,11 @@
 #include <keyframes.h>
 #include <utility.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
@@ -31,7 +36,7 @@
 class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
   public:
    KeyframesGeneratorUsingFrame(const Glib::ustring& uri, Glib::RefPtr<KeyFrames>& keyframes)
-       : Gtk::Dialog(_("Generate Keyframes"), true), MediaDecoder(1000), m_duration(0), m_prev_frame_size(0), m_prev_frame(NULL), m_difference(0.2f) {
+       : Gtk::Dialog(_("Generate Keyframes"), true), MediaDecoder(1000), m_duration(0), m_prev_frame(NULL), m_difference(0.2f) {
       set_border_width(12);
       set_default_size(300, -1);
       get_vbox()->pack_start(m_progressbar, false, false);
@@ -47,7 +52,10 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
          if (run() == Gtk::RESPONSE_OK) {
             keyframes = Glib::RefPtr<KeyFrames>(new KeyFrames);
             keyframes->insert(keyframes->end(), m_values.begin(), m_values.end());
+            // the lookups need sorted keyframes, the stream order isn't always the time order
+            std::sort(keyframes->begin(), keyframes->end());
             keyframes->set_video_uri(uri);
+            keyframes->set_media_hash(utility::compute_media_hash(uri));
          }
       } catch (const std::runtime_error& ex) {
          std::cerr << ex.what() << std::endl;
@@ -55,7 +63,10 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
    }
 
    ~KeyframesGeneratorUsingFrame(void) {
-      delete[] m_prev_frame;
+      // the streaming thread must be stopped before releasing the frame
+      destroy_pipeline();
+      if (m_prev_frame)
+         gst_buffer_unref(m_prev_frame);
    }
 
    void read_config() {
@@ -72,69 +83,97 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
    }
 
    // Check buffer and try to catch keyframes.
+   // The buffers are small grey thumbnails (see create_element), the
+   // previous one is kept by reference, it's never copied.
    void on_video_identity_handoff(GstElement*, GstBuffer* buf, GstPad*) {
       GstMapInfo map;
-      gst_buffer_map(GST_BUFFER(buf), &map, GST_MAP_READ);
+      if (!gst_buffer_map(buf, &map, GST_MAP_READ))
+         return;
 
-      // first frame or change of buffer size, alloc & push
-      if (!m_prev_frame || map.size != m_prev_frame_size) {
-         delete[] m_prev_frame;
-         m_prev_frame_size = map.size;
-         m_prev_frame = new guint8[m_prev_frame_size];
+      bool scene_cut = true;  // the first frame or a change of size
 
-         m_values.push_back(GST_BUFFER_PTS(buf) / GST_MSECOND);
-      } else if (compare_frame(m_prev_frame, map.data, map.size)) {
-         m_values.push_back(GST_BUFFER_PTS(buf) / GST_MSECOND);
+      if (m_prev_frame) {
+         GstMapInfo prev_map;
+         if (gst_buffer_map(m_prev_frame, &prev_map, GST_MAP_READ)) {
+            if (prev_map.size == map.size)
+               scene_cut = compare_frame(prev_map.data, map.data, map.size);
+            gst_buffer_unmap(m_prev_frame, &prev_map);
+         }
+         gst_buffer_unref(m_prev_frame);
       }
-      // update the previous frame with this one
-      memcpy(m_prev_frame, map.data, map.size);
 
-      gst_buffer_unmap(GST_BUFFER(buf), &map);
+      gst_buffer_unmap(buf, &map);
+
+      if (scene_cut)
+         m_values.push_back(GST_BUFFER_PTS(buf) / GST_MSECOND);
+
+      // this frame becomes the previous one
+      m_prev_frame = gst_buffer_ref(buf);
    }
 
-   bool compare_frame(const guint8* old_frame, const guint8* new_frame, gsize size) {
-      guint64 delta = 0;
-      guint64 full = size / 3;
-
-      gulong diff, i, j;
-      long tmp;
-      // calculate difference between frames
-      for (i = 0; i < full; ++i) {
-         diff = 0;
-         // get max difference in individual color channels
-         for (j = 0; j < 3; ++j) {
-            tmp = (int)new_frame[3 * i + j] - (int)old_frame[3 * i + j];
-            if (tmp < 0)
-               tmp = -tmp;
-            diff = tmp > diff ? tmp : diff;
-         }
-         // add max color diff to total delta
-         delta += diff;
+   // Sum of the absolute differences of two frames.
+   static guint64 sum_of_absolute_differences(const guint8* a, const guint8* b, gsize size) {
+      guint64 sad = 0;
+      gsize i = 0;
+#ifdef __SSE2__
+      __m128i acc = _mm_setzero_si128();
+      for (; i + 16 <= size; i += 16) {
+         __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+         __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+         acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
       }
-      full *= 255;
+      guint64 lanes[2];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+      sad = lanes[0] + lanes[1];
+#endif
+      for (; i < size; ++i) sad += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+      return sad;
+   }
+
+   bool compare_frame(const guint8* old_frame, const guint8* new_frame, gsize size) {
+      if (size == 0)
+         return false;
+
+      guint64 delta = sum_of_absolute_differences(old_frame, new_frame, size);
+      guint64 full = size * 255;
 
       // >20% difference => scene cut
       return ((double)delta / (double)full > m_difference);
    }
 
    // Create video bin
+   // The frames are converted to a small grey thumbnail, the luma is enough
+   // to detect a scene cut and it doesn't depend on the resolution of the video.
+   // The queue moves the scaling and the comparison off the decoder thread.
    GstElement* create_element(const Glib::ustring& structure_name) {
       // We only need and want create the video sink
       if (structure_name.find("video") == Glib::ustring::npos)
          return nullptr;
 
-      GstElement* fakesink = gst_element_factory_make("fakesink", NULL);
+      GError* error = nullptr;
+      GstElement* videobin = gst_parse_bin_from_description(
+         "queue ! videoconvert ! videoscale add-borders=false ! video/x-raw,format=GRAY8,width=160,height=90 ! fakesink name=vsink",
+         true,
+         &error);
+      if (error) {
+         std::cerr << "Could not create the video bin: " << error->message << std::endl;
+         g_clear_error(&error);
+         return nullptr;
+      }
+
+      GstElement* fakesink = gst_bin_get_by_name(GST_BIN(videobin), "vsink");
       // fakesink->set_sync(false);
       g_object_set(G_OBJECT(fakesink), "silent", TRUE, NULL);
       g_object_set(G_OBJECT(fakesink), "signal-handoffs", TRUE, NULL);
       g_signal_connect(fakesink, "handoff", G_CALLBACK(KeyframesGeneratorUsingFrame::static_handoff_callback), this);
+      gst_object_unref(fakesink);
 
       // Set the new sink tp READY as well
-      GstStateChangeReturn retst = gst_element_set_state(fakesink, GST_STATE_READY);
+      GstStateChangeReturn retst = gst_element_set_state(videobin, GST_STATE_READY);
       if (retst == GST_STATE_CHANGE_FAILURE)
          std::cerr << "Could not change state of new sink: " << retst << std::endl;
 
-      return fakesink;
+      return videobin;
    }
 
    // Update the progress bar
@@ -170,8 +209,7 @@ class KeyframesGeneratorUsingFrame : public Gtk::Dialog, public MediaDecoder {
 
    std::list<long> m_values;
    guint64 m_duration;
-   guint64 m_prev_frame_size;
-   guint8* m_prev_frame;
+   GstBuffer* m_prev_frame;
    gfloat m_difference;
 };
 
@@ -21,11 +21,19 @@
 #include <extension/action.h>
 #include <gui/dialogfilechooser.h>
 #include <keyframes.h>
+#include <mediacache.h>
 #include <player.h>
 #include <utility.h>
 
+#include <memory>
+#include <set>
+
+#include "mediadecoder.h"
+
 // declared in keyframesgenerator.cc
 Glib::RefPtr<KeyFrames> generate_keyframes_from_file(const Glib::ustring& uri);
+std::unique_ptr<MediaDecoder> generate_keyframes_in_background(const Glib::ustring& uri,
+                                                               const sigc::slot<void, Glib::RefPtr<KeyFrames>>& slot_done);
 Glib::RefPtr<KeyFrames> generate_keyframes_from_file_using_frame(const Glib::ustring& uri);
 
 class KeyframesManagementPlugin : public Action {
@@ -36,6 +44,8 @@ class KeyframesManagementPlugin : public Action {
    }
 
    ~KeyframesManagementPlugin() {
+      m_load_from_cache_connection.disconnect();
+      m_generator.reset();
       deactivate();
    }
 
@@ -174,6 +184,11 @@ class KeyframesManagementPlugin : public Action {
          update_ui();
       else if (msg == Player::KEYFRAME_CHANGED)
          on_keyframes_changed();
+
+      // not from the player message, the cache is read from the disk
+      if (msg == Player::STREAM_READY && !m_load_from_cache_connection.connected())
+         m_load_from_cache_connection =
+            Glib::signal_idle().connect(sigc::mem_fun(*this, &KeyframesManagementPlugin::on_load_keyframes_of_player_file));
    }
 
    void on_keyframes_changed() {
@@ -185,7 +200,8 @@ class KeyframesManagementPlugin : public Action {
          // When waveform is first created, there is a wf object and the condition
          // evaluates to true, but the file is not yet saved, so the uri is empty.
          // In such a case, do not add to recent files, as it added an empty uri, making it unsuable
-         if (!uri.empty())
+         // The files of the cache are not added either.
+         if (!uri.empty() && !mediacache::contains(uri))
             add_in_recent_manager(uri);
       }
       update_ui();
@@ -227,6 +243,70 @@ class KeyframesManagementPlugin : public Action {
       return get_subtitleeditor_window()->get_player();
    }
 
+   // Load the keyframes of the player file from the cache, or generate them
+   // in the background if the file is unknown and auto-generate is enabled.
+   bool on_load_keyframes_of_player_file() {
+      se_dbg(SE_DBG_PLUGINS);
+
+      Glib::ustring uri = player()->get_uri();
+      if (uri.empty())
+         return false;
+
+      // the keyframes of this file are already loaded
+      Glib::RefPtr<KeyFrames> current = player()->get_keyframes();
+      if (current && current->get_video_uri() == uri)
+         return false;
+
+      Glib::ustring cached = mediacache::lookup(uri, "kf");
+      if (!cached.empty()) {
+         Glib::RefPtr<KeyFrames> kf = KeyFrames::create_from_file(cached);
+         if (kf) {
+            // the file can have been moved since
+            kf->set_video_uri(uri);
+            player()->set_keyframes(kf);
+            return false;
+         }
+      }
+
+      if (!cfg::get_boolean("media-cache", "enabled") || !cfg::get_boolean("media-cache", "auto-generate"))
+         return false;
+
+      // the generation of this file has failed, don't try again
+      if (m_generation_failed.count(uri))
+         return false;
+
+      // the keyframes of this file are already in progress
+      if (m_generator && m_generator_uri == uri)
+         return false;
+
+      // the generation of the previous file is cancelled
+      m_generator_uri = uri;
+      m_generator =
+         generate_keyframes_in_background(uri, sigc::bind(sigc::mem_fun(*this, &KeyframesManagementPlugin::on_keyframes_generated), uri));
+      return false;
+   }
+
+   // The background generation of the keyframes of 'uri' is over,
+   // 'kf' is empty if it has failed.
+   void on_keyframes_generated(Glib::RefPtr<KeyFrames> kf, Glib::ustring uri) {
+      if (!kf) {
+         m_generation_failed.insert(uri);
+         return;
+      }
+      save_in_cache(kf);
+
+      // the player can have been closed since
+      if (player()->get_uri() == uri)
+         player()->set_keyframes(kf);
+   }
+
+   // Save the keyframes in the cache of their media file.
+   void save_in_cache(const Glib::RefPtr<KeyFrames>& kf) {
+      Glib::ustring uri = mediacache::get_uri(kf->get_video_uri(), "kf");
+      if (!uri.empty() && kf->save(uri))
+         mediacache::trim();
+   }
+
    void on_open() {
       DialogOpenKeyframe ui;
       if (ui.run() == Gtk::RESPONSE_OK) {
@@ -237,6 +317,7 @@ class KeyframesManagementPlugin : public Action {
             kf = generate_keyframes_from_file_using_frame(ui.get_uri());
 
          if (kf) {
+            check_media_hash(kf);
             player()->set_keyframes(kf);
             add_in_recent_manager(kf->get_uri());
          }
@@ -287,11 +368,29 @@ class KeyframesManagementPlugin : public Action {
          se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", cur->get_uri().c_str());
 
          Glib::RefPtr<KeyFrames> kf = KeyFrames::create_from_file(cur->get_uri());
-         if (kf)
+         if (kf) {
+            check_media_hash(kf);
             player()->set_keyframes(kf);
+         }
       }
    }
 
+   // Warn if the keyframes have been generated from another version
+   // of the video of the player (or of their video if none is open).
+   void check_media_hash(const Glib::RefPtr<KeyFrames>& kf) {
+      Glib::ustring video_uri = player()->get_uri();
+      if (video_uri.empty())
+         video_uri = kf->get_video_uri();
+
+      if (utility::media_hash_matches(kf->get_media_hash(), video_uri))
+         return;
+
+      dialog_warning(_("The keyframes don't match the video"),
+                     Glib::ustring::compose(_("The keyframes have been generated from another version of the file '%1'. "
+                                              "They may not be at the right times."),
+                                            Gio::File::create_for_uri(video_uri)->get_parse_name()));
+   }
+
    void set_default_filename_from_video(Gtk::FileChooser* fc, const Glib::ustring& video_uri, const Glib::ustring& ext) {
       try {
          Glib::ustring videofn = Glib::filename_from_uri(video_uri);
@@ -316,8 +415,13 @@ class KeyframesManagementPlugin : public Action {
       if (uri.empty())
          return;
 
+      // the background generation of this file isn't needed anymore
+      if (m_generator && m_generator_uri == uri)
+         m_generator.reset();
+
       Glib::RefPtr<KeyFrames> kf = generate_keyframes_from_file(uri);
       if (kf) {
+         save_in_cache(kf);
          player()->set_keyframes(kf);
          on_save();
       }
@@ -330,6 +434,7 @@ class KeyframesManagementPlugin : public Action {
 
       Glib::RefPtr<KeyFrames> kf = generate_keyframes_from_file_using_frame(uri);
       if (kf) {
+         save_in_cache(kf);
          player()->set_keyframes(kf);
          on_save();
       }
@@ -343,28 +448,18 @@ class KeyframesManagementPlugin : public Action {
       Glib::RefPtr<KeyFrames> keyframes = player()->get_keyframes();
       g_return_if_fail(keyframes);
 
-      long pos = player()->get_position();
-
-      for (auto it = keyframes->begin(); it != keyframes->end(); ++it) {
-         if (*it > pos) {
-            player()->seek(*it);
-            return;
-         }
-      }
+      long next = 0;
+      if (keyframes->get_next(player()->get_position(), next))
+         player()->seek(next);
    }
 
    void on_seek_previous() {
       Glib::RefPtr<KeyFrames> keyframes = player()->get_keyframes();
       g_return_if_fail(keyframes);
 
-      long pos = player()->get_position();
-
-      for (auto it = keyframes->rbegin(); it != keyframes->rend(); ++it) {
-         if (*it < pos) {
-            player()->seek(*it);
-            return;
-         }
-      }
+      long prev = 0;
+      if (keyframes->get_previous(player()->get_position(), prev))
+         player()->seek(prev);
    }
 
    bool get_previous_keyframe(const long pos, long& prev) {
@@ -372,13 +467,7 @@ class KeyframesManagementPlugin : public Action {
       if (!keyframes)
          return false;
 
-      for (auto it = keyframes->rbegin(); it != keyframes->rend(); ++it) {
-         if (*it < pos) {
-            prev = *it;
-            return true;
-         }
-      }
-      return false;
+      return keyframes->get_previous(pos, prev);
    }
 
    bool get_next_keyframe(const long pos, long& next) {
@@ -386,13 +475,7 @@ class KeyframesManagementPlugin : public Action {
       if (!keyframes)
          return false;
 
-      for (auto it = keyframes->begin(); it != keyframes->end(); ++it) {
-         if (*it > pos) {
-            next = *it;
-            return true;
-         }
-      }
-      return false;
+      return keyframes->get_next(pos, next);
    }
 
    bool snap_start_to_keyframe(bool previous) {
@@ -453,6 +536,12 @@ class KeyframesManagementPlugin : public Action {
   protected:
    Gtk::UIManager::ui_merge_id ui_id;
    Glib::RefPtr<Gtk::ActionGroup> action_group;
+   sigc::connection m_load_from_cache_connection;
+   // the background generation of the player file (m_generator_uri)
+   std::unique_ptr<MediaDecoder> m_generator;
+   Glib::ustring m_generator_uri;
+   // media files whose automatic generation has failed
+   std::set<Glib::ustring> m_generation_failed;
 };
 
 REGISTER_EXTENSION(KeyframesManagementPlugin)
@@ -49,18 +49,25 @@ class MediaDecoder : virtual public sigc::trackable {
       return md->on_bus_message(bus, msg);
    }
 
-   void create_pipeline(const Glib::ustring& uri) {
-      se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
+   // The decoder is a decodebin by default. With a parsebin the streams
+   // are only demuxed and parsed, they are not decoded.
+   // Return false if the decoder can't be created.
+   bool create_pipeline(const Glib::ustring& uri, const gchar* decoder_factory = "decodebin") {
+      se_dbg_msg(SE_DBG_PLUGINS, "uri=%s decoder=%s", uri.c_str(), decoder_factory);
 
       if (m_pipeline)
          destroy_pipeline();
 
+      GstElement* decodebin = gst_element_factory_make(decoder_factory, "decoder");
+      if (!decodebin) {
+         se_dbg_msg(SE_DBG_PLUGINS, "Could not create the element '%s'", decoder_factory);
+         return false;
+      }
+
       m_pipeline = gst_pipeline_new("pipeline");
 
       GstElement* giosrc = gst_element_factory_make("giosrc", NULL);
 
-      GstElement* decodebin = gst_element_factory_make("decodebin", "decoder");
-
       g_signal_connect(decodebin, "pad-added", G_CALLBACK(static_on_pad_added), this);
 
       gst_bin_add_many(GST_BIN(m_pipeline), giosrc, decodebin, NULL);
@@ -68,7 +75,8 @@ class MediaDecoder : virtual public sigc::trackable {
       if (!gst_element_link(giosrc, decodebin)) {
          g_printerr("Elements could not be linked.\n");
          gst_object_unref(m_pipeline);
-         return;
+         m_pipeline = nullptr;
+         return false;
       }
 
       g_object_set(giosrc, "location", uri.c_str(), NULL);
@@ -81,6 +89,7 @@ class MediaDecoder : virtual public sigc::trackable {
       if (gst_element_set_state(m_pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
          se_dbg_msg(SE_DBG_PLUGINS, "Failed to change the state of the pipeline to PLAYING");
       }
+      return true;
    }
 
    void destroy_pipeline() {
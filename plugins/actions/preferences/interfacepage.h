@@ -29,6 +29,7 @@ class InterfacePage : public PreferencePage {
       init_widget(xml, "check-maximize-window", "interface", "maximize-window");
       init_widget(xml, "check-ask-to-save-on-exit", "interface", "ask-to-save-on-exit");
       init_widget(xml, "spin-max-undo", "interface", "max-undo");
+      init_widget(xml, "spin-max-undo-memory", "interface", "max-undo-memory");
 
       init_widget(xml, "check-center-subtitle", "subtitle-view", "property-alignment-center");
       init_widget(xml, "check-show-character-per-line", "subtitle-view", "show-character-per-line");
@@ -34,6 +34,7 @@ class WaveformPage : public PreferencePage {
       init_color_button(xml, "colorbutton-subtitle", "waveform-renderer", "color-subtitle");
       init_color_button(xml, "colorbutton-subtitle-selected", "waveform-renderer", "color-subtitle-selected");
       init_color_button(xml, "colorbutton-subtitle-invalid", "waveform-renderer", "color-subtitle-invalid");
+      init_color_button(xml, "colorbutton-subtitle-error", "waveform-renderer", "color-subtitle-error");
       init_color_button(xml, "colorbutton-player-position", "waveform-renderer", "color-player-position");
 
       init_widget(xml, "check-display-background", "waveform", "display-background");
@@ -22,6 +22,8 @@
 #include <extension/action.h>
 #include <i18n.h>
 
+#include <set>
+
 class SelectionPlugin : public Action {
   public:
    SelectionPlugin() {
@@ -72,6 +74,11 @@ class SelectionPlugin : public Action {
       action_group->add(Gtk::Action::create("select-to-end", _("Select to End"), _("Select all subtitles from current to end")),
                         sigc::mem_fun(*this, &SelectionPlugin::on_select_to_end));
 
+      action_group->add(Gtk::Action::create("select-overlapping-subtitles",
+                                            _("Select _Overlapping Subtitles"),
+                                            _("Select all subtitles which overlap another subtitle")),
+                        sigc::mem_fun(*this, &SelectionPlugin::on_select_overlapping));
+
       // ui
       Glib::RefPtr<Gtk::UIManager> ui = get_ui_manager();
 
@@ -92,6 +99,7 @@ class SelectionPlugin : public Action {
               <menuitem action='invert-subtitles-selection'/>
               <menuitem action='select-to-start'/>
               <menuitem action='select-to-end'/>
+              <menuitem action='select-overlapping-subtitles'/>
             </placeholder>
           </menu>
         </menubar>
@@ -124,6 +132,7 @@ class SelectionPlugin : public Action {
       action_group->get_action("invert-subtitles-selection")->set_sensitive(visible);
       action_group->get_action("select-to-start")->set_sensitive(visible);
       action_group->get_action("select-to-end")->set_sensitive(visible);
+      action_group->get_action("select-overlapping-subtitles")->set_sensitive(visible);
    }
 
   protected:
@@ -181,8 +190,14 @@ class SelectionPlugin : public Action {
       execute(TOEND);
    }
 
+   void on_select_overlapping() {
+      se_dbg(SE_DBG_PLUGINS);
+
+      execute(OVERLAPPING);
+   }
+
   protected:
-   enum TYPE { FIRST, LAST, PREVIOUS, NEXT, ALL, INVERT, UNSELECT, TOSTART, TOEND };
+   enum TYPE { FIRST, LAST, PREVIOUS, NEXT, ALL, INVERT, UNSELECT, TOSTART, TOEND, OVERLAPPING };
 
    bool execute(TYPE type) {
       se_dbg(SE_DBG_PLUGINS);
@@ -246,6 +261,20 @@ class SelectionPlugin : public Action {
             }
             subtitles.select(selection);
          }
+      } else if (type == OVERLAPPING) {
+         // a subtitle can overlap several others, select it once
+         std::vector<Subtitle> selection;
+         std::set<unsigned int> nums;
+         for (const auto& pair : subtitles.find_overlaps()) {
+            if (nums.insert(pair.first.get_num()).second)
+               selection.push_back(pair.first);
+            if (nums.insert(pair.second.get_num()).second)
+               selection.push_back(pair.second);
+         }
+         subtitles.unselect_all();
+         subtitles.select(selection);
+         doc->flash_message(_("Selected %i subtitles."), static_cast<int>(selection.size()));
+         return true;
       }
       return false;
    }
@@ -18,12 +18,16 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
+#include <error.h>
 #include <extension/action.h>
 #include <filereader.h>
 #include <gtkmm.h>
 #include <gtkmm_utility.h>
 #include <utility.h>
 
+#include <memory>
+
 #include "capitalizationpage.h"
 #include "commonerrorpage.h"
 #include "confirmationpage.h"
@@ -214,4 +218,58 @@ class TextCorrectionPlugin : public Action {
    Glib::RefPtr<Gtk::ActionGroup> action_group;
 };
 
+// Batch step "text-correction"
+// Apply the patterns of the tasks enabled in the assistant, with the script,
+// language and country selected the last time.
+static void batch_text_correction(Document* doc, const std::vector<Glib::ustring>& args) {
+   if (!args.empty())
+      throw SubtitleError(_("The step text-correction doesn't have argument, the settings of the assistant are used."));
+
+   auto get_code = [](const Glib::ustring& type, const Glib::ustring& key) {
+      return cfg::has_key(type, key) ? cfg::get_string(type, key) : Glib::ustring();
+   };
+
+   std::list<std::unique_ptr<PatternManager>> managers;
+   std::list<Pattern*> patterns;
+
+   const char* types[] = {"hearing-impaired", "common-error", "capitalization"};
+   for (const auto& type : types) {
+      if (cfg::has_key(type, "enabled") && cfg::get_boolean(type, "enabled") == false)
+         continue;
+
+      managers.emplace_back(new PatternManager(type));
+
+      std::list<Pattern*> p = managers.back()->get_patterns(get_code(type, "script"), get_code(type, "language"), get_code(type, "country"));
+      patterns.splice(patterns.end(), p);
+   }
+
+   doc->start_command(_("Text Correction"));
+
+   Subtitles subtitles = doc->subtitles();
+
+   Glib::ustring text, previous;
+   for (Subtitle sub = subtitles.get_first(); sub; ++sub) {
+      text = sub.get_text();
+
+      for (const auto& pattern : patterns) {
+         pattern->execute(text, previous);
+      }
+
+      if (sub.get_text() != text)
+         sub.set_text(text);
+
+      previous = text;
+   }
+
+   doc->finish_command();
+}
+
+static void register_batch_steps() {
+   se::batch::register_step("text-correction",
+                            "",
+                            _("Apply the text correction with the settings of the assistant"),
+                            sigc::ptr_fun(&batch_text_correction));
+}
+
 REGISTER_EXTENSION(TextCorrectionPlugin)
+REGISTER_BATCH_STEPS(register_batch_steps)
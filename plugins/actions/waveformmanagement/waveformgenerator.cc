@@ -19,59 +19,75 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gtkmm.h>
+#include <subtitleeditorwindow.h>
 #include <utility.h>
 #include <waveform.h>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 
 #include "mediadecoder.h"
 
-class WaveformGenerator : public Gtk::Dialog, public MediaDecoder {
+// Decode the audio of the media and compute the values of the waveform.
+// The progress and the end of the work are displayed by the subclass,
+// in a dialog (DialogWaveformGenerator) or in the statusbar
+// (WaveformBackgroundGenerator).
+class WaveformGenerator : public MediaDecoder {
   public:
-   WaveformGenerator(const Glib::ustring& uri, Glib::RefPtr<Waveform>& wf)
-       : Gtk::Dialog(_("Generate Waveform"), true), MediaDecoder(1000), m_duration(GST_CLOCK_TIME_NONE), m_n_channels(0) {
-      se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
+   WaveformGenerator() : MediaDecoder(1000), m_duration(GST_CLOCK_TIME_NONE), m_n_channels(0) {
+   }
 
-      set_border_width(12);
-      set_default_size(300, -1);
-      get_vbox()->pack_start(m_progressbar, false, false);
-      add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
-      m_progressbar.set_show_text(true);
-      m_progressbar.set_text(_("Waiting..."));
-      show_all();
+   // Called with the position and the duration of the stream.
+   virtual void on_progress(gint64 pos, gint64 len) = 0;
 
-      try {
-         create_pipeline(uri);
+   // Called when the work is finished or cancelled.
+   virtual void on_done(bool finished) = 0;
 
-         if (run() == Gtk::RESPONSE_OK) {
-            wf = Glib::RefPtr<Waveform>(new Waveform);
-            wf->m_duration = m_duration / GST_MSECOND;
-            wf->m_n_channels = m_n_channels;
-            for (guint i = 0; i < m_n_channels; ++i) {
-               wf->m_channels[i] = std::vector<double>(m_values[i].begin(), m_values[i].end());
-            }
-            wf->m_video_uri = uri;
-         }
-      } catch (const std::runtime_error& ex) {
-         std::cerr << ex.what() << std::endl;
+   // Build the waveform of the media from the values, the work must be finished.
+   Glib::RefPtr<Waveform> create_waveform(const Glib::ustring& uri) {
+      Glib::RefPtr<Waveform> wf(new Waveform);
+      wf->m_duration = m_duration / GST_MSECOND;
+      wf->m_n_channels = m_n_channels;
+      for (guint i = 0; i < m_n_channels; ++i) {
+         wf->m_channels[i] = std::move(m_values[i]);
       }
+      wf->build_peak_levels();
+      wf->m_video_uri = uri;
+      wf->m_media_hash = utility::compute_media_hash(uri);
+      return wf;
    }
 
    // Create audio bin
+   // The samples are converted to native float and analysed in the handoff
+   // of the fakesink, on the streaming thread, without a message by interval.
    GstElement* create_element(const Glib::ustring& structure_name) {
       se_dbg_msg(SE_DBG_PLUGINS, "structure_name=%s", structure_name.c_str());
       // We only need and want create the video sink
       if (structure_name.find("audio") == Glib::ustring::npos)
          return nullptr;
 
+      Glib::ustring description = Glib::ustring::compose("audioconvert ! audio/x-raw,format=%1 ! fakesink name=asink", float_format());
+
       GError* error = nullptr;
-      GstElement* audiobin = gst_parse_bin_from_description("audioconvert ! level name=level ! fakesink name=asink", true, &error);
+      GstElement* audiobin = gst_parse_bin_from_description(description.c_str(), true, &error);
       if (error) {
          // FIXME: print error
          g_clear_error(&error);
          return nullptr;
       }
+
+      GstElement* fakesink = gst_bin_get_by_name(GST_BIN(audiobin), "asink");
+      g_object_set(G_OBJECT(fakesink), "silent", TRUE, NULL);
+      g_object_set(G_OBJECT(fakesink), "signal-handoffs", TRUE, NULL);
+      g_signal_connect(fakesink, "handoff", G_CALLBACK(WaveformGenerator::static_handoff_callback), this);
+
+      GstPad* sinkpad = gst_element_get_static_pad(fakesink, "sink");
+      g_signal_connect(sinkpad, "notify::caps", G_CALLBACK(WaveformGenerator::static_caps_callback), this);
+      gst_object_unref(sinkpad);
+      gst_object_unref(fakesink);
+
       // Set the new sink tp READY as well
       GstStateChangeReturn retst = gst_element_set_state(audiobin, GST_STATE_READY);
       if (retst == GST_STATE_CHANGE_FAILURE)
@@ -80,23 +96,11 @@ class WaveformGenerator : public Gtk::Dialog, public MediaDecoder {
       return audiobin;
    }
 
-   // BUS MESSAGE
-   bool on_bus_message(GstBus* bus, GstMessage* msg) {
-      MediaDecoder::on_bus_message(bus, msg);
-
-      if (GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ELEMENT)
-         return true;
-
-      const GstStructure* structure = gst_message_get_structure(msg);
-      Glib::ustring struct_name = gst_structure_get_name(structure);
-      // FIXME: check if ok
-      // if (msg->get_structure().get_name() == "level")
-      if (struct_name != "level")
-         return true;
-      return on_bus_message_element_level(msg);
+   // F32LE or F32BE, the native float format
+   static const gchar* float_format() {
+      return (G_BYTE_ORDER == G_LITTLE_ENDIAN) ? "F32LE" : "F32BE";
    }
 
-   // Update the progress bar
    bool on_timeout() {
       se_dbg(SE_DBG_PLUGINS);
 
@@ -105,50 +109,149 @@ class WaveformGenerator : public Gtk::Dialog, public MediaDecoder {
 
       gint64 pos = 0, len = 0;
       if (gst_element_query_position(m_pipeline, GST_FORMAT_TIME, &pos) && gst_element_query_duration(m_pipeline, GST_FORMAT_TIME, &len)) {
-         double percent = static_cast<double>(pos) / static_cast<double>(len);
-
-         percent = CLAMP(percent, 0.0, 1.0);
-
-         m_progressbar.set_fraction(percent);
-         m_progressbar.set_text(time_to_string(pos) + " / " + time_to_string(len));
-
+         on_progress(pos, len);
          return pos != len;
       }
 
       return true;
    }
 
-   bool on_bus_message_element_level(GstMessage* msg) {
-      se_dbg_msg(SE_DBG_PLUGINS, "type='%s' name='%s'", GST_MESSAGE_TYPE_NAME(msg), GST_OBJECT_NAME(GST_MESSAGE_SRC(msg)));
+   static void static_handoff_callback(GstElement* fakesink, GstBuffer* buffer, GstPad* pad, gpointer data) {
+      WaveformGenerator* wfg = static_cast<WaveformGenerator*>(data);
+      wfg->on_audio_handoff(fakesink, buffer, pad);
+   }
 
-      const GstStructure* structure = gst_message_get_structure(msg);
-      const GValue* array_val = gst_structure_get_value(structure, "rms");
-      GValueArray* rms_arr = static_cast<GValueArray*>(g_value_get_boxed(array_val));
+   static void static_caps_callback(GObject* pad, GParamSpec*, gpointer data) {
+      WaveformGenerator* wfg = static_cast<WaveformGenerator*>(data);
+      wfg->on_audio_caps(GST_PAD(pad));
+   }
 
-      guint num_channels = rms_arr->n_values;
+   // Called on the streaming thread when the caps of the sink are changed,
+   // before the buffers of the new format. The rate and the channels are
+   // only read here, not for each buffer.
+   void on_audio_caps(GstPad* pad) {
+      GstCaps* caps = gst_pad_get_current_caps(pad);
+      if (caps == nullptr)
+         return;
 
-      guint first_channel, last_channel;
-      if (num_channels >= 6) {
-         first_channel = 1;
-         last_channel = 3;
-      } else if (num_channels == 5) {
-         first_channel = 1;
-         last_channel = 2;
-      } else if (num_channels == 2) {
-         first_channel = 0;
-         last_channel = 1;
+      gint rate = 0, channels = 0;
+      GstStructure* structure = gst_caps_get_structure(caps, 0);
+      gst_structure_get_int(structure, "rate", &rate);
+      gst_structure_get_int(structure, "channels", &channels);
+      gst_caps_unref(caps);
+
+      if (rate <= 0 || channels <= 0)
+         return;
+
+      // the interval in progress is counted in frames of the previous format
+      if (rate != m_rate || channels != m_input_channels)
+         flush_interval();
+
+      if (channels != m_input_channels)
+         setup_channels(channels);
+
+      m_rate = rate;
+   }
+
+   // Called on the streaming thread for each buffer of samples.
+   // The RMS of each interval (like the level element, 100 ms) is appended
+   // to the values of the channel.
+   void on_audio_handoff(GstElement*, GstBuffer* buf, GstPad*) {
+      // the format of the caps (on_audio_caps)
+      gint rate = m_rate;
+      gint channels = m_input_channels;
+      if (rate <= 0 || channels <= 0)
+         return;
+
+      GstMapInfo map;
+      if (!gst_buffer_map(buf, &map, GST_MAP_READ))
+         return;
+
+      const float* samples = reinterpret_cast<const float*>(map.data);
+      gsize n_frames = map.size / (sizeof(float) * channels);
+      const gsize interval_frames = std::max<gsize>(static_cast<gsize>(rate) / 10, 1);
+
+      // the interval is flushed when it's full or when the rate is changed,
+      // so m_interval_frames < interval_frames and the subtraction can't wrap around
+      while (n_frames > 0) {
+         gsize n = std::min(n_frames, interval_frames - m_interval_frames);
+
+         for (guint c = m_first_channel, i = 0; c <= m_last_channel; ++c, ++i)
+            m_sum_squares[i] += sum_squares(samples + c, n, static_cast<gsize>(channels));
+
+         m_interval_frames += n;
+         samples += n * channels;
+         n_frames -= n;
+
+         if (m_interval_frames >= interval_frames)
+            flush_interval();
+      }
+
+      gst_buffer_unmap(buf, &map);
+   }
+
+   // Sum of the squares of n samples, the samples are interleaved (stride).
+   // The loop uses four accumulators, so it isn't bounded by the latency
+   // of the additions and can be vectorised by the compiler.
+   static double sum_squares(const float* samples, gsize n, gsize stride) {
+      float acc[4] = {0, 0, 0, 0};
+      gsize i = 0;
+      for (; i + 4 <= n; i += 4) {
+         for (gsize k = 0; k < 4; ++k) {
+            float v = samples[(i + k) * stride];
+            acc[k] += v * v;
+         }
+      }
+      double sum = static_cast<double>(acc[0]) + acc[1] + acc[2] + acc[3];
+      for (; i < n; ++i) {
+         double v = samples[i * stride];
+         sum += v * v;
+      }
+      return sum;
+   }
+
+   // Choose the channels kept from the number of channels of the stream
+   // and reserve the values for the whole duration.
+   void setup_channels(gint channels) {
+      m_input_channels = channels;
+
+      if (channels >= 6) {
+         m_first_channel = 1;
+         m_last_channel = 3;
+      } else if (channels == 5) {
+         m_first_channel = 1;
+         m_last_channel = 2;
+      } else if (channels == 2) {
+         m_first_channel = 0;
+         m_last_channel = 1;
       } else {
-         first_channel = last_channel = 0;
+         m_first_channel = m_last_channel = 0;
       }
       // build the number of channels
-      m_n_channels = last_channel - first_channel + 1;
+      m_n_channels = m_last_channel - m_first_channel + 1;
 
-      // get peak from channels
-      for (guint c = first_channel, i = 0; c <= last_channel; ++c, ++i) {
-         double peak = pow(10, g_value_get_double(g_value_array_get_nth(rms_arr, c)) / 20);
-         m_values[i].push_back(peak);
+      gint64 len = 0;
+      gsize n_intervals = 0;
+      if (m_pipeline && gst_element_query_duration(m_pipeline, GST_FORMAT_TIME, &len) && len > 0)
+         n_intervals = static_cast<gsize>(len / (GST_SECOND / 10)) + 1;
+
+      for (guint i = 0; i < 3; ++i) {
+         m_sum_squares[i] = 0;
+         m_values[i].reserve(n_intervals);
       }
-      return true;
+      m_interval_frames = 0;
+   }
+
+   // Append the RMS of the current interval to the values.
+   void flush_interval() {
+      if (m_interval_frames == 0)
+         return;
+
+      for (guint i = 0; i < m_n_channels; ++i) {
+         m_values[i].push_back(sqrt(m_sum_squares[i] / static_cast<double>(m_interval_frames)));
+         m_sum_squares[i] = 0;
+      }
+      m_interval_frames = 0;
    }
 
    void on_work_finished() {
@@ -158,8 +261,10 @@ class WaveformGenerator : public Gtk::Dialog, public MediaDecoder {
       gint64 pos = 0;
 
       if (m_pipeline && gst_element_query_position(m_pipeline, GST_FORMAT_TIME, &pos)) {
+         // the streaming is over, the last interval can be read
+         flush_interval();
          m_duration = pos;
-         response(Gtk::RESPONSE_OK);
+         on_done(true);
       } else {
          GST_ELEMENT_ERROR(m_pipeline, STREAM, FAILED, (_("Could not determinate the duration of the stream.")), (NULL));
       }
@@ -168,18 +273,127 @@ class WaveformGenerator : public Gtk::Dialog, public MediaDecoder {
    void on_work_cancel() {
       se_dbg(SE_DBG_PLUGINS);
 
-      response(Gtk::RESPONSE_CANCEL);
+      on_done(false);
    }
 
   protected:
-   Gtk::ProgressBar m_progressbar;
    guint64 m_duration;
    guint m_n_channels;
-   std::list<gdouble> m_values[3];
+   std::vector<double> m_values[3];
+
+   // written by the streaming thread only, until the end of stream
+   gint m_rate{0};
+   gint m_input_channels{0};
+   guint m_first_channel{0};
+   guint m_last_channel{0};
+   gsize m_interval_frames{0};
+   double m_sum_squares[3]{0, 0, 0};
+};
+
+// Generate the waveform in a modal dialog, the user can cancel it.
+class DialogWaveformGenerator : public Gtk::Dialog, public WaveformGenerator {
+  public:
+   DialogWaveformGenerator(const Glib::ustring& uri, Glib::RefPtr<Waveform>& wf) : Gtk::Dialog(_("Generate Waveform"), true) {
+      se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
+
+      set_border_width(12);
+      set_default_size(300, -1);
+      get_vbox()->pack_start(m_progressbar, false, false);
+      add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+      m_progressbar.set_show_text(true);
+      m_progressbar.set_text(_("Waiting..."));
+      show_all();
+
+      try {
+         create_pipeline(uri);
+
+         if (run() == Gtk::RESPONSE_OK)
+            wf = create_waveform(uri);
+      } catch (const std::runtime_error& ex) {
+         std::cerr << ex.what() << std::endl;
+      }
+   }
+
+   void on_progress(gint64 pos, gint64 len) {
+      double percent = static_cast<double>(pos) / static_cast<double>(len);
+
+      percent = CLAMP(percent, 0.0, 1.0);
+
+      m_progressbar.set_fraction(percent);
+      m_progressbar.set_text(time_to_string(pos) + " / " + time_to_string(len));
+   }
+
+   void on_done(bool finished) {
+      response(finished ? Gtk::RESPONSE_OK : Gtk::RESPONSE_CANCEL);
+   }
+
+  protected:
+   Gtk::ProgressBar m_progressbar;
+};
+
+// Generate the waveform without blocking the user, the progress is
+// displayed in the statusbar of the window.
+class WaveformBackgroundGenerator : public WaveformGenerator {
+  public:
+   WaveformBackgroundGenerator(const Glib::ustring& uri, const sigc::slot<void, Glib::RefPtr<Waveform>>& slot_done)
+       : m_uri(uri), m_slot_done(slot_done) {
+      se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", uri.c_str());
+
+      m_statusbar = SubtitleEditorWindow::get_instance()->get_statusbar();
+      m_context_id = m_statusbar->get_context_id("waveform-generator");
+
+      if (create_pipeline(uri))
+         set_status(_("Generating the waveform..."));
+      else
+         on_done(false);
+   }
+
+   ~WaveformBackgroundGenerator() {
+      // the streaming thread must be stopped before the values are released
+      destroy_pipeline();
+      set_status(Glib::ustring());
+   }
+
+   void on_progress(gint64 pos, gint64 len) {
+      int percent = (len > 0) ? static_cast<int>(CLAMP(100.0 * pos / len, 0.0, 100.0)) : 0;
+      set_status(build_message(_("Generating the waveform... %d%%"), percent));
+   }
+
+   // The slot can't release the generator, it's called from the bus watch.
+   void on_done(bool finished) {
+      Glib::RefPtr<Waveform> wf;
+      if (finished)
+         wf = create_waveform(m_uri);
+
+      destroy_pipeline();
+      set_status(Glib::ustring());
+      m_slot_done(wf);
+   }
+
+  protected:
+   // Replace the message of the generator in the statusbar, an empty text removes it.
+   // Only this message is removed, another generator can use the same context.
+   void set_status(const Glib::ustring& text) {
+      if (m_message_id != 0)
+         m_statusbar->remove_message(m_message_id, m_context_id);
+      m_message_id = text.empty() ? 0 : m_statusbar->push(text, m_context_id);
+   }
+
+  protected:
+   Glib::ustring m_uri;
+   sigc::slot<void, Glib::RefPtr<Waveform>> m_slot_done;
+   Gtk::Statusbar* m_statusbar{nullptr};
+   guint m_context_id{0};
+   guint m_message_id{0};
 };
 
 Glib::RefPtr<Waveform> generate_waveform_from_file(const Glib::ustring& uri) {
    Glib::RefPtr<Waveform> wf;
-   WaveformGenerator ui(uri, wf);
+   DialogWaveformGenerator ui(uri, wf);
    return wf;
 }
+
+std::unique_ptr<MediaDecoder> generate_waveform_in_background(const Glib::ustring& uri,
+                                                              const sigc::slot<void, Glib::RefPtr<Waveform>>& slot_done) {
+   return std::unique_ptr<MediaDecoder>(new WaveformBackgroundGenerator(uri, slot_done));
+}
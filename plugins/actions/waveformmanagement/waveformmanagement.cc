@@ -21,12 +21,20 @@
 #include <extension/action.h>
 #include <gtkmm.h>
 #include <gui/dialogfilechooser.h>
+#include <mediacache.h>
 #include <player.h>
 #include <utility.h>
 #include <waveformmanager.h>
 
+#include <memory>
+#include <set>
+
+#include "mediadecoder.h"
+
 // Declared in waveformgenerator.cc
 Glib::RefPtr<Waveform> generate_waveform_from_file(const Glib::ustring& uri);
+std::unique_ptr<MediaDecoder> generate_waveform_in_background(const Glib::ustring& uri,
+                                                              const sigc::slot<void, Glib::RefPtr<Waveform>>& slot_done);
 
 class WaveformManagement : public Action {
   public:
@@ -37,6 +45,8 @@ class WaveformManagement : public Action {
    }
 
    ~WaveformManagement() {
+      m_load_from_cache_connection.disconnect();
+      m_generator.reset();
       deactivate();
    }
 
@@ -248,7 +258,8 @@ class WaveformManagement : public Action {
          // When waveform is first created, there is a wf object and the condition
          // evaluates to true, but the file is not yet saved, so the uri is empty.
          // In such a case, do not add to recent files, as it added an empty uri, making it unsuable
-         if (!uri.empty())
+         // The files of the cache are not added either.
+         if (!uri.empty() && !mediacache::contains(uri))
             add_in_recent_manager(uri);
       }
       update_ui();
@@ -263,6 +274,10 @@ class WaveformManagement : public Action {
             bool has_player_file = (player->get_state() != Player::NONE);
             action_group->get_action("waveform/generate-from-player-file")->set_sensitive(has_player_file);
             action_group->get_action("waveform/generate-dummy")->set_sensitive(has_player_file);
+
+            // not from the player message, the cache is read from the disk
+            if (msg == Player::STREAM_READY && !m_load_from_cache_connection.connected())
+               m_load_from_cache_connection = Glib::signal_idle().connect(sigc::mem_fun(*this, &WaveformManagement::on_load_waveform_of_player_file));
          } break;
          default:
             break;
@@ -274,6 +289,69 @@ class WaveformManagement : public Action {
       return get_subtitleeditor_window()->get_waveform_manager();
    }
 
+   // Load the waveform of the player file from the cache, or generate it
+   // in the background if the file is unknown and auto-generate is enabled.
+   bool on_load_waveform_of_player_file() {
+      se_dbg(SE_DBG_PLUGINS);
+
+      Glib::ustring uri = get_subtitleeditor_window()->get_player()->get_uri();
+      if (uri.empty())
+         return false;
+
+      // the waveform of this file is already displayed
+      Glib::RefPtr<Waveform> current = get_waveform_manager()->get_waveform();
+      if (current && current->get_video_uri() == uri)
+         return false;
+
+      Glib::ustring cached = mediacache::lookup(uri, "wf");
+      if (!cached.empty()) {
+         Glib::RefPtr<Waveform> wf = Waveform::create_from_file(cached);
+         if (wf) {
+            // the file can have been moved since
+            wf->m_video_uri = uri;
+            get_waveform_manager()->set_waveform(wf);
+            return false;
+         }
+      }
+
+      if (!cfg::get_boolean("media-cache", "enabled") || !cfg::get_boolean("media-cache", "auto-generate"))
+         return false;
+
+      // the generation of this file has failed, don't try again
+      if (m_generation_failed.count(uri))
+         return false;
+
+      // the waveform of this file is already in progress
+      if (m_generator && m_generator_uri == uri)
+         return false;
+
+      // the generation of the previous file is cancelled
+      m_generator_uri = uri;
+      m_generator = generate_waveform_in_background(uri, sigc::bind(sigc::mem_fun(*this, &WaveformManagement::on_waveform_generated), uri));
+      return false;
+   }
+
+   // The background generation of the waveform of 'uri' is over,
+   // 'wf' is empty if it has failed.
+   void on_waveform_generated(Glib::RefPtr<Waveform> wf, Glib::ustring uri) {
+      if (!wf) {
+         m_generation_failed.insert(uri);
+         return;
+      }
+      save_in_cache(wf);
+
+      // the player can have been closed since
+      if (get_subtitleeditor_window()->get_player()->get_uri() == uri)
+         get_waveform_manager()->set_waveform(wf);
+   }
+
+   // Save the waveform in the cache of its media file.
+   void save_in_cache(const Glib::RefPtr<Waveform>& wf) {
+      Glib::ustring uri = mediacache::get_uri(wf->get_video_uri(), "wf");
+      if (!uri.empty() && wf->save(uri))
+         mediacache::trim();
+   }
+
    // Launch the Dialog Open Waveform
    // and try to open the Waveform.
    // If is not a Waveform file launch the
@@ -288,6 +366,7 @@ class WaveformManagement : public Action {
          Glib::ustring uri = dialog.get_uri();
          Glib::RefPtr<Waveform> wf = Waveform::create_from_file(uri);
          if (wf) {
+            check_media_hash(wf);
             get_waveform_manager()->set_waveform(wf);
             add_in_recent_manager(wf->get_uri());
             update_player_from_waveform();
@@ -306,9 +385,13 @@ class WaveformManagement : public Action {
    void on_generate_from_player_file() {
       Glib::ustring uri = get_subtitleeditor_window()->get_player()->get_uri();
       if (uri.empty() == false) {
-         // get_waveform_manager()->generate_waveform(uri);
+         // the background generation of this file isn't needed anymore
+         if (m_generator && m_generator_uri == uri)
+            m_generator.reset();
+
          Glib::RefPtr<Waveform> wf = generate_waveform_from_file(uri);
          if (wf) {
+            save_in_cache(wf);
             get_waveform_manager()->set_waveform(wf);
             on_save_waveform();
          }
@@ -340,6 +423,7 @@ class WaveformManagement : public Action {
          double a = amp - (amp * (i % second) * 0.001);
          wf->m_channels[0][i - 1] = a * sin(rfreq * (i / rate));
       }
+      wf->build_peak_levels();
 
       get_waveform_manager()->set_waveform(wf);
    }
@@ -501,13 +585,32 @@ class WaveformManagement : public Action {
          se_dbg_msg(SE_DBG_PLUGINS, "uri=%s", cur->get_uri().c_str());
 
          Glib::RefPtr<Waveform> wf = Waveform::create_from_file(cur->get_uri());
-         if (wf)
+         if (wf) {
+            check_media_hash(wf);
             get_waveform_manager()->set_waveform(wf);
+         }
       }
    }
 
+   // Warn if the waveform has been generated from another version of its video.
+   void check_media_hash(const Glib::RefPtr<Waveform>& wf) {
+      if (utility::media_hash_matches(wf->get_media_hash(), wf->get_video_uri()))
+         return;
+
+      dialog_warning(_("The waveform doesn't match the video"),
+                     Glib::ustring::compose(_("The waveform has been generated from another version of the file '%1'. "
+                                              "It may not be at the right times."),
+                                            Gio::File::create_for_uri(wf->get_video_uri())->get_parse_name()));
+   }
+
   protected:
    Gtk::UIManager::ui_merge_id ui_id;
+   sigc::connection m_load_from_cache_connection;
+   // the background generation of the player file (m_generator_uri)
+   std::unique_ptr<MediaDecoder> m_generator;
+   Glib::ustring m_generator_uri;
+   // media files whose automatic generation has failed
+   std::set<Glib::ustring> m_generation_failed;
    Glib::RefPtr<Gtk::ActionGroup> action_group;
 };
 
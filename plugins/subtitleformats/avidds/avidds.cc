@@ -19,6 +19,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
 #include <extension/subtitleformat.h>
 #include <gtkmm_utility.h>
 #include <gui/dialogutility.h>
@@ -36,17 +37,7 @@ class AvidDS : public SubtitleFormatIO {
    }
 
    void open(Reader& file) {
-      // Ask for the framerate value
-      FramerateChooserDialog fcd(FramerateChooserDialog::IMPORT);
-
-      // Define the default value of the framerate from the player
-      Player* player = SubtitleEditorWindow::get_instance()->get_player();
-      if (player->get_state() != Player::NONE) {
-         float player_framerate = player->get_framerate();
-         if (player_framerate > 0)
-            fcd.set_default_framerate(get_framerate_from_value(player_framerate));
-      }
-      FRAMERATE framerate = fcd.execute();
+      FRAMERATE framerate = ask_framerate_on_open();
       m_framerate_value = get_framerate_value(framerate);
 
       document()->set_framerate(framerate);
@@ -102,11 +93,7 @@ class AvidDS : public SubtitleFormatIO {
    }
 
    void save(Writer& file) {
-      // Ask for the framerate value
-      FramerateChooserDialog fcd(FramerateChooserDialog::EXPORT);
-      fcd.set_default_framerate(document()->get_framerate());
-
-      m_framerate_value = get_framerate_value(fcd.execute());
+      m_framerate_value = get_framerate_value(ask_framerate_on_save());
 
       // write header
       file.write(
@@ -134,6 +121,33 @@ class AvidDS : public SubtitleFormatIO {
    }
 
   protected:
+   // Ask for the framerate value, the batch mode uses --framerate.
+   // Exceptions: SubtitleError in batch mode without --framerate.
+   FRAMERATE ask_framerate_on_open() {
+      if (se::batch::is_running())
+         return se::batch::get_framerate();
+
+      FramerateChooserDialog fcd(FramerateChooserDialog::IMPORT);
+
+      // Define the default value of the framerate from the player
+      Player* player = SubtitleEditorWindow::get_instance()->get_player();
+      if (player->get_state() != Player::NONE) {
+         float player_framerate = player->get_framerate();
+         if (player_framerate > 0)
+            fcd.set_default_framerate(get_framerate_from_value(player_framerate));
+      }
+      return fcd.execute();
+   }
+
+   FRAMERATE ask_framerate_on_save() {
+      if (se::batch::is_running())
+         return se::batch::get_framerate();
+
+      FramerateChooserDialog fcd(FramerateChooserDialog::EXPORT);
+      fcd.set_default_framerate(document()->get_framerate());
+      return fcd.execute();
+   }
+
    FRAMERATE m_framerate;
    double m_framerate_value;
 };
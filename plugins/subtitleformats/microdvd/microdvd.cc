@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
 #include <extension/subtitleformat.h>
 #include <player.h>
 #include <subtitleeditorwindow.h>
@@ -36,12 +37,18 @@ class MicroDVD : public SubtitleFormatIO {
       document()->set_timing_mode(FRAME);
       document()->set_edit_timing_mode(FRAME);
 
-      // Try to define the default value of the framerate from the player
-      Player* player = SubtitleEditorWindow::get_instance()->get_player();
-      if (player->get_state() != Player::NONE) {
-         float player_framerate = player->get_framerate();
-         if (player_framerate > 0)
-            document()->set_framerate(get_framerate_from_value(player_framerate));
+      // Try to define the default value of the framerate from the player,
+      // the batch mode has no player but can use --framerate
+      if (se::batch::is_running()) {
+         if (se::batch::has_framerate())
+            document()->set_framerate(se::batch::get_framerate());
+      } else {
+         Player* player = SubtitleEditorWindow::get_instance()->get_player();
+         if (player->get_state() != Player::NONE) {
+            float player_framerate = player->get_framerate();
+            if (player_framerate > 0)
+               document()->set_framerate(get_framerate_from_value(player_framerate));
+         }
       }
 
       // Read subtitles
@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
 #include <extension/subtitleformat.h>
 #include <gui/dialogutility.h>
 #include <player.h>
@@ -29,17 +30,7 @@ class SpruceSTL : public SubtitleFormatIO {
 
   public:
    void open(Reader& file) {
-      // Ask for the framerate value
-      FramerateChooserDialog fcd(FramerateChooserDialog::IMPORT);
-
-      // Define the default value of the framerate from the player
-      Player* player = SubtitleEditorWindow::get_instance()->get_player();
-      if (player->get_state() != Player::NONE) {
-         float player_framerate = player->get_framerate();
-         if (player_framerate > 0)
-            fcd.set_default_framerate(get_framerate_from_value(player_framerate));
-      }
-      FRAMERATE framerate = fcd.execute();
+      FRAMERATE framerate = ask_framerate_on_open();
       m_framerate_value = get_framerate_value(framerate);
 
       document()->set_framerate(framerate);
@@ -85,11 +76,7 @@ class SpruceSTL : public SubtitleFormatIO {
    }
 
    void save(Writer& file) {
-      // Ask for the framerate value
-      FramerateChooserDialog fcd(FramerateChooserDialog::EXPORT);
-      fcd.set_default_framerate(document()->get_framerate());
-
-      m_framerate_value = get_framerate_value(fcd.execute());
+      m_framerate_value = get_framerate_value(ask_framerate_on_save());
 
       for (Subtitle sub = document()->subtitles().get_first(); sub; ++sub) {
          Glib::ustring text = sub.get_text();
@@ -105,6 +92,34 @@ class SpruceSTL : public SubtitleFormatIO {
 
       return build_message("%02i:%02i:%02i:%02i", t.hours(), t.minutes(), t.seconds(), frame);
    }
+
+  protected:
+   // Ask for the framerate value, the batch mode uses --framerate.
+   // Exceptions: SubtitleError in batch mode without --framerate.
+   FRAMERATE ask_framerate_on_open() {
+      if (se::batch::is_running())
+         return se::batch::get_framerate();
+
+      FramerateChooserDialog fcd(FramerateChooserDialog::IMPORT);
+
+      // Define the default value of the framerate from the player
+      Player* player = SubtitleEditorWindow::get_instance()->get_player();
+      if (player->get_state() != Player::NONE) {
+         float player_framerate = player->get_framerate();
+         if (player_framerate > 0)
+            fcd.set_default_framerate(get_framerate_from_value(player_framerate));
+      }
+      return fcd.execute();
+   }
+
+   FRAMERATE ask_framerate_on_save() {
+      if (se::batch::is_running())
+         return se::batch::get_framerate();
+
+      FramerateChooserDialog fcd(FramerateChooserDialog::EXPORT);
+      fcd.set_default_framerate(document()->get_framerate());
+      return fcd.execute();
+   }
 };
 
 class SpruceSTLPlugin : public SubtitleFormat {
@@ -18,6 +18,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <batch.h>
 #include <debug.h>
 #include <error.h>
 #include <extension/subtitleformat.h>
@@ -53,9 +54,12 @@ class SubtitleEditorProject : public SubtitleFormatIO {
 
          const xmlpp::Node* root = parser.get_document()->get_root_node();
 
-         open_player(root);
-         open_waveform(root);
-         open_keyframes(root);
+         // The batch mode has no player and no waveform
+         if (!se::batch::is_running()) {
+            open_player(root);
+            open_waveform(root);
+            open_keyframes(root);
+         }
          open_styles(root);
          open_subtitles(root);
          open_subtitles_selection(root);
@@ -71,9 +75,11 @@ class SubtitleEditorProject : public SubtitleFormatIO {
          xmlpp::Element* root = xmldoc.create_root_node("SubtitleEditorProject");
          root->set_attribute("version", "1.0");
 
-         save_player(root);
-         save_waveform(root);
-         save_keyframes(root);
+         if (!se::batch::is_running()) {
+            save_player(root);
+            save_waveform(root);
+            save_keyframes(root);
+         }
          save_styles(root);
          save_subtitles(root);
          save_subtitles_selection(root);
@@ -0,0 +1,122 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "batch.h"
+
+#include <map>
+
+#include "error.h"
+#include "i18n.h"
+#include "utility.h"
+
+namespace se {
+namespace batch {
+
+namespace internal {
+
+struct step {
+   ustring usage;
+   ustring description;
+   step_slot slot;
+};
+
+static std::map<ustring, step> steps;
+
+static bool running = false;
+static bool has_framerate = false;
+static FRAMERATE framerate = FRAMERATE_23_976;
+
+}  // namespace internal
+
+using internal::steps;
+
+void register_step(const ustring& name, const ustring& usage, const ustring& description, const step_slot& slot) {
+   se_dbg_msg(SE_DBG_APP, "register the batch step '%s'", name.c_str());
+
+   internal::step& s = steps[name];
+   s.usage = usage;
+   s.description = description;
+   s.slot = slot;
+}
+
+bool has_step(const ustring& name) {
+   return steps.find(name) != steps.end();
+}
+
+vector<ustring> get_steps() {
+   vector<ustring> names;
+   for (const auto& s : steps) {
+      names.push_back(s.first);
+   }
+   return names;
+}
+
+ustring get_step_help(const ustring& name) {
+   auto it = steps.find(name);
+   if (it == steps.end())
+      return ustring();
+
+   ustring help = name;
+   if (!it->second.usage.empty())
+      help += ":" + it->second.usage;
+   return help + " - " + it->second.description;
+}
+
+void apply_step(Document* doc, const ustring& step) {
+   vector<ustring> args;
+   utility::usplit(step, ':', args);
+
+   ustring name = args.empty() ? ustring() : args.front();
+
+   auto it = steps.find(name);
+   if (it == steps.end())
+      throw SubtitleError(build_message(_("Unknown step '%s'."), name.c_str()));
+
+   se_dbg_msg(SE_DBG_APP, "apply the step '%s'", step.c_str());
+
+   args.erase(args.begin());
+   it->second.slot(doc, args);
+}
+
+bool is_running() {
+   return internal::running;
+}
+
+void set_running(bool state) {
+   internal::running = state;
+}
+
+void set_framerate(FRAMERATE framerate) {
+   internal::framerate = framerate;
+   internal::has_framerate = true;
+}
+
+bool has_framerate() {
+   return internal::has_framerate;
+}
+
+FRAMERATE get_framerate() {
+   if (!internal::has_framerate)
+      throw SubtitleError(_("This format needs the framerate of the video, use the option --framerate."));
+   return internal::framerate;
+}
+
+}  // namespace batch
+}  // namespace se
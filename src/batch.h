@@ -0,0 +1,73 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm/ustring.h>
+#include <sigc++/sigc++.h>
+
+#include <vector>
+
+#include "document.h"
+
+// Steps applied to the documents by the batch mode (--batch --step=...).
+// The extensions register their steps with REGISTER_BATCH_STEPS, they are
+// called without user interface.
+namespace se {
+namespace batch {
+
+using Glib::ustring;
+using std::vector;
+
+// The step receives the document and the arguments of the step.
+// Exceptions: SubtitleError if the arguments are invalid or if it fails.
+typedef sigc::slot<void, Document*, const vector<ustring>&> step_slot;
+
+void register_step(const ustring& name, const ustring& usage, const ustring& description, const step_slot& slot);
+
+bool has_step(const ustring& name);
+
+// Return the names of the registered steps.
+vector<ustring> get_steps();
+
+// Return "name:ARGS - description" of the step.
+ustring get_step_help(const ustring& name);
+
+// Apply the step "name[:arg[:arg...]]" to the document.
+// Exceptions: SubtitleError
+void apply_step(Document* doc, const ustring& step);
+
+// True when the documents are opened and saved by the batch mode,
+// the extensions must not use the user interface.
+bool is_running();
+
+void set_running(bool state);
+
+// The framerate given with --framerate, used by the frame based formats
+// instead of asking the user.
+void set_framerate(FRAMERATE framerate);
+
+bool has_framerate();
+
+// Exceptions: SubtitleError if --framerate is missing.
+FRAMERATE get_framerate();
+
+}  // namespace batch
+}  // namespace se
@@ -0,0 +1,341 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "batchmode.h"
+
+#include <gtkmm/main.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "document.h"
+#include "error.h"
+#include "extensionmanager.h"
+#include "i18n.h"
+#include "options.h"
+#include "subtitleformatsystem.h"
+#include "utility.h"
+
+namespace batchmode {
+
+// Maximum number of files given to one process, the next files are given
+// to the first process which finishes.
+static const unsigned int max_files_per_process = 64;
+
+// Run the conversion of the files in several processes of the program.
+// Each process converts a part of the files with the same options and
+// --jobs=1. The documents, the models and the subtitle formats are not
+// thread-safe, the processes keep them apart.
+class ProcessPool {
+  public:
+   ProcessPool(const std::vector<std::string>& argv, const std::vector<Glib::ustring>& files, unsigned int jobs)
+       : m_argv(argv), m_files(files), m_jobs(jobs) {
+      m_chunk = std::max(1u, std::min<unsigned int>(max_files_per_process, m_files.size() / (m_jobs * 4)));
+   }
+
+   // Return true if all files have been converted.
+   bool run() {
+      m_loop = Glib::MainLoop::create();
+
+      while (m_running < m_jobs && spawn_next())
+         ;
+
+      if (m_running > 0)
+         m_loop->run();
+      return m_success;
+   }
+
+  protected:
+   // Launch a process with the next files.
+   // Return false if there are no more files.
+   bool spawn_next() {
+      if (m_next >= m_files.size())
+         return false;
+
+      std::vector<std::string> argv(m_argv);
+      argv.push_back("--");
+
+      std::vector<Glib::ustring>::size_type end = std::min<std::vector<Glib::ustring>::size_type>(m_next + m_chunk, m_files.size());
+      for (; m_next < end; ++m_next) {
+         argv.push_back(m_files[m_next]);
+      }
+
+      try {
+         Glib::Pid pid;
+         Glib::spawn_async(std::string(), argv, Glib::SPAWN_SEARCH_PATH | Glib::SPAWN_DO_NOT_REAP_CHILD, Glib::SlotSpawnChildSetup(), &pid);
+         Glib::signal_child_watch().connect(sigc::mem_fun(*this, &ProcessPool::on_child_exited), pid);
+         ++m_running;
+      } catch (const Glib::SpawnError& ex) {
+         std::cerr << "Failed to launch the conversion process: " << ex.what() << std::endl;
+         m_success = false;
+      }
+      return true;
+   }
+
+   void on_child_exited(Glib::Pid pid, int status) {
+      Glib::spawn_close_pid(pid);
+
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+         m_success = false;
+
+      --m_running;
+
+      while (m_running < m_jobs && spawn_next())
+         ;
+
+      if (m_running == 0)
+         m_loop->quit();
+   }
+
+  protected:
+   std::vector<std::string> m_argv;
+   std::vector<Glib::ustring> m_files;
+   unsigned int m_jobs;
+   unsigned int m_chunk{1};
+   std::vector<Glib::ustring>::size_type m_next{0};
+   unsigned int m_running{0};
+   bool m_success{true};
+   Glib::RefPtr<Glib::MainLoop> m_loop;
+};
+
+bool is_requested(int argc, char* argv[]) {
+   for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--")
+         break;
+      if (arg == "--batch" || arg == "--convert" || Glib::str_has_prefix(arg, "--convert="))
+         return true;
+   }
+   return false;
+}
+
+// Return the files of the command line.
+// "-" reads the filenames from the standard input, one per line.
+static std::vector<Glib::ustring> get_files(const OptionGroup& options) {
+   std::vector<Glib::ustring> args(options.files);
+   args.insert(args.end(), options.files_list.begin(), options.files_list.end());
+
+   std::vector<Glib::ustring> files;
+   for (const auto& arg : args) {
+      if (arg != "-") {
+         files.push_back(arg);
+         continue;
+      }
+
+      std::string line;
+      while (std::getline(std::cin, line)) {
+         if (!line.empty())
+            files.push_back(line);
+      }
+   }
+   return files;
+}
+
+// Return the filename of the converted file.
+// The extension of the file is replaced by the extension of the format.
+static Glib::ustring get_output_filename(const Glib::ustring& filename, const Glib::ustring& format, const OptionGroup& options) {
+   Glib::ustring dirname = options.output.empty() ? Glib::path_get_dirname(filename) : utility::create_full_path(options.output);
+   Glib::ustring basename = Glib::path_get_basename(filename);
+
+   Glib::ustring::size_type dot = basename.find_last_of('.');
+   if (dot != Glib::ustring::npos)
+      basename = basename.substr(0, dot);
+
+   return Glib::build_filename(dirname, basename + "." + SubtitleFormatSystem::instance().get_extension_of_format(format));
+}
+
+// Convert the file, the errors are reported on the standard error.
+static bool convert_file(const Glib::ustring& file, const OptionGroup& options) {
+   try {
+      Glib::ustring filename = utility::create_full_path(file);
+
+      std::unique_ptr<Document> doc(new Document(false));
+      SubtitleFormatSystem::instance().open_from_uri(doc.get(), Glib::filename_to_uri(filename), options.encoding);
+
+      for (const auto& step : options.steps) {
+         se::batch::apply_step(doc.get(), step);
+      }
+
+      // Without --convert the file is saved in its own format
+      Glib::ustring format = options.convert.empty() ? doc->getFormat() : options.convert;
+      Glib::ustring charset = options.output_encoding.empty() ? doc->getCharset() : options.output_encoding;
+      Glib::ustring output = get_output_filename(filename, format, options);
+
+      if (output == filename)
+         throw SubtitleError(_("The converted file would replace the original file, use --output to choose an other directory."));
+
+      SubtitleFormatSystem::instance().save_to_uri(doc.get(), Glib::filename_to_uri(output), format, charset, doc->getNewLine());
+
+      std::cout << file << " -> " << output << std::endl;
+      return true;
+   } catch (const std::exception& ex) {
+      std::cerr << file << ": " << ex.what() << std::endl;
+   } catch (const Glib::Error& ex) {
+      std::cerr << file << ": " << ex.what() << std::endl;
+   }
+   return false;
+}
+
+// Display the steps registered by the extensions.
+static void print_steps(std::ostream& stream) {
+   stream << _("Steps available:") << std::endl;
+   for (const auto& name : se::batch::get_steps()) {
+      stream << "  " << se::batch::get_step_help(name) << std::endl;
+   }
+}
+
+// Return true and set the framerate if the value is one of the framerates
+// supported, get_framerate_from_value() doesn't report an unknown value.
+static bool parse_framerate(const Glib::ustring& value, FRAMERATE& framerate) {
+   const FRAMERATE framerates[] = {FRAMERATE_23_976, FRAMERATE_24, FRAMERATE_25, FRAMERATE_29_97, FRAMERATE_30};
+
+   double fps = utility::string_to_double(value);
+   for (auto fr : framerates) {
+      if (static_cast<int>(fps * 1000 + 0.5) == static_cast<int>(get_framerate_value(fr) * 1000 + 0.5)) {
+         framerate = fr;
+         return true;
+      }
+   }
+   return false;
+}
+
+// Check the format, the framerate and the steps before converting the files.
+static bool check_options(const OptionGroup& options) {
+   if (!options.convert.empty() && !SubtitleFormatSystem::instance().is_supported(options.convert)) {
+      std::cerr << build_message(_("The subtitle format '%s' is not supported."), options.convert.c_str()) << std::endl;
+      std::cerr << _("Formats available:") << std::endl;
+      for (const auto& info : SubtitleFormatSystem::instance().get_infos()) {
+         std::cerr << "  " << info.name << std::endl;
+      }
+      return false;
+   }
+
+   if (!options.framerate.empty()) {
+      FRAMERATE framerate;
+      if (!parse_framerate(options.framerate, framerate)) {
+         std::cerr << build_message(_("The framerate '%s' is not supported, use 23.976, 24, 25, 29.97 or 30."), options.framerate.c_str())
+                   << std::endl;
+         return false;
+      }
+      se::batch::set_framerate(framerate);
+   }
+
+   for (const auto& step : options.steps) {
+      Glib::ustring name = step.substr(0, step.find(':'));
+      if (!se::batch::has_step(name)) {
+         std::cerr << build_message(_("Unknown step '%s'."), name.c_str()) << std::endl;
+         print_steps(std::cerr);
+         return false;
+      }
+   }
+   return true;
+}
+
+// Return the options given to the conversion processes.
+static std::vector<std::string> get_process_argv(const char* program, const OptionGroup& options) {
+   std::vector<std::string> argv;
+   argv.push_back(program);
+   argv.push_back("--batch");
+   argv.push_back("--jobs=1");
+
+   if (!options.profile.empty())
+      argv.push_back("--profile=" + options.profile);
+   if (!options.convert.empty())
+      argv.push_back("--convert=" + options.convert);
+   if (!options.encoding.empty())
+      argv.push_back("--encoding=" + options.encoding);
+   if (!options.output.empty())
+      argv.push_back("--output=" + options.output);
+   if (!options.output_encoding.empty())
+      argv.push_back("--output-encoding=" + options.output_encoding);
+   if (!options.framerate.empty())
+      argv.push_back("--framerate=" + options.framerate);
+
+   for (const auto& step : options.steps) {
+      argv.push_back("--step=" + step);
+   }
+   return argv;
+}
+
+int run(int argc, char* argv[]) {
+   OptionGroup options;
+   try {
+      Glib::OptionContext context(_(" — convert subtitles files"));
+      context.set_main_group(options);
+
+#ifdef DEBUG
+      context.add_group(options.get_debug_group());
+#endif
+
+      context.parse(argc, argv);
+   } catch (const Glib::Error& ex) {
+      std::cerr << "Error loading options : " << ex.what() << std::endl;
+      return EXIT_FAILURE;
+   }
+
+   se_dbg_init(options.get_debug_flags());
+   se_dbg_msg(SE_DBG_APP, "Startup subtitle version %s in batch mode", VERSION);
+
+   if (!options.profile.empty())
+      set_profile_name(options.profile);
+
+   // The documents use the gtkmm models, Gtk+ is not initialized
+   // because the batch mode doesn't need a display.
+   Gtk::Main::init_gtkmm_internals();
+
+   // The extensions must not open dialogs or use the main window
+   se::batch::set_running(true);
+
+   ExtensionManager::instance().create_batch_extensions();
+
+   if (std::find(options.steps.begin(), options.steps.end(), "help") != options.steps.end()) {
+      print_steps(std::cout);
+      return EXIT_SUCCESS;
+   }
+
+   if (!check_options(options))
+      return EXIT_FAILURE;
+
+   std::vector<Glib::ustring> files = get_files(options);
+   if (files.empty()) {
+      std::cerr << _("No subtitle file to convert.") << std::endl;
+      return EXIT_FAILURE;
+   }
+
+   unsigned int jobs = (options.jobs > 0) ? options.jobs : g_get_num_processors();
+   if (jobs > 1 && files.size() > 1) {
+      ProcessPool pool(get_process_argv(argv[0], options), files, std::min<unsigned int>(jobs, files.size()));
+      return pool.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+   }
+
+   bool success = true;
+   for (const auto& file : files) {
+      if (!convert_file(file, options))
+         success = false;
+   }
+   return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace batchmode
@@ -0,0 +1,38 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm/ustring.h>
+
+// The batch mode converts subtitle files without user interface:
+//   subtitleeditor --convert=FORMAT [--output=DIR] [--step=STEP...] FILE...
+// Only the subtitle formats and the batch steps of the extensions are
+// loaded. The files are shared between several processes (--jobs).
+namespace batchmode {
+
+// Check if the batch mode is requested (--batch or --convert).
+// It must be known before the initialization of Gtk+ which needs a display.
+bool is_requested(int argc, char* argv[]);
+
+// Parse the options, convert the files and return the exit status.
+int run(int argc, char* argv[]);
+
+}  // namespace batchmode
@@ -22,6 +22,8 @@
 
 #include <glibmm.h>
 
+#include <mutex>
+
 #include "defaultcfg.h"
 #include "utility.h"
 
@@ -111,6 +113,17 @@ Glib::KeyFile& keyfile() {
    return configuration().keyfile();
 }
 
+// The configuration is also read by worker threads (encodings preferences
+// used by the charset detection), the accesses to the keyfile are locked.
+// The signals are emitted after the lock is released, a callback can then
+// wait for a worker without a deadlock.
+static std::recursive_mutex& keyfile_mutex() {
+   static std::recursive_mutex mutex;
+   return mutex;
+}
+
+typedef std::lock_guard<std::recursive_mutex> lock_guard;
+
 // connect a signal to the group, notify when a key change
 sigc::signal<void, ustring, ustring>& signal_changed(const ustring& group) {
    return configuration().signals()[group];
@@ -123,6 +136,7 @@ void emit_signal_changed(const ustring& g, const ustring& k, const ustring& v) {
 
 // check if a key exists on the group
 bool has_key(const ustring& group, const ustring& key) {
+   lock_guard lock(keyfile_mutex());
    try {
       return keyfile().has_key(group, key);
    } catch (const KeyFileError& ex) {
@@ -133,32 +147,40 @@ bool has_key(const ustring& group, const ustring& key) {
 
 // return the keys of the group
 vector<ustring> get_keys(const ustring& group) {
+   lock_guard lock(keyfile_mutex());
    return keyfile().get_keys(group);
 }
 
 // check if a group exists
 bool has_group(const ustring& group) {
+   lock_guard lock(keyfile_mutex());
    return keyfile().has_group(group);
 }
 
 // remove the group and associated keys
 void remove_group(const ustring& group) {
+   lock_guard lock(keyfile_mutex());
    keyfile().remove_group(group);
 }
 
 // set a comment to the key
 void set_comment(const ustring& g, const ustring& k, const ustring& v) {
+   lock_guard lock(keyfile_mutex());
    keyfile().set_comment(g, k, v);
 }
 
 // set the string value to the key
 void set_string(const ustring& g, const ustring& k, const ustring& v) {
-   keyfile().set_string(g, k, v);
+   {
+      lock_guard lock(keyfile_mutex());
+      keyfile().set_string(g, k, v);
+   }
    emit_signal_changed(g, k, v);
 }
 
 // return a string value of the key
 ustring get_string(const ustring& group, const ustring& key) {
+   lock_guard lock(keyfile_mutex());
    try {
       return keyfile().get_string(group, key);
    } catch (const KeyFileError& ex) {
@@ -169,6 +191,7 @@ ustring get_string(const ustring& group, const ustring& key) {
 
 // set the string values to the key
 void set_string_list(const ustring& g, const ustring& k, const vector<ustring>& v) {
+   lock_guard lock(keyfile_mutex());
    keyfile().set_string_list(g, k, v);
    // FIXME: join strings and emit signal
    // emit_signal_changed(g, k, v);
@@ -176,6 +199,7 @@ void set_string_list(const ustring& g, const ustring& k, const vector<ustring>&
 
 // return a strings value of the key
 vector<ustring> get_string_list(const ustring& group, const ustring& key) {
+   lock_guard lock(keyfile_mutex());
    try {
       return keyfile().get_string_list(group, key);
    } catch (const KeyFileError& ex) {
@@ -186,12 +210,16 @@ vector<ustring> get_string_list(const ustring& group, const ustring& key) {
 
 // set the boolean value to the key
 void set_boolean(const ustring& g, const ustring& k, const bool& v) {
-   keyfile().set_boolean(g, k, v);
+   {
+      lock_guard lock(keyfile_mutex());
+      keyfile().set_boolean(g, k, v);
+   }
    emit_signal_changed(g, k, to_string(v));
 }
 
 // return a boolean value of the key
 bool get_boolean(const ustring& group, const ustring& key) {
+   lock_guard lock(keyfile_mutex());
    try {
       return keyfile().get_boolean(group, key);
    } catch (const KeyFileError& ex) {
@@ -202,12 +230,16 @@ bool get_boolean(const ustring& group, const ustring& key) {
 
 // set the integer value to the key
 void set_int(const ustring& g, const ustring& k, const int& v) {
-   keyfile().set_integer(g, k, v);
+   {
+      lock_guard lock(keyfile_mutex());
+      keyfile().set_integer(g, k, v);
+   }
    emit_signal_changed(g, k, to_string(v));
 }
 
 // return a integer value of the key
 int get_int(const ustring& group, const ustring& key) {
+   lock_guard lock(keyfile_mutex());
    try {
       return keyfile().get_integer(group, key);
    } catch (const KeyFileError& ex) {
@@ -218,12 +250,16 @@ int get_int(const ustring& group, const ustring& key) {
 
 // set the double value to the key
 void set_double(const ustring& g, const ustring& k, const double& v) {
-   keyfile().set_double(g, k, v);
+   {
+      lock_guard lock(keyfile_mutex());
+      keyfile().set_double(g, k, v);
+   }
    emit_signal_changed(g, k, to_string(v));
 }
 
 // return a double value of the key
 double get_double(const ustring& group, const ustring& key) {
+   lock_guard lock(keyfile_mutex());
    try {
       return keyfile().get_double(group, key);
    } catch (const KeyFileError& ex) {
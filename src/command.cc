@@ -46,3 +46,21 @@ SubtitleModelPtr Command::get_document_subtitle_model() {
 SubtitleViewPtr Command::get_document_subtitle_view() {
    return document()->get_subtitle_view();
 }
+
+gsize Command::get_memory_size() const {
+   return sizeof(Command) + get_memory_size(m_description);
+}
+
+gsize Command::get_memory_size(const Glib::ustring& str) {
+   return str.bytes();
+}
+
+// Each node of the map holds two strings, the pointers of the tree and the
+// color. Count the size of the strings content in addition.
+gsize Command::get_memory_size(const std::map<Glib::ustring, Glib::ustring>& values) {
+   gsize size = sizeof(values);
+   for (const auto& v : values) {
+      size += 4 * sizeof(void*) + 2 * sizeof(Glib::ustring) + v.first.bytes() + v.second.bytes();
+   }
+   return size;
+}
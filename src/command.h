@@ -22,6 +22,8 @@
 
 #include <glibmm.h>
 
+#include <map>
+
 class Document;
 class SubtitleModel;
 class SubtitleView;
@@ -43,6 +45,15 @@ class Command {
 
    Glib::ustring description() const;
 
+   // Return an estimation of the memory (in bytes) used by the command,
+   // the undo/redo history is limited with it.
+   virtual gsize get_memory_size() const;
+
+  protected:
+   // Helpers for get_memory_size()
+   static gsize get_memory_size(const Glib::ustring& str);
+   static gsize get_memory_size(const std::map<Glib::ustring, Glib::ustring>& values);
+
   protected:
    Document* m_document;
    Glib::ustring m_description;
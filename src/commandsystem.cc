@@ -20,6 +20,8 @@
 
 #include "commandsystem.h"
 
+#include <algorithm>
+
 #include "cfg.h"
 #include "document.h"
 #include "utility.h"
@@ -71,6 +73,21 @@ void CommandGroup::add(Command* cmd) {
    m_stack.push_back(cmd);
 }
 
+Command* CommandGroup::back() {
+   if (m_stack.empty())
+      return NULL;
+   return m_stack.back();
+}
+
+gsize CommandGroup::get_memory_size() const {
+   // the commands and the nodes of the list
+   gsize size = sizeof(*this) + Command::get_memory_size(m_description);
+   for (const auto& cmd : m_stack) {
+      size += cmd->get_memory_size() + 3 * sizeof(void*);
+   }
+   return size;
+}
+
 void CommandGroup::execute() {
    se_dbg(SE_DBG_COMMAND);
 
@@ -91,6 +108,7 @@ void CommandGroup::restore() {
 // get the maximum stack to config
 CommandSystem::CommandSystem(Document& doc) : m_document(doc) {
    m_max_undo_stack = cfg::get_int("interface", "max-undo");
+   m_max_undo_memory = static_cast<gsize>(std::max(cfg::get_int("interface", "max-undo-memory"), 0)) * 1024 * 1024;
 
    cfg::signal_changed("interface").connect(sigc::mem_fun(*this, &CommandSystem::on_config_interface_changed));
 }
@@ -104,6 +122,12 @@ void CommandSystem::on_config_interface_changed(const Glib::ustring& key, const
       int max = utility::string_to_int(value);
 
       m_max_undo_stack = max;
+      limit_history();
+   } else if (key == "max-undo-memory") {
+      int max = utility::string_to_int(value);
+
+      m_max_undo_memory = static_cast<gsize>(std::max(max, 0)) * 1024 * 1024;
+      limit_history();
    }
 }
 
@@ -115,11 +139,13 @@ void CommandSystem::clear() {
 
       m_undo_stack.pop_back();
 
-      delete cmd;
+      delete_command(cmd);
    }
 
    // on efface la pile redo
    clearRedo();
+
+   m_memory_size = 0;
 }
 
 void CommandSystem::clearRedo() {
@@ -128,10 +154,46 @@ void CommandSystem::clearRedo() {
 
       m_redo_stack.pop_back();
 
-      delete cmd;
+      delete_command(cmd);
    }
 }
 
+void CommandSystem::delete_command(Command* cmd) {
+   gsize size = cmd->get_memory_size();
+
+   m_memory_size -= std::min(size, m_memory_size);
+
+   delete cmd;
+}
+
+void CommandSystem::limit_history() {
+   // Never remove the command being recorded (the last one)
+   std::deque<Command*>::size_type recording = m_is_recording ? 1 : 0;
+
+   if (m_max_undo_stack > 0) {
+      std::deque<Command*>::size_type max = m_max_undo_stack;
+
+      while (m_undo_stack.size() > std::max(max, recording)) {
+         Command* tmp = m_undo_stack.front();
+         m_undo_stack.pop_front();
+         delete_command(tmp);
+      }
+   }
+
+   // Keep at least the last finished command
+   if (m_max_undo_memory > 0) {
+      while (m_memory_size > m_max_undo_memory && m_undo_stack.size() > recording + 1) {
+         Command* tmp = m_undo_stack.front();
+         m_undo_stack.pop_front();
+         delete_command(tmp);
+      }
+   }
+}
+
+gsize CommandSystem::get_memory_size() const {
+   return m_memory_size;
+}
+
 void CommandSystem::add(Command* cmd) {
    g_return_if_fail(cmd);
 
@@ -146,15 +208,10 @@ void CommandSystem::add(Command* cmd) {
       group->add(cmd);
    } else {
       m_undo_stack.push_back(cmd);
+      m_memory_size += cmd->get_memory_size();
    }
 
-   if (m_max_undo_stack != 0) {
-      while (m_undo_stack.size() > m_max_undo_stack) {
-         Command* tmp = m_undo_stack.front();
-         m_undo_stack.pop_front();
-         delete tmp;
-      }
-   }
+   limit_history();
 }
 
 void CommandSystem::undo() {
@@ -194,7 +251,9 @@ void CommandSystem::start(const Glib::ustring& description) {
 
    m_undo_stack.push_back(new CommandGroup(description));
 
-   add(new SubtitleSelectionCommand(&m_document));
+   // Without view there's no selection to restore (batch mode)
+   if (m_document.has_subtitle_view())
+      add(new SubtitleSelectionCommand(&m_document));
 
    m_signal_changed();
 }
@@ -203,12 +262,34 @@ bool CommandSystem::is_recording() {
    return m_is_recording;
 }
 
+Command* CommandSystem::get_last_recorded_command() {
+   if (!m_is_recording || m_undo_stack.empty())
+      return NULL;
+
+   CommandGroup* group = dynamic_cast<CommandGroup*>(m_undo_stack.back());
+   if (group == NULL)
+      return NULL;
+   return group->back();
+}
+
 void CommandSystem::finish() {
-   if (m_is_recording)
-      add(new SubtitleSelectionCommand(&m_document));
+   if (m_is_recording) {
+      if (m_document.has_subtitle_view())
+         add(new SubtitleSelectionCommand(&m_document));
+
+      m_memory_size += m_undo_stack.back()->get_memory_size();
+   }
 
    m_is_recording = false;
 
+   limit_history();
+
+   se_dbg_msg(SE_DBG_COMMAND,
+              "history: %d undo, %d redo, %s",
+              (int)m_undo_stack.size(),
+              (int)m_redo_stack.size(),
+              Glib::format_size(m_memory_size).c_str());
+
    m_signal_changed();
 }
 
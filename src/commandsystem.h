@@ -34,9 +34,14 @@ class CommandGroup : public Command {
 
    void add(Command* cmd);
 
+   // Return the last command of the group or NULL.
+   Command* back();
+
    void restore();
    void execute();
 
+   gsize get_memory_size() const;
+
   protected:
    std::list<Command*> m_stack;
 };
@@ -62,6 +67,10 @@ class CommandSystem {
    // return true if it is recording. You can add your command if it's.
    bool is_recording();
 
+   // Return the last command added to the current recording or NULL.
+   // Used to extend a command instead of adding a new one.
+   Command* get_last_recorded_command();
+
    // Stop recording
    void finish();
 
@@ -74,17 +83,32 @@ class CommandSystem {
    // Clear all stack (undo/redo)
    void clear();
 
+   // Return an estimation of the memory (in bytes) used by the undo/redo
+   // history. The command being recorded is not counted until finished.
+   gsize get_memory_size() const;
+
    // emit with undo/redo/start/finish
    sigc::signal<void>& signal_changed();
 
   protected:
    void clearRedo();
 
+   // Remove the oldest commands while the history is over the maximum
+   // number of undo levels or the memory budget.
+   void limit_history();
+
+   // Delete the command and remove its size from the history.
+   void delete_command(Command* cmd);
+
    void on_config_interface_changed(const Glib::ustring& name, const Glib::ustring& value);
 
   protected:
    Document& m_document;
    int m_max_undo_stack{10};
+   // maximum memory of the history in bytes (0 unlimited)
+   gsize m_max_undo_memory{0};
+   // memory used by the finished commands of the undo/redo stacks
+   gsize m_memory_size{0};
    bool m_is_recording{false};
    std::deque<Command*> m_undo_stack;
    std::deque<Command*> m_redo_stack;
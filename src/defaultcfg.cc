@@ -62,6 +62,11 @@ void get_default_config(std::map<Glib::ustring, std::map<Glib::ustring, Glib::us
    config["waveform"]["display"] = "true";
    config["waveform"]["renderer"] = "cairo";
 
+   // [media-cache]
+   config["media-cache"]["enabled"] = "true";
+   config["media-cache"]["auto-generate"] = "true";
+   config["media-cache"]["max-size"] = "512";
+
    // [waveform-renderer]
    config["waveform-renderer"]["display-subtitle-text"] = "true";
    config["waveform-renderer"]["color-background"] = "#4C4C4CFF";
@@ -70,6 +75,7 @@ void get_default_config(std::map<Glib::ustring, std::map<Glib::ustring, Glib::us
    config["waveform-renderer"]["color-subtitle"] = "#994C1999";
    config["waveform-renderer"]["color-subtitle-selected"] = "#E57F4C99";
    config["waveform-renderer"]["color-subtitle-invalid"] = "#FFFF00CC";
+   config["waveform-renderer"]["color-subtitle-error"] = "#E5333399";
    config["waveform-renderer"]["color-text"] = "#FFFFFFFF";
    config["waveform-renderer"]["color-player-position"] = "#FFFFFFFF";
 
@@ -81,6 +87,7 @@ void get_default_config(std::map<Glib::ustring, std::map<Glib::ustring, Glib::us
    config["interface"]["create-backup-copy"] = "false";
    config["interface"]["autosave-minutes"] = "10";
    config["interface"]["max-undo"] = "200";
+   config["interface"]["max-undo-memory"] = "64";
 
    // [encodings]
    config["encodings"]["encodings"] = "ISO-8859-15;UTF-8";
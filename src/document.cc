@@ -30,11 +30,16 @@
 #include "documents.h"
 #include "encodings.h"
 #include "error.h"
+#include "filereader.h"
 #include "gui/comboboxencoding.h"
 #include "gui/dialogutility.h"
 #include "subtitleformatsystem.h"
 #include "utility.h"
 
+// Below this confidence (0-100) of the charset auto detection,
+// the user is asked to check the character coding.
+static const int charset_confidence_threshold = 60;
+
 // Constructor
 // The default values of the document are sets from the user config.
 Document::Document(bool create_new) : CommandSystem(*this), m_subtitles(*this), m_styles(*this) {
@@ -161,6 +166,17 @@ Glib::ustring Document::getCharset() {
    return m_charset;
 }
 
+// Define the confidence (0-100) of the charset auto detection.
+void Document::set_charset_confidence(int confidence) {
+   m_charset_confidence = confidence;
+}
+
+// Return the confidence (0-100) of the charset auto detection.
+// 100 if the charset was not auto detected.
+int Document::get_charset_confidence() const {
+   return m_charset_confidence;
+}
+
 // Define the newline type of the document.
 // Value can be "Unix", "Windows" or "Macintosh"
 void Document::setNewLine(const Glib::ustring& name) {
@@ -241,6 +257,12 @@ SubtitleView* Document::get_subtitle_view() {
    return m_subtitleView;
 }
 
+// Return true if the subtitle view has been created.
+// A document of the batch mode never has a view, there's no display.
+bool Document::has_subtitle_view() const {
+   return m_subtitleView != nullptr;
+}
+
 // Create an attach the subtitle view of the document.
 void Document::create_subtitle_view() {
    se_dbg(SE_DBG_APP);
@@ -301,6 +323,11 @@ Styles Document::styles() {
    return m_styles;
 }
 
+// Return the errors of the subtitles found by the background checking.
+SubtitleErrors& Document::get_subtitle_errors() {
+   return m_subtitle_errors;
+}
+
 // Command System
 
 void Document::start_command(const Glib::ustring& description) {
@@ -391,15 +418,43 @@ FRAMERATE Document::get_framerate() {
 Document* Document::create_from_file(const Glib::ustring& uri, const Glib::ustring& charset) {
    se_dbg_msg(SE_DBG_APP, "uri=%s charset=%s", uri.c_str(), charset.c_str());
 
+   try {
+      std::unique_ptr<Document> doc(new Document(false));
+      doc->setCharset(charset);
+      doc->open(uri);
+      return check_charset_confidence(doc.release());
+   } catch (...) {
+      return open_error(uri, charset, std::current_exception());
+   }
+}
+
+// Create a new document from a file already read (the reading and the
+// detection of the format can be done outside the main thread). The charset
+// is the one asked to read the file, empty for the auto detection, and the
+// format is detected if it's empty. This function display a dialog ask or
+// error if needed. Return a new document or NULL.
+Document* Document::create_from_file_reader(FileReader& reader, const Glib::ustring& charset, const Glib::ustring& format) {
+   se_dbg_msg(SE_DBG_APP, "uri=%s charset=%s", reader.get_uri().c_str(), reader.get_charset().c_str());
+
+   try {
+      std::unique_ptr<Document> doc(new Document(false));
+      doc->setCharset(reader.get_charset());
+      SubtitleFormatSystem::instance().open_from_file_reader(doc.get(), &reader, format);
+      return check_charset_confidence(doc.release());
+   } catch (...) {
+      return open_error(reader.get_uri(), charset, std::current_exception());
+   }
+}
+
+// Display the error which occurred while opening the file. If the character
+// coding is wrong the user can choose another one and the file is opened
+// again. Return a new document or NULL.
+Document* Document::open_error(const Glib::ustring& uri, const Glib::ustring& charset, std::exception_ptr error) {
    Glib::ustring filename = Glib::filename_from_uri(uri);
    Glib::ustring basename = Glib::path_get_basename(filename);
-   Glib::ustring label_charset = Encodings::get_label_from_charset(charset);
 
    try {
-      Document* doc = new Document(false);
-      doc->setCharset(charset);
-      doc->open(uri);
-      return doc;
+      std::rethrow_exception(error);
    } catch (const UnrecognizeFormatError& ex) {
       Glib::ustring title = build_message(_("Could not recognize the subtitle format for the file \"%s\"."), basename.c_str());
       Glib::ustring msg =
@@ -467,6 +522,49 @@ Document* Document::create_from_file(const Glib::ustring& uri, const Glib::ustri
    return nullptr;
 }
 
+// If the charset of the document has been auto detected with a low
+// confidence, warn the user who can choose another character coding and
+// open the file again. Return the document to use (doc or a new one).
+Document* Document::check_charset_confidence(Document* doc) {
+   if (doc->get_charset_confidence() >= charset_confidence_threshold)
+      return doc;
+
+   Glib::ustring title = build_message(_("The character coding of the file \"%s\" is uncertain."), doc->getName().c_str());
+   Glib::ustring msg = build_message(
+      _("The file has been opened using the character coding %s. "
+        "If the text is not displayed correctly, select a different character coding and open the file again."),
+      Encodings::get_label_from_charset(doc->getCharset()).c_str());
+
+   Gtk::MessageDialog dialog(title, false, Gtk::MESSAGE_WARNING, Gtk::BUTTONS_NONE, true);
+   utility::set_transient_parent(dialog);
+   dialog.set_secondary_text(msg);
+   dialog.add_button(_("_Keep"), Gtk::RESPONSE_CANCEL);
+   dialog.add_button(Gtk::Stock::OPEN, Gtk::RESPONSE_OK);
+   dialog.set_default_response(Gtk::RESPONSE_CANCEL);
+
+   // "Add or Remove..." displays DialogCharacterCodings
+   Gtk::Label labelEncoding(_("Character Coding:"), 1.0, 0.5);
+   ComboBoxEncoding comboEncoding(false);
+   comboEncoding.set_value(doc->getCharset());
+
+   Gtk::HBox hbox(false, 6);
+   dialog.get_vbox()->pack_start(hbox, false, false);
+   hbox.pack_start(labelEncoding);
+   hbox.pack_start(comboEncoding);
+
+   dialog.show_all();
+   if (dialog.run() != Gtk::RESPONSE_OK || comboEncoding.get_value() == doc->getCharset())
+      return doc;
+   dialog.hide();
+
+   Document* other = Document::create_from_file(Glib::filename_to_uri(doc->getFilename()), comboEncoding.get_value());
+   if (other == nullptr)
+      return doc;
+
+   delete doc;
+   return other;
+}
+
 // Return a signal connector from his name.
 sigc::signal<void>& Document::get_signal(const std::string& name) {
    return m_signal[name];
@@ -22,6 +22,7 @@
 
 #include <sigc++/sigc++.h>
 
+#include <exception>
 #include <map>
 #include <string>
 #include <vector>
@@ -30,10 +31,13 @@
 #include "scriptinfo.h"
 #include "stylemodel.h"
 #include "styles.h"
+#include "subtitleerrors.h"
 #include "subtitles.h"
 #include "subtitleview.h"
 #include "timeutility.h"
 
+class FileReader;
+
 typedef Glib::RefPtr<SubtitleModel> SubtitleModelPtr;
 typedef SubtitleView* SubtitleViewPtr;
 typedef std::vector<Document*> DocumentList;
@@ -49,6 +53,23 @@ class Document : protected CommandSystem {
    // if needed. Return a new document or NULL.
    static Document* create_from_file(const Glib::ustring& uri, const Glib::ustring& charset = Glib::ustring());
 
+   // Create a new document from a file already read (the reading and the
+   // detection of the format can be done outside the main thread). The charset
+   // is the one asked to read the file, empty for the auto detection, and the
+   // format is detected if it's empty. This function display a dialog ask or
+   // error if needed. Return a new document or NULL.
+   static Document* create_from_file_reader(FileReader& reader, const Glib::ustring& charset, const Glib::ustring& format = Glib::ustring());
+
+   // Display the error which occurred while opening the file. If the character
+   // coding is wrong the user can choose another one and the file is opened
+   // again. Return a new document or NULL.
+   static Document* open_error(const Glib::ustring& uri, const Glib::ustring& charset, std::exception_ptr error);
+
+   // If the charset of the document has been auto detected with a low
+   // confidence, warn the user who can choose another character coding and
+   // open the file again. Return the document to use (doc or a new one).
+   static Document* check_charset_confidence(Document* doc);
+
    // Constructor
    // The default values of the document are set from the user config.
    Document(bool create_new = true);
@@ -88,6 +109,13 @@ class Document : protected CommandSystem {
    // Return the charset of the document.
    Glib::ustring getCharset();
 
+   // Define the confidence (0-100) of the charset auto detection.
+   void set_charset_confidence(int confidence);
+
+   // Return the confidence (0-100) of the charset auto detection.
+   // 100 if the charset was not auto detected.
+   int get_charset_confidence() const;
+
    // Define the newline type of the document.
    // Value can be "Unix", "Windows" or "Macintosh"
    void setNewLine(const Glib::ustring& name);
@@ -138,6 +166,9 @@ class Document : protected CommandSystem {
    // Return a Styles manager of the document.
    Styles styles();
 
+   // Return the errors of the subtitles found by the background checking.
+   SubtitleErrors& get_subtitle_errors();
+
    // Command System
 
    // The document has changed (start_command and finish_command are used)
@@ -215,6 +246,8 @@ class Document : protected CommandSystem {
    //  one or more styles have been removed.
    // "style-inserted"
    //  one or more styles have been created.
+   // "subtitle-errors-changed"
+   //  the errors of the subtitles (get_subtitle_errors) have been updated.
    sigc::signal<void>& get_signal(const std::string& name);
 
    // Emit a signal from its name.
@@ -237,6 +270,10 @@ class Document : protected CommandSystem {
    // Return the (Gtk) subtitle view of the document.
    SubtitleViewPtr get_subtitle_view();
 
+   // Return true if the subtitle view has been created.
+   // A document of the batch mode never has a view, there's no display.
+   bool has_subtitle_view() const;
+
    // Create an attach the subtitle view of the document.
    void create_subtitle_view();
 
@@ -249,6 +286,8 @@ class Document : protected CommandSystem {
    Glib::ustring m_format;
    // Charset of the document (default "UTF-8")
    Glib::ustring m_charset;
+   // Confidence of the charset auto detection (0-100)
+   int m_charset_confidence{100};
    // Internally we always use the '\n'
    // this is only use for the export
    Glib::ustring m_newline;
@@ -266,6 +305,8 @@ class Document : protected CommandSystem {
    Styles m_styles;
    // ScriptInfo attached to the document
    ScriptInfo m_scriptInfo;
+   // Errors of the subtitles, by row
+   SubtitleErrors m_subtitle_errors;
    // StyleModel attached to the document
    Glib::RefPtr<StyleModel> m_styleModel;
    // SubtitleView attached to the document
@@ -0,0 +1,214 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "documentloader.h"
+
+#include <algorithm>
+
+#include "document.h"
+#include "documents.h"
+#include "gui/dialogutility.h"
+#include "subtitleformatsystem.h"
+#include "utility.h"
+
+// Constructor
+DocumentLoader::DocumentLoader() {
+   m_dispatcher.connect(sigc::mem_fun(*this, &DocumentLoader::on_file_ready));
+}
+
+// Destructor
+// Cancel the files not read and wait for the worker threads.
+DocumentLoader::~DocumentLoader() {
+   stop();
+}
+
+// Add a file to open.
+// If charset is empty, the automatically detection is used.
+// Return false if the file is already open, the document flashes a message.
+bool DocumentLoader::add(const Glib::ustring& uri, const Glib::ustring& charset) {
+   g_return_val_if_fail(m_threads.empty(), false);
+
+   // check if is not already open
+   Document* already = se::documents::find_by_name(Glib::filename_from_uri(uri));
+   if (already) {
+      already->flash_message(_("I am already open"));
+      return false;
+   }
+
+   Job job;
+   job.uri = uri;
+   job.charset = charset;
+   m_jobs.push_back(std::move(job));
+   return true;
+}
+
+// Open the files and append the documents (se::documents).
+// Return the number of documents opened.
+unsigned int DocumentLoader::run() {
+   se_dbg_msg(SE_DBG_APP, "open %d files", static_cast<int>(m_jobs.size()));
+
+   // Nothing to share with a worker
+   if (m_jobs.size() == 1) {
+      Document* doc = Document::create_from_file(m_jobs[0].uri, m_jobs[0].charset);
+      if (doc == nullptr)
+         return 0;
+      se::documents::append(doc);
+      return 1;
+   }
+
+   if (m_jobs.empty())
+      return 0;
+
+   unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+   count = std::min(count, static_cast<unsigned int>(m_jobs.size()));
+   for (unsigned int i = 0; i < count; ++i) {
+      m_threads.push_back(std::thread(&DocumentLoader::read_files, this));
+   }
+
+   m_dialog.reset(new ProgressDialog(_("Opening Files")));
+   m_dialog->set_progress(0, build_message(_("%d of %d files"), 0, static_cast<int>(m_jobs.size())));
+
+   // The dialog is closed by on_file_ready when the last document is appended
+   if (m_dialog->run() != Gtk::RESPONSE_OK) {
+      se_dbg_msg(SE_DBG_APP, "the loading is cancelled");
+   }
+   m_dialog.reset();
+
+   stop();
+   finish_cancelled();
+
+   return m_opened;
+}
+
+// Open the files in a worker thread until there are no more or the
+// loading is cancelled.
+void DocumentLoader::read_files() {
+   while (!m_cancelled) {
+      std::vector<Job>::size_type index;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_next_read >= m_jobs.size())
+            return;
+         index = m_next_read++;
+      }
+
+      read_file(m_jobs[index]);
+      m_dispatcher.emit();
+   }
+}
+
+// Read the file and detect its format, nothing from the user interface
+// or the documents is used.
+void DocumentLoader::read_file(Job& job) {
+   std::unique_ptr<FileReader> reader;
+   Glib::ustring format;
+   std::exception_ptr error;
+   try {
+      reader.reset(new FileReader(job.uri, job.charset));
+      format = SubtitleFormatSystem::instance().get_subtitle_format_from_file_reader(reader.get());
+   } catch (...) {
+      reader.reset();
+      error = std::current_exception();
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   job.format = format;
+   job.reader = std::move(reader);
+   job.error = error;
+   job.ready = true;
+}
+
+// Append the documents of the files ready, in the order of the files.
+void DocumentLoader::on_file_ready() {
+   // An error dialog can be displayed by create_document, the next files
+   // are handled when it returns.
+   if (m_creating || !m_dialog)
+      return;
+
+   m_creating = true;
+   while (m_next_document < m_jobs.size() && m_dialog) {
+      Job& job = m_jobs[m_next_document];
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (!job.ready)
+            break;
+      }
+      ++m_next_document;
+
+      create_document(job);
+
+      m_dialog->set_progress(static_cast<double>(m_next_document) / static_cast<double>(m_jobs.size()),
+                             build_message(_("%d of %d files"), static_cast<int>(m_next_document), static_cast<int>(m_jobs.size())));
+   }
+   m_creating = false;
+
+   if (m_next_document == m_jobs.size() && m_dialog)
+      m_dialog->response(Gtk::RESPONSE_OK);
+}
+
+// Create and append the document of the file read or display the error.
+void DocumentLoader::create_document(Job& job) {
+   se_dbg_msg(SE_DBG_APP, "uri=%s", job.uri.c_str());
+
+   Document* doc = nullptr;
+   if (job.reader)
+      doc = Document::create_from_file_reader(*job.reader, job.charset, job.format);
+   else
+      doc = Document::open_error(job.uri, job.charset, job.error);
+
+   // The contents are no longer needed
+   job.reader.reset();
+
+   if (doc == nullptr)
+      return;
+
+   se::documents::append(doc);
+   ++m_opened;
+}
+
+// Stop the worker threads, the files not read are skipped.
+void DocumentLoader::stop() {
+   m_cancelled = true;
+
+   for (auto& thread : m_threads) {
+      thread.join();
+   }
+   m_threads.clear();
+}
+
+// After a cancel, report the files which have not been opened.
+void DocumentLoader::finish_cancelled() {
+   std::vector<Glib::ustring> skipped;
+   for (; m_next_document < m_jobs.size(); ++m_next_document) {
+      Job& job = m_jobs[m_next_document];
+      skipped.push_back(Glib::path_get_basename(Glib::filename_from_uri(job.uri)));
+      job.reader.reset();
+   }
+
+   if (skipped.empty())
+      return;
+
+   Glib::ustring files;
+   for (const auto& name : skipped) {
+      files += name + "\n";
+   }
+   int count = static_cast<int>(skipped.size());
+   dialog_warning(build_message(ngettext("1 file has not been opened.", "%d files have not been opened.", count), count), files);
+}
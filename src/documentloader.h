@@ -0,0 +1,101 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm.h>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "filereader.h"
+
+class ProgressDialog;
+
+// Open several subtitle files without blocking the user interface.
+// The files are read, their character coding detected and converted to UTF-8
+// and their format detected by worker threads. The documents (models, signals,
+// config) belong to the main thread, they are created and parsed there as
+// soon as a file is ready, in the order of the files. With several files,
+// a dialog shows the progress and allows to cancel.
+class DocumentLoader {
+  public:
+   // Constructor
+   DocumentLoader();
+
+   // Destructor
+   // Cancel the files not read and wait for the worker threads.
+   ~DocumentLoader();
+
+   // Add a file to open.
+   // If charset is empty, the automatically detection is used.
+   // Return false if the file is already open, the document flashes a message.
+   bool add(const Glib::ustring& uri, const Glib::ustring& charset = Glib::ustring());
+
+   // Open the files and append the documents (se::documents).
+   // Return the number of documents opened.
+   unsigned int run();
+
+  protected:
+   struct Job {
+      Glib::ustring uri;
+      Glib::ustring charset;
+      Glib::ustring format;
+      std::unique_ptr<FileReader> reader;
+      std::exception_ptr error;
+      bool ready{false};
+   };
+
+   // Open the files in a worker thread until there are no more or the
+   // loading is cancelled.
+   void read_files();
+
+   // Read the file and detect its format, nothing from the user interface
+   // or the documents is used.
+   void read_file(Job& job);
+
+   // Append the documents of the files ready, in the order of the files.
+   void on_file_ready();
+
+   // Create and append the document of the file read or display the error.
+   void create_document(Job& job);
+
+   // Stop the worker threads, the files not read are skipped.
+   void stop();
+
+   // After a cancel, report the files which have not been opened.
+   void finish_cancelled();
+
+  protected:
+   std::vector<Job> m_jobs;
+   std::vector<Job>::size_type m_next_read{0};
+   std::vector<Job>::size_type m_next_document{0};
+   std::mutex m_mutex;
+   std::atomic<bool> m_cancelled{false};
+   std::vector<std::thread> m_threads;
+   Glib::Dispatcher m_dispatcher;
+   std::unique_ptr<ProgressDialog> m_dialog;
+   bool m_creating{false};
+   unsigned int m_opened{0};
+};
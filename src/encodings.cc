@@ -20,6 +20,11 @@
 
 #include "encodings.h"
 
+#include <errno.h>
+
+#include <algorithm>
+#include <map>
+
 #include "cfg.h"
 #include "error.h"
 #include "utility.h"
@@ -155,7 +160,7 @@ Glib::ustring convert_to_utf8_from_charset(const std::string& content, const Gli
    Glib::ustring utf8_content;
    // Only if it's UTF-8 to UTF-8
    if (m_charset == "UTF-8") {
-      if (Glib::ustring(content).validate() == false)
+      if (g_utf8_validate(content.data(), content.size(), NULL) == FALSE)
          throw EncodingConvertError(_("It's not valid UTF-8."));
 
       utf8_content = content;
@@ -184,69 +189,267 @@ Glib::ustring convert_to_utf8_from_charset(const std::string& content, const Gli
    return utf8_content;
 }
 
-// Trying to autodetect the charset and convert to UTF-8.
-// 3 steps:
-// - Try UTF-8
-// - Try with user encoding preferences
-// - Try with all encodings
-// Return utf8 string and sets charset found
-// or throw EncodingConvertError exception.
-Glib::ustring convert_to_utf8(const std::string& content, Glib::ustring& charset) {
+// Maximum size (bytes) of the sample used to score the charsets.
+// A few lines of subtitles are enough to decide.
+static const std::string::size_type detection_sample_size = 4 * 1024;
+
+// Score from which a user encoding is chosen without trying the others.
+static const double detection_confident_score = 0.9;
+
+// Convert the sample to UTF-8 with iconv. An incomplete sequence at the end is
+// ignored, the sample can be cut in the middle of a character.
+// Return false if the charset is unknown or the sample is invalid.
+static bool convert_sample_to_utf8(const std::string& sample, const gchar* charset, std::string& utf8) {
+   GIConv cd = g_iconv_open("UTF-8", charset);
+   if (cd == (GIConv)-1)
+      return false;
+
+   utf8.resize(sample.size() * 4 + 16);
+
+   gchar* inbuf = const_cast<gchar*>(sample.data());
+   gsize inbytes_left = sample.size();
+   gchar* outbuf = &utf8[0];
+   gsize outbytes_left = utf8.size();
+
+   gsize res = g_iconv(cd, &inbuf, &inbytes_left, &outbuf, &outbytes_left);
+   bool valid = (res != (gsize)-1 || errno == EINVAL);
+
+   g_iconv_close(cd);
+
+   utf8.resize(utf8.size() - outbytes_left);
+
+   return valid && !utf8.empty() && g_utf8_validate(utf8.data(), utf8.size(), NULL);
+}
+
+// Score the characters of the sample converted to UTF-8, the higher the more
+// likely the charset is. Only the non-ASCII characters are considered:
+// - control, unassigned and private characters are unlikely,
+// - letters of the main script of the text are likely,
+// - a Latin letter in a run of non-ASCII letters is unlikely (latin
+//   languages mix them with ASCII letters, a text converted with a wrong
+//   single byte charset does not),
+// - an uppercase letter just after a lowercase letter is unlikely.
+// Return a value <= 1.0, sets non_ascii to the number of characters scored.
+static double score_sample(const std::string& utf8, int& non_ascii) {
+   std::map<GUnicodeScript, int> letters;
+   int total_letters = 0, unlikely = 0;
+
+   non_ascii = 0;
+
+   const gchar* end = utf8.data() + utf8.size();
+   gunichar prev = 0;
+
+   for (const gchar* p = utf8.data(); p < end; p = g_utf8_next_char(p)) {
+      gunichar c = g_utf8_get_char(p);
+
+      if (c < 0x80) {
+         prev = c;
+         continue;
+      }
+
+      ++non_ascii;
+
+      GUnicodeType type = g_unichar_type(c);
+      if (type == G_UNICODE_CONTROL || type == G_UNICODE_UNASSIGNED || type == G_UNICODE_PRIVATE_USE ||
+          type == G_UNICODE_SURROGATE || c == 0xFFFD) {
+         unlikely += 4;
+      } else if (g_unichar_isalpha(c)) {
+         GUnicodeScript script = g_unichar_get_script(c);
+
+         if (g_unichar_isupper(c) && g_unichar_islower(prev))
+            ++unlikely;
+
+         if (script == G_UNICODE_SCRIPT_LATIN) {
+            const gchar* next_p = g_utf8_next_char(p);
+            gunichar next = (next_p < end) ? g_utf8_get_char(next_p) : 0;
+
+            bool ascii_neighbour = (prev < 0x80 && g_ascii_isalpha(prev)) || (next < 0x80 && g_ascii_isalpha(next));
+            bool other_neighbour = (prev >= 0x80 && g_unichar_isalpha(prev)) || (next >= 0x80 && g_unichar_isalpha(next));
+            if (other_neighbour && !ascii_neighbour) {
+               ++unlikely;
+               prev = c;
+               continue;
+            }
+         }
+         ++letters[script];
+         ++total_letters;
+      }
+      prev = c;
+   }
+
+   if (non_ascii == 0)
+      return 0.0;
+
+   int main_script = 0;
+   for (const auto& l : letters) main_script = std::max(main_script, l.second);
+
+   // letters of other scripts than the main one are unlikely
+   return double(main_script - (total_letters - main_script) - unlikely) / non_ascii;
+}
+
+// Detect the charset of the content without converting it.
+// - BOM (UTF-8, UTF-16)
+// - Validity scan of UTF-8
+// - Score of the user encodings preferences and all encodings on a bounded
+//   sample (conversion of the sample and distribution of the characters),
+//   a user encoding with a high score stops the detection
+// Return the charset and sets confidence (0-100), or an empty string if no
+// charset can convert the sample.
+Glib::ustring detect_charset(const std::string& content, int& confidence) {
+   confidence = 0;
+
    if (content.empty())
       return Glib::ustring();
 
-   // First check if it's not UTF-8.
-   se_dbg_msg(SE_DBG_UTILITY, "Trying to UTF-8...");
+   const bool utf8_valid = g_utf8_validate(content.data(), content.size(), NULL);
 
-   try {
-      Glib::ustring utf8_content = Encoding::convert_to_utf8_from_charset(content, "UTF-8");
+   // BOM
+   if (content.compare(0, 3, "\xEF\xBB\xBF") == 0 && utf8_valid) {
+      confidence = 100;
+      return "UTF-8";
+   }
+   if (content.compare(0, 2, "\xFF\xFE") == 0 || content.compare(0, 2, "\xFE\xFF") == 0) {
+      confidence = 100;
+      return "UTF-16";
+   }
 
-      if (utf8_content.validate() && utf8_content.empty() == false) {
-         charset = "UTF-8";
-         return utf8_content;
+   // UTF-8, a random text in another charset is almost never valid
+   if (utf8_valid) {
+      confidence = 100;
+      return "UTF-8";
+   }
+
+   // Sample, cut after the last complete line when it's possible
+   std::string sample = content.substr(0, detection_sample_size);
+   if (sample.size() < content.size()) {
+      std::string::size_type newline = sample.find_last_of('\n');
+      if (newline != std::string::npos)
+         sample.resize(newline + 1);
+   }
+
+   // The user preferences first, on the same score they win
+   std::vector<Glib::ustring> candidates;
+   for (const auto& enc : cfg::get_string_list("encodings", "encodings")) candidates.push_back(enc);
+   const std::vector<Glib::ustring>::size_type n_user_candidates = candidates.size();
+   for (unsigned int i = 0; encodings_info[i].name != NULL; ++i) candidates.push_back(encodings_info[i].charset);
+
+   // The wide charsets decode almost anything, without NUL it's not one of them
+   const bool has_nul = (sample.find('\0') != std::string::npos);
+
+   Glib::ustring best;
+   double best_score = 0.0;
+   int best_non_ascii = 0;
+   std::vector<Glib::ustring> tried;
+   std::string utf8;
+
+   for (std::vector<Glib::ustring>::size_type i = 0; i < candidates.size(); ++i) {
+      const Glib::ustring& charset = candidates[i];
+      if (charset == "UTF-8" || charset == "UTF-8-BOM")
+         continue;
+      if (!has_nul && (charset == "UTF-16" || charset == "UCS-2" || charset == "UCS-4"))
+         continue;
+      if (std::find(tried.begin(), tried.end(), charset) != tried.end())
+         continue;
+      tried.push_back(charset);
+
+      if (!convert_sample_to_utf8(sample, charset.c_str(), utf8))
+         continue;
+
+      int non_ascii = 0;
+      double score = score_sample(utf8, non_ascii);
+
+      se_dbg_msg(SE_DBG_UTILITY, "charset %s score %f", charset.c_str(), score);
+
+      if (best.empty() || score > best_score) {
+         best = charset;
+         best_score = score;
+         best_non_ascii = non_ascii;
       }
-   } catch (const EncodingConvertError& ex) {
-      se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
+
+      // the user encoding decodes the sample well, the others aren't tried
+      if (i < n_user_candidates && non_ascii > 0 && score >= detection_confident_score)
+         break;
    }
 
-   // Try to automatically detect the encoding
+   if (!best.empty()) {
+      // no character to decide on in the sample, it's a guess
+      confidence = (best_non_ascii == 0) ? 50 : CLAMP(int(best_score * 100), 0, 100);
+   }
 
-   // With the user charset preferences...
-   se_dbg_msg(SE_DBG_UTILITY, "Trying with user encodings preferences...");
+   se_dbg_msg(SE_DBG_UTILITY, "detected charset '%s' confidence %d", best.c_str(), confidence);
+
+   return best;
+}
 
-   auto user_encodings = cfg::get_string_list("encodings", "encodings");
+// Trying to autodetect the charset and convert to UTF-8.
+// The charset is detected with detect_charset then the content is converted
+// once. If it fails, try with the user encodings preferences then all
+// encodings.
+// Return utf8 string and sets charset found (and the confidence 0-100)
+// or throw EncodingConvertError exception.
+Glib::ustring convert_to_utf8(const std::string& content, Glib::ustring& charset) {
+   int confidence = 0;
+   return convert_to_utf8(content, charset, confidence);
+}
 
-   for (const auto& enc : user_encodings) {
+Glib::ustring convert_to_utf8(const std::string& content, Glib::ustring& charset, int& confidence) {
+   confidence = 0;
+
+   if (content.empty())
+      return Glib::ustring();
+
+   Glib::ustring detected = detect_charset(content, confidence);
+
+   if (!detected.empty()) {
       try {
-         Glib::ustring utf8_content = convert_to_utf8_from_charset(content, enc);
+         Glib::ustring utf8_content = Encoding::convert_to_utf8_from_charset(content, detected);
 
-         if (utf8_content.validate() && utf8_content.empty() == false) {
-            charset = enc;
+         if (utf8_content.empty() == false) {
+            charset = detected;
             return utf8_content;
          }
       } catch (const EncodingConvertError& ex) {
-         // invalid, try with the next...
+         // the sample is valid but not the whole content
          se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
       }
    }
 
-   // With all charset...
-   se_dbg_msg(SE_DBG_UTILITY, "Trying with all encodings...");
+   confidence = 0;
 
-   for (unsigned int i = 0; encodings_info[i].name != NULL; ++i) {
-      Glib::ustring it = encodings_info[i].charset;
+   Glib::ustring utf8_content;
 
+   // UTF-8 has been checked on the whole content by detect_charset
+   auto try_charset = [&](const Glib::ustring& enc) {
+      if (enc == detected || enc == "UTF-8" || enc == "UTF-8-BOM")
+         return false;
       try {
-         Glib::ustring utf8_content = Encoding::convert_to_utf8_from_charset(content, it);
+         utf8_content = convert_to_utf8_from_charset(content, enc);
 
-         if (utf8_content.validate() && utf8_content.empty() == false) {
-            charset = it;
-            return utf8_content;
+         if (utf8_content.empty() == false) {
+            charset = enc;
+            return true;
          }
       } catch (const EncodingConvertError& ex) {
          // invalid, try with the next...
          se_dbg_msg(SE_DBG_UTILITY, "EncodingConvertError: %s", ex.what());
       }
+      return false;
+   };
+
+   // With the user charset preferences...
+   se_dbg_msg(SE_DBG_UTILITY, "Trying with user encodings preferences...");
+
+   for (const auto& enc : cfg::get_string_list("encodings", "encodings")) {
+      if (try_charset(enc))
+         return utf8_content;
+   }
+
+   // With all charset...
+   se_dbg_msg(SE_DBG_UTILITY, "Trying with all encodings...");
+
+   for (unsigned int i = 0; encodings_info[i].name != NULL; ++i) {
+      if (try_charset(encodings_info[i].charset))
+         return utf8_content;
    }
 
    // Failed to determine the encoding...
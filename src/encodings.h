@@ -52,14 +52,23 @@ namespace Encoding {
 // Return utf8 string or throw EncodingConvertError exception.
 Glib::ustring convert_to_utf8_from_charset(const std::string& content, const Glib::ustring& charset);
 
+// Detect the charset of the content without converting it.
+// - BOM (UTF-8, UTF-16)
+// - Validity scan of UTF-8
+// - Score of the user encodings preferences and all encodings on a bounded
+//   sample (conversion of the sample and distribution of the characters)
+// Return the charset and sets confidence (0-100), or an empty string if no
+// charset can convert the sample.
+Glib::ustring detect_charset(const std::string& content, int& confidence);
+
 // Trying to autodetect the charset and convert to UTF-8.
-// 3 steps:
-// - Try UTF-8
-// - Try with user encoding preferences
-// - Try with all encodings
-// Return utf8 string and sets charset found
+// The charset is detected with detect_charset then the content is converted
+// once. If it fails, try with the user encodings preferences then all
+// encodings.
+// Return utf8 string and sets charset found (and the confidence 0-100)
 // or throw EncodingConvertError exception.
 Glib::ustring convert_to_utf8(const std::string& content, Glib::ustring& charset);
+Glib::ustring convert_to_utf8(const std::string& content, Glib::ustring& charset, int& confidence);
 
 // Convert the UTF-8 text to the charset.
 // Throw EncodingConvertError exception.
@@ -37,3 +37,11 @@ class Extension {
    extern "C" Extension* extension_register() { \
       return new classname;                     \
    }
+
+// Optional entry point of a module, called by the batch mode instead of
+// creating the extension. The function registers the steps provided by the
+// module (see se::batch::register_step), no user interface is available.
+#define REGISTER_BATCH_STEPS(function)                 \
+   extern "C" void extension_register_batch_steps() { \
+      function();                                     \
+   }
@@ -23,6 +23,7 @@
 #include <glibmm.h>
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "cfg.h"
@@ -76,6 +77,25 @@ void ExtensionManager::create_extensions() {
    }
 }
 
+// Active only the subtitle formats and register the batch steps of
+// the other extensions. Used by the batch mode, without user interface.
+void ExtensionManager::create_batch_extensions() {
+   se_dbg(SE_DBG_APP);
+
+   for (const auto& ext_info : get_extension_info_list()) {
+      // Unknown extension are enabled by default, but the state is not saved
+      if (cfg::has_key("extension-manager", ext_info->get_name())) {
+         if (cfg::get_string("extension-manager", ext_info->get_name()) != "enable")
+            continue;
+      }
+
+      if (ext_info->get_categorie() == "subtitleformat")
+         activate(ext_info);
+      else if (ext_info->get_type() == "module")
+         open_batch_module(ext_info);
+   }
+}
+
 // Delete and close all extensions
 void ExtensionManager::destroy_extensions() {
    se_dbg(SE_DBG_APP);
@@ -334,6 +354,36 @@ void ExtensionManager::open_module(ExtensionInfo* info) {
 
    typedef Extension* (*ExtensionRegisterFunc)(void);
 
+   Glib::Module* module = load_module(info);
+
+   // Get the register function
+   void* func = nullptr;
+   if (module->get_symbol("extension_register", func) == false) {
+      throw SubtitleError(Glib::ustring::compose("Failed to get the extension_register function: %1", Glib::Module::get_last_error()));
+   }
+
+   // Fix: bug #12651 : 0.30.0 build error
+   // ExtensionRegisterFunc extension_register = (ExtensionRegisterFunc)func;
+   ExtensionRegisterFunc extension_register = reinterpret_cast<ExtensionRegisterFunc>(func);
+
+   if (extension_register == NULL)
+      throw SubtitleError("reinterpret from the function to the ExtensionRegisterFunc failed");
+
+   // create the extension
+   Extension* ext = extension_register();
+
+   if (ext == NULL)
+      throw SubtitleError("Could not create Extension, extension_register return NULL");
+
+   info->module = module;
+   info->extension = ext;
+
+   se_dbg_msg(SE_DBG_APP, "Opening and the creating the extension from the module is a success");
+}
+
+// Open the module of the extension.
+// If failed return a SubtitleError.
+Glib::Module* ExtensionManager::load_module(ExtensionInfo* info) {
    Glib::ustring dirname = Glib::path_get_dirname(info->file);
 
    // It's only used for reading plugin without installing SE
@@ -357,28 +407,31 @@ void ExtensionManager::open_module(ExtensionInfo* info) {
    if (!*module) {
       throw SubtitleError(Glib::ustring::compose("Failed to create the Glib::Module: %1", Glib::Module::get_last_error()));
    }
+   return module;
+}
 
-   // Get the register function
-   void* func = nullptr;
-   if (module->get_symbol("extension_register", func) == false) {
-      throw SubtitleError(Glib::ustring::compose("Failed to get the extension_register function: %1", Glib::Module::get_last_error()));
-   }
-
-   // Fix: bug #12651 : 0.30.0 build error
-   // ExtensionRegisterFunc extension_register = (ExtensionRegisterFunc)func;
-   ExtensionRegisterFunc extension_register = reinterpret_cast<ExtensionRegisterFunc>(func);
+// Open the module and register its batch steps without creating
+// the extension. The module is closed if it doesn't provide any.
+void ExtensionManager::open_batch_module(ExtensionInfo* info) {
+   se_dbg_msg(SE_DBG_APP, "extension '%s'", info->get_name().c_str());
 
-   if (extension_register == NULL)
-      throw SubtitleError("reinterpret from the function to the ExtensionRegisterFunc failed");
+   typedef void (*BatchStepsRegisterFunc)(void);
 
-   // create the extension
-   Extension* ext = extension_register();
+   try {
+      std::unique_ptr<Glib::Module> module(load_module(info));
 
-   if (ext == NULL)
-      throw SubtitleError("Could not create Extension, extension_register return NULL");
+      void* func = nullptr;
+      if (module->get_symbol("extension_register_batch_steps", func) == false) {
+         se_dbg_msg(SE_DBG_APP, "the extension doesn't provide batch steps");
+         return;
+      }
 
-   info->module = module;
-   info->extension = ext;
+      BatchStepsRegisterFunc extension_register_batch_steps = reinterpret_cast<BatchStepsRegisterFunc>(func);
+      extension_register_batch_steps();
 
-   se_dbg_msg(SE_DBG_APP, "Opening and the creating the extension from the module is a success");
+      info->module = module.release();
+   } catch (const SubtitleError& ex) {
+      se_dbg_msg(SE_DBG_APP, "open the module failed: %s", ex.what());
+      std::cerr << ex.what() << std::endl;
+   }
 }
@@ -45,6 +45,10 @@ class ExtensionManager {
    // Active and create extensions
    void create_extensions();
 
+   // Active only the subtitle formats and register the batch steps of
+   // the other extensions. Used by the batch mode, without user interface.
+   void create_batch_extensions();
+
    // Delete and close all extensions
    void destroy_extensions();
 
@@ -74,6 +78,14 @@ class ExtensionManager {
    // If failed return a SubtitleError.
    void open_module(ExtensionInfo* info);
 
+   // Open the module of the extension.
+   // If failed return a SubtitleError.
+   Glib::Module* load_module(ExtensionInfo* info);
+
+   // Open the module and register its batch steps without creating
+   // the extension. The module is closed if it doesn't provide any.
+   void open_batch_module(ExtensionInfo* info);
+
   protected:
    typedef std::map<Glib::ustring, std::list<ExtensionInfo*> > ExtensionInfoMap;
 
@@ -22,46 +22,92 @@
 
 #include <giomm.h>
 
+#include <algorithm>
+
 #include "debug.h"
 #include "encodings.h"
 #include "error.h"
 
+// Read the raw contents of a local file from a memory mapping, only the pages
+// needed are read (max_data_size) and there is no intermediate buffer.
+// Return false if the file is not local or can not be mapped.
+static bool get_raw_contents_from_mapped_file(Glib::RefPtr<Gio::File> file, std::string& content, int max_data_size) {
+   std::string filename = file->get_path();
+   if (filename.empty())
+      return false;
+
+   GMappedFile* mapped = g_mapped_file_new(filename.c_str(), FALSE, NULL);
+   if (mapped == NULL)
+      return false;
+
+   gsize size = g_mapped_file_get_length(mapped);
+   const gchar* data = g_mapped_file_get_contents(mapped);
+
+   if (max_data_size > 0 && size > static_cast<gsize>(max_data_size))
+      size = max_data_size;
+
+   if (data != NULL)
+      content.assign(data, size);
+
+   g_mapped_file_unref(mapped);
+   return true;
+}
+
 // Reads an entire file into a string, with good error checking.
-// If charset is empty, auto detection is try.
-bool get_contents_from_file(
-   const Glib::ustring& uri, const Glib::ustring& charset, Glib::ustring& utf8_contents, Glib::ustring& charset_contents, int max_data_size) {
+// If charset is empty, auto detection is try and confidence (0-100) is set.
+bool get_contents_from_file(const Glib::ustring& uri,
+                            const Glib::ustring& charset,
+                            Glib::ustring& utf8_contents,
+                            Glib::ustring& charset_contents,
+                            int& confidence,
+                            int max_data_size) {
    se_dbg_msg(SE_DBG_IO, "Try to get contents from file uri=%s with charset=%s", uri.c_str(), charset.c_str());
 
    try {
-      Glib::ustring content;
+      std::string content;
 
       {
          Glib::RefPtr<Gio::File> file = Gio::File::create_for_uri(uri);
          if (!file)
             throw IOFileError(_("Couldn't open the file."));
 
-         gchar* raw = NULL;
-         gsize bytes_read = 0;
-         std::string e_tag;
+         if (!get_raw_contents_from_mapped_file(file, content, max_data_size)) {
+            gchar* raw = NULL;
+            gsize bytes_read = 0;
+            std::string e_tag;
+
+            if (file->load_contents(raw, bytes_read, e_tag) == false)
+               throw IOFileError(_("Couldn't read the contents of the file."));
 
-         if (file->load_contents(raw, bytes_read, e_tag) == false)
-            throw IOFileError(_("Couldn't read the contents of the file."));
+            if (max_data_size > 0 && bytes_read > static_cast<gsize>(max_data_size))
+               bytes_read = max_data_size;
 
-         content = std::string(raw, bytes_read);
+            content.assign(raw, bytes_read);
 
-         g_free(raw);
+            g_free(raw);
+         }
       }
 
-      if (max_data_size > 0) {
-         if (content.size() > max_data_size)
-            content = content.substr(0, max_data_size);
+      // Do not cut an UTF-8 character in the middle, the UTF-8 check would
+      // fail. Drop the last character only if it's incomplete, a character
+      // is 4 bytes at most.
+      if (max_data_size > 0 && content.size() == static_cast<std::string::size_type>(max_data_size)) {
+         const gchar* end = content.data() + content.size();
+         const gchar* lower = end - std::min<std::string::size_type>(content.size(), 4);
+         const gchar* last = g_utf8_find_prev_char(lower, end);
+         if (last != NULL && last + g_utf8_skip[static_cast<unsigned char>(*last)] > end)
+            content.resize(last - content.data());
       }
 
       if (charset.empty()) {
          // Try to autodetect
-         utf8_contents = Encoding::convert_to_utf8(content, charset_contents);
+         utf8_contents = Encoding::convert_to_utf8(content, charset_contents, confidence);
 
-         se_dbg_msg(SE_DBG_IO, "Success to get the contents of the file %s with %s charset", uri.c_str(), charset_contents.c_str());
+         se_dbg_msg(SE_DBG_IO,
+                    "Success to get the contents of the file %s with %s charset (confidence %d)",
+                    uri.c_str(),
+                    charset_contents.c_str(),
+                    confidence);
 
          return true;
       } else {
@@ -83,7 +129,7 @@ bool get_contents_from_file(
 // If charset is empty, try to autodetect the character coding.
 // Error: throw an IOFileError exception if failed.
 FileReader::FileReader(const Glib::ustring& uri, const Glib::ustring& charset, int max_data_size) : Reader(), m_charset("UTF-8") {
-   if (get_contents_from_file(uri, charset, m_data, m_charset, max_data_size) == false)
+   if (get_contents_from_file(uri, charset, m_data, m_charset, m_charset_confidence, max_data_size) == false)
       return;
 
    m_uri = uri;
@@ -98,3 +144,8 @@ Glib::ustring FileReader::get_uri() const {
 Glib::ustring FileReader::get_charset() const {
    return m_charset;
 }
+
+// Return the confidence (0-100) of the charset auto detection.
+int FileReader::get_charset_confidence() const {
+   return m_charset_confidence;
+}
@@ -45,7 +45,12 @@ class FileReader : public Reader {
    // Return the charset of the file.
    Glib::ustring get_charset() const;
 
+   // Return the confidence (0-100) of the charset auto detection.
+   // 100 if the charset was not auto detected.
+   int get_charset_confidence() const;
+
   protected:
    Glib::ustring m_uri;
    Glib::ustring m_charset;
+   int m_charset_confidence{100};
 };
@@ -28,6 +28,7 @@
 #endif
 
 #include "application.h"
+#include "documentloader.h"
 #include "documents.h"
 #include "encodings.h"
 #include "extension.h"
@@ -386,7 +387,11 @@ void Application::connect_document(Document* doc) {
 
       m_document_connections.push_back(doc->get_signal_flash_message().connect(sigc::mem_fun(m_statusbar, &Statusbar::flash_message)));
 
+      m_document_connections.push_back(
+         doc->get_signal("subtitle-errors-changed").connect(sigc::bind(sigc::mem_fun(*this, &Application::update_subtitle_errors), doc)));
+
       update_title(doc);
+      update_subtitle_errors(doc);
    }
 }
 
@@ -394,6 +399,7 @@ void Application::disconnect_document(Document* doc) {
    se_dbg(SE_DBG_APP);
 
    update_title(NULL);
+   update_subtitle_errors(NULL);
 
    if (doc) {
       se_dbg_msg(SE_DBG_APP, "disconnect_document: %s", doc->getName().c_str());
@@ -405,6 +411,14 @@ void Application::disconnect_document(Document* doc) {
    m_document_connections.clear();
 }
 
+// Display in the statusbar the number of subtitles with errors.
+void Application::update_subtitle_errors(Document* doc) {
+   unsigned int count = 0;
+   if (doc != NULL && doc->get_subtitle_errors().is_valid())
+      count = doc->get_subtitle_errors().count();
+   m_statusbar->set_subtitle_errors(count);
+}
+
 void Application::update_title(Document* doc) {
    if (doc != NULL) {
       Glib::ustring name = doc->getName();
@@ -452,7 +466,8 @@ void Application::init(OptionGroup& options) {
 
    std::merge(options.files.begin(), options.files.end(), options.files_list.begin(), options.files_list.end(), files.begin());
 
-   // files
+   // files, read in parallel
+   DocumentLoader loader;
    for (unsigned int i = 0; i < files.size(); ++i) {
       Glib::ustring filename = files[i];
 
@@ -460,12 +475,10 @@ void Application::init(OptionGroup& options) {
           Glib::file_test(filename, Glib::FILE_TEST_IS_DIR) == false) {
          Glib::ustring uri = Glib::filename_to_uri(utility::create_full_path(filename));
 
-         Document* doc = Document::create_from_file(uri, options.encoding);
-         if (doc) {
-            se::documents::append(doc);
-         }
+         loader.add(uri, options.encoding);
       }
    }
+   loader.run();
 
    // ------------------------------------------------
    // video
@@ -567,8 +580,11 @@ void Application::init(OptionGroup& options) {
       try {
          Glib::ustring uri = Glib::filename_to_uri(utility::create_full_path(keyframes));
          Glib::RefPtr<KeyFrames> kf = KeyFrames::create_from_file(uri);
-         if (kf)
+         if (kf) {
+            if (!utility::media_hash_matches(kf->get_media_hash(), get_player()->get_uri()))
+               std::cerr << "The keyframes '" << keyframes << "' have been generated from another version of the video" << std::endl;
             m_video_player->player()->set_keyframes(kf);
+         }
       } catch (const Glib::Error& ex) {
          std::cerr << ex.what() << std::endl;
       }
@@ -586,17 +602,12 @@ void Application::notebook_drag_data_received(const Glib::RefPtr<Gdk::DragContex
                                               guint /*info*/,
                                               guint /*time*/) {
    std::vector<Glib::ustring> uris = selection_data.get_uris();
+   // The files already open are skipped by the loader
+   DocumentLoader loader;
    for (unsigned int i = 0; i < uris.size(); ++i) {
-      Glib::ustring filename = Glib::filename_from_uri(uris[i]);
-
-      // verifie qu'il n'est pas déjà ouvert
-      if (se::documents::find_by_name(filename) != nullptr)
-         continue;
-
-      Document* doc = Document::create_from_file(uris[i]);
-      if (doc)
-         se::documents::append(doc);
+      loader.add(uris[i]);
    }
+   loader.run();
 }
 
 void Application::player_drag_data_received(const Glib::RefPtr<Gdk::DragContext>& /*context*/,
@@ -648,6 +659,10 @@ WaveformManager* Application::get_waveform_manager() {
    return m_waveform_editor;
 }
 
+Gtk::Statusbar* Application::get_statusbar() {
+   return m_statusbar;
+}
+
 // Need to connect the visibility signal of the widgets children
 // (video player and waveform editor) for updating the visibility of
 // the paned multimedia widget.
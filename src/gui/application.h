@@ -48,6 +48,8 @@ class Application : public Gtk::Window, public SubtitleEditorWindow {
 
    WaveformManager* get_waveform_manager();
 
+   Gtk::Statusbar* get_statusbar();
+
   protected:
    void on_config_interface_changed(const Glib::ustring& key, const Glib::ustring& value);
 
@@ -110,6 +112,9 @@ class Application : public Gtk::Window, public SubtitleEditorWindow {
 
    void update_title(Document* doc);
 
+   // Display in the statusbar the number of subtitles with errors.
+   void update_subtitle_errors(Document* doc);
+
    void load_window_state();
    void save_window_sate();
 
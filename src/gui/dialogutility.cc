@@ -108,3 +108,26 @@ void FramerateChooserDialog::set_default_framerate(FRAMERATE framerate) {
    ComboBoxFramerate* cbf = dynamic_cast<ComboBoxFramerate*>(m_comboFramerate);
    cbf->set_value(framerate);
 }
+
+ProgressDialog::ProgressDialog(const Glib::ustring& title) : Gtk::Dialog() {
+   utility::set_transient_parent(*this);
+
+   set_title(title);
+   set_resizable(false);
+   set_default_size(400, -1);
+   add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+
+   // progress bar
+   m_progressbar = manage(new Gtk::ProgressBar);
+   m_progressbar->set_show_text(true);
+   m_progressbar->property_margin() = 12;
+   get_vbox()->pack_start(*m_progressbar, false, false);
+
+   m_progressbar->show();
+}
+
+// Sets the fraction (0 to 1) and the text of the progress bar.
+void ProgressDialog::set_progress(double fraction, const Glib::ustring& text) {
+   m_progressbar->set_fraction(fraction);
+   m_progressbar->set_text(text);
+}
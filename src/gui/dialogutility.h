@@ -59,3 +59,15 @@ class FramerateChooserDialog : public Gtk::Dialog {
   protected:
    Gtk::ComboBox* m_comboFramerate;
 };
+
+// A dialog with a progress bar and a cancel button.
+class ProgressDialog : public Gtk::Dialog {
+  public:
+   explicit ProgressDialog(const Glib::ustring& title);
+
+   // Sets the fraction (0 to 1) and the text of the progress bar.
+   void set_progress(double fraction, const Glib::ustring& text);
+
+  protected:
+   Gtk::ProgressBar* m_progressbar;
+};
@@ -22,7 +22,11 @@
 
 #include <iostream>
 
+#include "i18n.h"
+#include "utility.h"
+
 Statusbar::Statusbar(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& /*builder*/) : Gtk::Statusbar(cobject) {
+   pack_end(m_errors_label, false, false);
 }
 
 Statusbar::~Statusbar() {
@@ -56,6 +60,18 @@ void Statusbar::flash_message(const Glib::ustring& text) {
    m_connection_timeout = Glib::signal_timeout().connect(sigc::mem_fun(*this, &Statusbar::on_timeout), 3000);
 }
 
+// Display the number of subtitles with errors, nothing if it's 0.
+void Statusbar::set_subtitle_errors(unsigned int count) {
+   if (count == 0) {
+      m_errors_label.hide();
+      return;
+   }
+
+   Glib::ustring text = build_message(ngettext("1 subtitle with errors", "%d subtitles with errors", count), count);
+   m_errors_label.set_markup(Glib::ustring::compose("<span foreground=\"red\">%1</span>", Glib::Markup::escape_text(text)));
+   m_errors_label.show();
+}
+
 bool Statusbar::on_timeout() {
    pop_text();
    m_connection_timeout.disconnect();
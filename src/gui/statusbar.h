@@ -33,9 +33,13 @@ class Statusbar : public Gtk::Statusbar {
    // affiche un message pendant 3 sec
    void flash_message(const Glib::ustring& text);
 
+   // Display the number of subtitles with errors, nothing if it's 0.
+   void set_subtitle_errors(unsigned int count);
+
   protected:
    bool on_timeout();
 
   protected:
    sigc::connection m_connection_timeout;
+   Gtk::Label m_errors_label;
 };
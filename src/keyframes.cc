@@ -22,6 +22,7 @@
 
 #include <giomm.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
@@ -60,6 +61,68 @@ Glib::ustring KeyFrames::get_video_uri() const {
    return m_video_uri;
 }
 
+void KeyFrames::set_media_hash(const Glib::ustring& hash) {
+   m_media_hash = hash;
+}
+
+Glib::ustring KeyFrames::get_media_hash() const {
+   return m_media_hash;
+}
+
+KeyFrames::const_iterator KeyFrames::lower_bound(long time) const {
+   return std::lower_bound(begin(), end(), time);
+}
+
+KeyFrames::const_iterator KeyFrames::upper_bound(long time) const {
+   return std::upper_bound(begin(), end(), time);
+}
+
+bool KeyFrames::get_previous(long time, long& prev) const {
+   const_iterator it = lower_bound(time);
+   if (it == begin())
+      return false;
+   prev = *(--it);
+   return true;
+}
+
+bool KeyFrames::get_next(long time, long& next) const {
+   const_iterator it = upper_bound(time);
+   if (it == end())
+      return false;
+   next = *it;
+   return true;
+}
+
+// Append the value as a varint, 7 bits by byte from the lowest,
+// the high bit is set when another byte follows.
+static void put_varint(std::string& data, guint64 value) {
+   while (value >= 0x80) {
+      data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+   }
+   data.push_back(static_cast<char>(value));
+}
+
+static bool get_varint(const std::string& data, std::string::size_type& pos, guint64& value) {
+   value = 0;
+   for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+      guint8 byte = static_cast<guint8>(data[pos++]);
+      value |= static_cast<guint64>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return true;
+   }
+   return false;
+}
+
+// The deltas are signed, zigzag maps them to small unsigned values.
+static guint64 zigzag_encode(gint64 value) {
+   return (static_cast<guint64>(value) << 1) ^ static_cast<guint64>(value >> 63);
+}
+
+static gint64 zigzag_decode(guint64 value) {
+   return static_cast<gint64>(value >> 1) ^ -static_cast<gint64>(value & 1);
+}
+
 bool KeyFrames::open(const Glib::ustring& uri) {
    try {
       Glib::RefPtr<Gio::File> file = Gio::File::create_for_uri(uri);
@@ -77,10 +140,39 @@ bool KeyFrames::open(const Glib::ustring& uri) {
          version = 1;
       else if (line == "#subtitleeditor keyframes v2")
          version = 2;
+      else if (line == "#subtitleeditor keyframes v3")
+         version = 3;
       else
          throw SubtitleError(_("Couldn't recognize format of the file."));
 
-      if (version == 2) {
+      if (version == 3) {
+         // Read the video uri and the media hash
+         dstream->read_line(line);
+         set_video_uri(line);
+         dstream->read_line(line);
+         set_media_hash(line);
+         // Read the number of keyframes and the deltas
+         std::string data;
+         char buffer[4096];
+         gssize n = 0;
+         while ((n = dstream->read(buffer, sizeof(buffer))) > 0) data.append(buffer, n);
+
+         std::string::size_type pos = 0;
+         guint64 count = 0;
+         // a delta takes one byte at least
+         if (!get_varint(data, pos, count) || count > data.size() - pos)
+            throw SubtitleError(_("Couldn't get the keyframe size on the file."));
+
+         resize(count);
+         gint64 time = 0;
+         for (guint64 i = 0; i < count; ++i) {
+            guint64 delta = 0;
+            if (!get_varint(data, pos, delta))
+               throw SubtitleError(_("Couldn't recognize format of the file."));
+            time += zigzag_decode(delta);
+            (*this)[i] = static_cast<long>(time);
+         }
+      } else if (version == 2) {
          // Read the video uri
          dstream->read_line(line);
          set_video_uri(line);
@@ -100,6 +192,9 @@ bool KeyFrames::open(const Glib::ustring& uri) {
             push_back(utility::string_to_int(line));
          }
       }
+      // The old versions could be unsorted, the lookups need sorted values
+      if (!std::is_sorted(begin(), end()))
+         std::sort(begin(), end());
       // Update the uri of the keyframe
       set_uri(uri);
       return true;
@@ -118,12 +213,19 @@ bool KeyFrames::save(const Glib::ustring& uri) {
       if (!stream)
          throw SubtitleError(Glib::ustring::compose("Gio::File::create_file returned an empty ptr from the uri '%1'.", uri));
 
-      // Write header (version + video uri + num of kf)
-      stream->write("#subtitleeditor keyframes v2\n");
-      stream->write(Glib::ustring::compose("%1\n", get_video_uri()));
-      stream->write(Glib::ustring::compose("%1\n", size()));
-      // Write keyframes data
-      stream->write(&(*this)[0], sizeof(long) * size());
+      // Write header (version + video uri + media hash)
+      std::string data = Glib::ustring::compose("#subtitleeditor keyframes v3\n%1\n%2\n", get_video_uri(), get_media_hash());
+      // Write the number of keyframes and the difference with the previous one,
+      // as varints they don't depend on the size of long
+      put_varint(data, size());
+      gint64 prev = 0;
+      for (long time : *this) {
+         put_varint(data, zigzag_encode(time - prev));
+         prev = time;
+      }
+      // write() can return before the whole buffer is written
+      gsize bytes_written = 0;
+      stream->write_all(data, bytes_written);
       // Close the stream to make sure that changes are write now.
       stream->close();
       stream.reset();
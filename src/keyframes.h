@@ -24,6 +24,7 @@
 
 #include <vector>
 
+// The positions (msecs) of the keyframes of a video, sorted.
 class KeyFrames : public std::vector<long> {
   public:
    static Glib::RefPtr<KeyFrames> create_from_file(const Glib::ustring& uri);
@@ -40,6 +41,23 @@ class KeyFrames : public std::vector<long> {
 
    Glib::ustring get_video_uri() const;
 
+   // Fingerprint of the video, see utility::compute_media_hash.
+   void set_media_hash(const Glib::ustring& hash);
+
+   Glib::ustring get_media_hash() const;
+
+   // Return the first keyframe at or after the time.
+   const_iterator lower_bound(long time) const;
+
+   // Return the first keyframe after the time.
+   const_iterator upper_bound(long time) const;
+
+   // Set the last keyframe before the time, return false if there's none.
+   bool get_previous(long time, long& prev) const;
+
+   // Set the first keyframe after the time, return false if there's none.
+   bool get_next(long time, long& next) const;
+
   public:
    void reference() const;
 
@@ -53,4 +71,5 @@ class KeyFrames : public std::vector<long> {
    mutable int ref_count_{0};
    Glib::ustring m_uri;
    Glib::ustring m_video_uri;
+   Glib::ustring m_media_hash;
 };
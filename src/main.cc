@@ -23,6 +23,7 @@
 
 #include <iostream>
 
+#include "batchmode.h"
 #include "glibmm/miscutils.h"
 #include "gtkmm_utility.h"
 #include "gui/application.h"
@@ -35,10 +36,6 @@
 
 #include <ctime>
 
-#ifdef ENABLE_GL
-#include <gtkglmm.h>
-#endif  // ENABLE_GL
-
 int main(int argc, char* argv[]) {
    if (!g_thread_supported())
       g_thread_init(NULL);
@@ -47,14 +44,13 @@ int main(int argc, char* argv[]) {
    bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
    textdomain(GETTEXT_PACKAGE);
 
+   // The batch mode converts the files without display
+   if (batchmode::is_requested(argc, argv))
+      return batchmode::run(argc, argv);
+
    // init Gtk+
    Gtk::Main kit(argc, argv);
 
-#ifdef ENABLE_GL
-   // init OpenGL
-   Gtk::GL::init_check(argc, argv);
-#endif  // ENABLE_GL
-
    Glib::set_application_name("Subtitle Editor");
    Glib::set_prgname("org.kitone.subtitleeditor");
 
@@ -0,0 +1,150 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "mediacache.h"
+
+#include <giomm.h>
+#include <glib/gstdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cfg.h"
+#include "debug.h"
+#include "utility.h"
+
+namespace mediacache {
+
+// Return the directory of the cache, created if needed.
+static std::string get_cache_dir() {
+   std::string path = get_config_dir("cache");
+   if (!Glib::file_test(path, Glib::FILE_TEST_IS_DIR))
+      g_mkdir_with_parents(path.c_str(), 0700);
+   return path;
+}
+
+// The fingerprint of the media is the hash of its size and of its first
+// and last 64 KiB, with its modification time. Only a few blocks are read,
+// it's cheap even for a whole movie.
+static Glib::ustring get_key(const Glib::ustring& media_uri) {
+   Glib::ustring hash = utility::compute_media_hash(media_uri);
+   if (hash.empty())
+      return Glib::ustring();
+
+   guint64 mtime = 0;
+   try {
+      Glib::RefPtr<Gio::FileInfo> info = Gio::File::create_for_uri(media_uri)->query_info(G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      mtime = info->get_attribute_uint64(G_FILE_ATTRIBUTE_TIME_MODIFIED);
+   } catch (const Glib::Error& ex) {
+      se_dbg_msg(SE_DBG_IO, "Failed to get the modification time of '%s': %s", media_uri.c_str(), ex.what().c_str());
+      return Glib::ustring();
+   }
+   return Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_SHA256, Glib::ustring::compose("%1:%2", hash, mtime));
+}
+
+static std::string get_filename(const Glib::ustring& key, const Glib::ustring& ext) {
+   return Glib::build_filename(get_cache_dir(), key + "." + ext);
+}
+
+Glib::ustring lookup(const Glib::ustring& media_uri, const Glib::ustring& ext) {
+   if (!cfg::get_boolean("media-cache", "enabled"))
+      return Glib::ustring();
+
+   Glib::ustring key = get_key(media_uri);
+   if (key.empty())
+      return Glib::ustring();
+
+   std::string filename = get_filename(key, ext);
+   if (!Glib::file_test(filename, Glib::FILE_TEST_IS_REGULAR))
+      return Glib::ustring();
+
+   // the modification time of the cached file is the time of its last use
+   g_utime(filename.c_str(), NULL);
+
+   se_dbg_msg(SE_DBG_IO, "found '%s' in the cache", media_uri.c_str());
+
+   return Glib::filename_to_uri(filename);
+}
+
+Glib::ustring get_uri(const Glib::ustring& media_uri, const Glib::ustring& ext) {
+   if (!cfg::get_boolean("media-cache", "enabled"))
+      return Glib::ustring();
+
+   Glib::ustring key = get_key(media_uri);
+   if (key.empty())
+      return Glib::ustring();
+
+   return Glib::filename_to_uri(get_filename(key, ext));
+}
+
+void trim() {
+   struct Entry {
+      std::string filename;
+      time_t mtime;
+      goffset size;
+   };
+
+   goffset max_size = static_cast<goffset>(cfg::get_int("media-cache", "max-size")) * 1024 * 1024;
+
+   std::string dirname = get_cache_dir();
+
+   std::vector<Entry> entries;
+   goffset total = 0;
+   try {
+      Glib::Dir dir(dirname);
+      for (const std::string& name : dir) {
+         std::string filename = Glib::build_filename(dirname, name);
+
+         GStatBuf st;
+         if (g_stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+
+         entries.push_back({filename, st.st_mtime, static_cast<goffset>(st.st_size)});
+         total += st.st_size;
+      }
+   } catch (const Glib::FileError& ex) {
+      se_dbg_msg(SE_DBG_IO, "Failed to read the cache dir: %s", ex.what().c_str());
+      return;
+   }
+
+   if (total <= max_size)
+      return;
+
+   // the least recently used first
+   std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+
+   for (const Entry& entry : entries) {
+      if (total <= max_size)
+         break;
+      if (g_remove(entry.filename.c_str()) == 0)
+         total -= entry.size;
+   }
+}
+
+bool contains(const Glib::ustring& uri) {
+   try {
+      std::string filename = Glib::filename_from_uri(uri);
+      return Glib::path_get_dirname(filename) == get_cache_dir();
+   } catch (const Glib::ConvertError&) {
+      return false;
+   }
+}
+
+}  // namespace mediacache
@@ -0,0 +1,45 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm.h>
+
+// Cache of the data computed from the media files (waveform, keyframes),
+// in the config dir. The files are named from a fingerprint of the media,
+// so a known media is found again even if it has been renamed.
+namespace mediacache {
+
+// Return the uri of the cached file of the media with the extension ("wf", "kf"),
+// empty if the media isn't in the cache. The file becomes the most recently used.
+Glib::ustring lookup(const Glib::ustring& media_uri, const Glib::ustring& ext);
+
+// Return the uri where the file of the media with the extension must be saved,
+// empty if the cache is disabled or if the media can't be read.
+Glib::ustring get_uri(const Glib::ustring& media_uri, const Glib::ustring& ext);
+
+// Remove the least recently used files until the cache fits in its maximum size
+// ([media-cache] max-size, in MiB).
+void trim();
+
+// Return true if the uri is a file of the cache.
+bool contains(const Glib::ustring& uri);
+
+}  // namespace mediacache
@@ -93,6 +93,58 @@ OptionGroup::OptionGroup()
    entryKeyframes.set_arg_description(_("FILE"));
    add_entry(entryKeyframes, keyframes);
 
+   // batch
+   Glib::OptionEntry entryBatch;
+   entryBatch.set_long_name("batch");
+   entryBatch.set_description("Convert the subtitle files without user interface");
+   add_entry(entryBatch, batch);
+
+   // convert
+   Glib::OptionEntry entryConvert;
+   entryConvert.set_long_name("convert");
+   entryConvert.set_description("Subtitle format of the converted files (batch mode)");
+   entryConvert.set_arg_description(_("FORMAT"));
+   add_entry(entryConvert, convert);
+
+   // output
+   Glib::OptionEntry entryOutput;
+   entryOutput.set_long_name("output");
+   entryOutput.set_short_name('o');
+   entryOutput.set_description("Directory of the converted files, the default is the directory of each file (batch mode)");
+   entryOutput.set_arg_description(_("DIRECTORY"));
+   add_entry(entryOutput, output);
+
+   // output encoding
+   Glib::OptionEntry entryOutputEncoding;
+   entryOutputEncoding.set_long_name("output-encoding");
+   entryOutputEncoding.set_description("Encoding of the converted files, the default is the encoding of each file (batch mode)");
+   entryOutputEncoding.set_arg_description(_("ENCODING"));
+   add_entry(entryOutputEncoding, output_encoding);
+
+   // steps
+   Glib::OptionEntry entryStep;
+   entryStep.set_long_name("step");
+   entryStep.set_description(
+      "Apply a step before saving, can be used multiple times. "
+      "Use --step=help to list the steps (batch mode)");
+   entryStep.set_arg_description(_("NAME[:ARG...]"));
+   add_entry(entryStep, steps);
+
+   // jobs
+   Glib::OptionEntry entryJobs;
+   entryJobs.set_long_name("jobs");
+   entryJobs.set_short_name('j');
+   entryJobs.set_description("Number of files converted in parallel, the default is the number of processors (batch mode)");
+   entryJobs.set_arg_description(_("N"));
+   add_entry(entryJobs, jobs);
+
+   // framerate
+   Glib::OptionEntry entryFramerate;
+   entryFramerate.set_long_name("framerate");
+   entryFramerate.set_description("Framerate of the video used by the frame based formats: 23.976, 24, 25, 29.97 or 30 (batch mode)");
+   entryFramerate.set_arg_description(_("FPS"));
+   add_entry(entryFramerate, framerate);
+
 #ifdef DEBUG
 
 #define add_debug_option(name, value, desc) \
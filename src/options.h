@@ -47,6 +47,15 @@ class OptionGroup : public Glib::OptionGroup {
    Glib::ustring waveform;                 // waveform file location
    Glib::ustring keyframes;                // keyframes file location
 
+   // batch mode
+   bool batch{false};                      // convert without user interface
+   Glib::ustring convert;                  // subtitle format of the converted files
+   Glib::ustring output;                   // directory of the converted files
+   Glib::ustring output_encoding;          // encoding of the converted files
+   std::vector<Glib::ustring> steps;       // steps applied before saving
+   int jobs{0};                            // number of processes (0 = processors)
+   Glib::ustring framerate;                // framerate of the frame based formats
+
 #ifdef DEBUG
    Glib::OptionGroup debug_group;
 
@@ -42,11 +42,13 @@ const Glib::ustring& Reader::get_data() const {
 Glib::ustring Reader::get_newline() {
    Glib::ustring newline;
 
-   if (Glib::Regex::match_simple("\\r\\n", m_data))
+   const std::string& data = m_data.raw();
+
+   if (data.find("\r\n") != std::string::npos)
       newline = "Windows";
-   else if (Glib::Regex::match_simple("\\r", m_data))
+   else if (data.find('\r') != std::string::npos)
       newline = "Macintosh";
-   else if (Glib::Regex::match_simple("\\n", m_data))
+   else if (data.find('\n') != std::string::npos)
       newline = "Unix";
    else
       newline = "Unix";
@@ -57,17 +59,62 @@ Glib::ustring Reader::get_newline() {
    return newline;
 }
 
+// Return the offset (bytes) of the next newline from pos, or npos.
+// The size of the newline sequence is set in newline_size.
+// Like "\\R": CRLF, LF, CR, VT, FF, NEL, LS and PS.
+std::string::size_type Reader::find_newline(std::string::size_type pos, std::string::size_type& newline_size) const {
+   const std::string& data = m_data.raw();
+   const std::string::size_type size = data.size();
+
+   for (; pos < size; ++pos) {
+      const unsigned char c = data[pos];
+
+      if (c == '\n' || c == '\v' || c == '\f') {
+         newline_size = 1;
+         return pos;
+      } else if (c == '\r') {
+         newline_size = (pos + 1 < size && data[pos + 1] == '\n') ? 2 : 1;
+         return pos;
+      } else if (c == 0xC2 && pos + 1 < size && (unsigned char)data[pos + 1] == 0x85) {
+         // U+0085 NEL
+         newline_size = 2;
+         return pos;
+      } else if (c == 0xE2 && pos + 2 < size && (unsigned char)data[pos + 1] == 0x80 &&
+                 ((unsigned char)data[pos + 2] == 0xA8 || (unsigned char)data[pos + 2] == 0xA9)) {
+         // U+2028 LS, U+2029 PS
+         newline_size = 3;
+         return pos;
+      }
+   }
+   return std::string::npos;
+}
+
 // Get the next line of the file without newline character (CR, LF or CRLF).
+// Like Glib::Regex::split_simple("\\R"), a newline at the end of the data
+// gives an empty last line and empty data has no line.
 bool Reader::getline(Glib::ustring& line) {
-   initialize_lines();
+   if (!m_position_init) {
+      m_position = m_data.empty() ? std::string::npos : 0;
+      m_position_init = true;
+   }
 
-   if (m_iter == m_lines.end()) {
+   if (m_position == std::string::npos) {
       se_dbg_msg(SE_DBG_IO, "EOF");
       return false;
    }
 
-   line = *m_iter;
-   ++m_iter;
+   const std::string& data = m_data.raw();
+
+   std::string::size_type newline_size = 0;
+   std::string::size_type end = find_newline(m_position, newline_size);
+
+   if (end == std::string::npos) {
+      line.assign(data.begin() + m_position, data.end());
+      m_position = std::string::npos;
+   } else {
+      line.assign(data.begin() + m_position, data.begin() + end);
+      m_position = end + newline_size;
+   }
 
    se_dbg_msg(SE_DBG_IO, "\"%s\"", line.c_str());
 
@@ -77,20 +124,22 @@ bool Reader::getline(Glib::ustring& line) {
 // Return all lines detected of the file, without newline character (CR, LF or
 // CRLF).
 std::vector<Glib::ustring> Reader::get_lines() {
-   initialize_lines();
-
-   return m_lines;
-}
-
-// Split the data to separate lines.
-void Reader::initialize_lines() {
-   // init only if needs
-   if (m_lines_init)
-      return;
-
-   se_dbg_msg(SE_DBG_IO, "split lines...");
-
-   m_lines = Glib::Regex::split_simple("\\R", m_data);
-   m_iter = m_lines.begin();
-   m_lines_init = true;
+   std::vector<Glib::ustring> lines;
+
+   if (m_data.empty())
+      return lines;
+
+   const std::string& data = m_data.raw();
+
+   std::string::size_type pos = 0, newline_size = 0;
+   while (true) {
+      std::string::size_type end = find_newline(pos, newline_size);
+      if (end == std::string::npos) {
+         lines.emplace_back(data.begin() + pos, data.end());
+         break;
+      }
+      lines.emplace_back(data.begin() + pos, data.begin() + end);
+      pos = end + newline_size;
+   }
+   return lines;
 }
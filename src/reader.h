@@ -24,6 +24,8 @@
 
 // Helper to read data (UTF-8) from memory.
 // Return lines without character of newline (CR,LF or CRLF)
+// The lines are not split in advance, getline() moves a cursor (byte offset)
+// over the single buffer of data.
 class Reader {
   public:
    // Constructor.
@@ -45,13 +47,15 @@ class Reader {
    // CRLF).
    std::vector<Glib::ustring> get_lines();
 
-  private:
-   // Split the data to separate lines.
-   void initialize_lines();
+  protected:
+   // Return the offset (bytes) of the next newline from pos, or npos.
+   // The size of the newline sequence is set in newline_size.
+   // Like "\\R": CRLF, LF, CR, VT, FF, NEL, LS and PS.
+   std::string::size_type find_newline(std::string::size_type pos, std::string::size_type& newline_size) const;
 
   protected:
    Glib::ustring m_data;
-   bool m_lines_init{false};
-   std::vector<Glib::ustring>::const_iterator m_iter;
-   std::vector<Glib::ustring> m_lines;
+   // Offset (bytes) of the next line in m_data, npos at the end.
+   std::string::size_type m_position{0};
+   bool m_position_init{false};
 };
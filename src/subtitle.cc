@@ -31,7 +31,7 @@ class SubtitleCommand : public Command {
   public:
    SubtitleCommand(const Subtitle& sub, const Glib::ustring& name_value, const Glib::ustring& new_value)
        : Command(sub.m_document, "Subtitle edited " + name_value),
-         m_path(sub.m_path),
+         m_path(sub.get_path()),
          m_name_value(name_value),
          m_old(sub.get(name_value)),
          m_new(new_value) {
@@ -50,11 +50,106 @@ class SubtitleCommand : public Command {
       subtitle.set(m_name_value, m_old);
    }
 
+   // Coalesce the consecutive edits of the same field of the same subtitle,
+   // only the first old value and the last new value are needed.
+   bool merge(const Glib::ustring& path, const Glib::ustring& name_value, const Glib::ustring& new_value) {
+      if (m_path != path || m_name_value != name_value)
+         return false;
+      m_new = new_value;
+      return true;
+   }
+
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) + Command::get_memory_size(m_path) +
+             Command::get_memory_size(m_name_value) + Command::get_memory_size(m_old) + Command::get_memory_size(m_new);
+   }
+
   protected:
    const Glib::ustring m_path;
    const Glib::ustring m_name_value;
    const Glib::ustring m_old;
-   const Glib::ustring m_new;
+   Glib::ustring m_new;
+};
+
+// Journal of the time changes (start, end, duration) of a recording.
+// Each change is stored as a delta (new - old) and the changes of the same
+// field with the same delta on consecutive rows are merged in one range,
+// so "shift all times" is a few ranges instead of a command per value.
+// The deltas are additive, undo and redo only add or subtract them.
+class SubtitleTimesCommand : public Command {
+  public:
+   explicit SubtitleTimesCommand(Document* doc) : Command(doc, "Subtitle times edited") {
+   }
+
+   // Record the delta of the field on the row.
+   void add(Subtitle::TimeField field, guint row, long delta) {
+      // The fields are usually changed together (start, end, duration) for
+      // each row, look for the range of this field in the last ones.
+      guint count = 0;
+      for (auto it = m_ranges.rbegin(); it != m_ranges.rend() && count < 3; ++it, ++count) {
+         if (it->field != field)
+            continue;
+         if (it->delta == delta && it->first + it->count == row) {
+            ++it->count;
+            return;
+         }
+         // The same value is changed again (like dragging a boundary in the
+         // waveform), coalesce the deltas.
+         if (it->count == 1 && it->first == row) {
+            it->delta += delta;
+            return;
+         }
+         break;
+      }
+      m_ranges.push_back({static_cast<guint8>(field), row, 1, delta});
+   }
+
+   void execute() {
+      for (const auto& range : m_ranges) {
+         apply(range, range.delta);
+      }
+   }
+
+   void restore() {
+      for (auto it = m_ranges.rbegin(); it != m_ranges.rend(); ++it) {
+         apply(*it, -it->delta);
+      }
+   }
+
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) + m_ranges.capacity() * sizeof(Range);
+   }
+
+  protected:
+   struct Range {
+      guint8 field;
+      guint first;
+      guint count;
+      gint64 delta;
+   };
+
+   void apply(const Range& range, gint64 delta) {
+      Gtk::TreeNodeChildren rows = get_document_subtitle_model()->children();
+      g_return_if_fail(range.first + range.count <= rows.size());
+
+      Subtitle sub(document(), rows[range.first]);
+      for (guint i = 0; i < range.count && sub; ++i, ++sub) {
+         switch (range.field) {
+            case Subtitle::START_VALUE:
+               sub.set_start_value(sub.get_start_value() + delta);
+               break;
+            case Subtitle::END_VALUE:
+               sub.set_end_value(sub.get_end_value() + delta);
+               break;
+            case Subtitle::DURATION_VALUE:
+               sub.set_duration_value(sub.get_duration_value() + delta);
+               break;
+         }
+      }
+   }
+
+  protected:
+   std::vector<Range> m_ranges;
 };
 
 // static
@@ -67,17 +162,36 @@ Subtitle::Subtitle(Document* doc, const Glib::ustring& path) : m_document(doc),
    m_iter = doc->get_subtitle_model()->get_iter(path);
 }
 
+// The path is not resolved here, see get_path().
 Subtitle::Subtitle(Document* doc, const Gtk::TreeIter& it) : m_document(doc), m_iter(it) {
-   if (it)
-      m_path = doc->get_subtitle_model()->get_string(it);
 }
 
 Subtitle::~Subtitle() {
 }
 
 void Subtitle::push_command(const Glib::ustring& name, const Glib::ustring& value) {
-   if (m_document->is_recording())
-      m_document->add_command(new SubtitleCommand(*this, name, value));
+   if (!m_document->is_recording())
+      return;
+
+   SubtitleCommand* last = dynamic_cast<SubtitleCommand*>(m_document->get_last_recorded_command());
+   if (last && last->merge(get_path(), name, value))
+      return;
+
+   m_document->add_command(new SubtitleCommand(*this, name, value));
+}
+
+void Subtitle::push_time_command(TimeField field, long delta) {
+   if (!m_document->is_recording() || delta == 0)
+      return;
+
+   guint row = m_document->get_subtitle_model()->get_path(m_iter)[0];
+
+   SubtitleTimesCommand* cmd = dynamic_cast<SubtitleTimesCommand*>(m_document->get_last_recorded_command());
+   if (cmd == NULL) {
+      cmd = new SubtitleTimesCommand(m_document);
+      m_document->add_command(cmd);
+   }
+   cmd->add(field, row, delta);
 }
 
 Subtitle::operator bool() const {
@@ -96,20 +210,25 @@ bool Subtitle::operator!=(const Subtitle& sub) const {
 
 Subtitle& Subtitle::operator++() {
    ++m_iter;
-
-   m_path = (m_iter) ? m_document->get_subtitle_model()->get_string(m_iter) : "";
-
+   m_path.clear();
    return *this;
 }
 
 Subtitle& Subtitle::operator--() {
    --m_iter;
-
-   m_path = (m_iter) ? m_document->get_subtitle_model()->get_string(m_iter) : "";
-
+   m_path.clear();
    return *this;
 }
 
+// Return the path (index) of the subtitle in the model.
+// It is only needed by the commands (undo/redo) and get("path"),
+// so it is resolved from the iter the first time it is asked.
+const Glib::ustring& Subtitle::get_path() const {
+   if (m_path.empty() && m_iter)
+      m_path = m_document->get_subtitle_model()->get_string(m_iter);
+   return m_path;
+}
+
 // Set the number of subtitle.
 void Subtitle::set_num(unsigned int num) {
    (*m_iter)[column.num] = num;
@@ -288,14 +407,14 @@ bool Subtitle::check_gap_after(long mingap) {
 
 // Set the start value in the subtitle time mode. (FRAME or TIME)
 void Subtitle::set_start_value(const long& value) {
-   push_command("start", to_string(value));
+   push_time_command(START_VALUE, value - get_start_value());
    (*m_iter)[column.start_value] = value;
    update_gap_before();
 }
 
 // Set the end value in the subtitle time mode. (FRAME or TIME)
 void Subtitle::set_end_value(const long& value) {
-   push_command("end", to_string(value));
+   push_time_command(END_VALUE, value - get_end_value());
    (*m_iter)[column.end_value] = value;
    update_gap_after();
 }
@@ -318,7 +437,7 @@ long Subtitle::get_end_value() const {
 
 // Set the duration value in the subtitle time mode. (FRAME or TIME)
 void Subtitle::set_duration_value(const long& value) {
-   push_command("duration", to_string(value));
+   push_time_command(DURATION_VALUE, value - get_duration_value());
 
    (*m_iter)[column.duration_value] = value;
    update_characters_per_sec();
@@ -619,7 +738,7 @@ void Subtitle::set(const Glib::ustring& name, const Glib::ustring& value) {
 
 Glib::ustring Subtitle::get(const Glib::ustring& name) const {
    if (name == "path")
-      return m_path;
+      return get_path();
    else if (name == "start")
       return to_string(get_start_value());
    else if (name == "end")
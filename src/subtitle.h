@@ -33,12 +33,14 @@
 // La durée de vie d'un Subtitle est la même que l'iter!
 // On ne verifie pas la validiter des arguments! (pour les performances)
 class SubtitleCommand;
+class SubtitleTimesCommand;
 class Subtitles;
 class Document;
 
 class Subtitle {
    friend class Subtitles;
    friend class SubtitleCommand;
+   friend class SubtitleTimesCommand;
 
   public:
    Subtitle();
@@ -201,8 +203,19 @@ class Subtitle {
    int check_cps_text(double mincps, double maxcps);
 
   protected:
+   // The time values recorded by SubtitleTimesCommand.
+   enum TimeField { START_VALUE = 0, END_VALUE, DURATION_VALUE };
+
+   // Return the path (index) of the subtitle in the model.
+   // Resolved lazily, the handle does not build it when it is created.
+   const Glib::ustring& get_path() const;
+
    void push_command(const Glib::ustring& name, const Glib::ustring& value);
 
+   // Record the change of a time value as a delta (new - old)
+   // in the SubtitleTimesCommand of the current recording.
+   void push_time_command(TimeField field, long delta);
+
    void update_characters_per_sec();
 
    // Convert the value (subtitle timing mode) to the edit timing mode.
@@ -239,5 +252,6 @@ class Subtitle {
    static SubtitleColumnRecorder column;
    Document* m_document{nullptr};
    Gtk::TreeIter m_iter;
-   Glib::ustring m_path;
+   // empty until get_path() is called
+   mutable Glib::ustring m_path;
 };
@@ -43,6 +43,9 @@ class SubtitleEditorWindow {
 
    virtual WaveformManager* get_waveform_manager() = 0;
 
+   // The statusbar of the window, to display the progress of a background work.
+   virtual Gtk::Statusbar* get_statusbar() = 0;
+
    static SubtitleEditorWindow* get_instance();
 
   protected:
@@ -0,0 +1,49 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "subtitleerrors.h"
+
+// Define if the errors are kept up to date.
+// The errors are cleared.
+void SubtitleErrors::set_valid(bool state) {
+   m_valid = state;
+   m_flags.clear();
+   m_count = 0;
+}
+
+// Define the number of rows, the new rows have no error.
+void SubtitleErrors::resize(unsigned int size) {
+   for (unsigned int row = size; row < m_flags.size(); ++row) {
+      if (m_flags[row] != 0)
+         --m_count;
+   }
+   m_flags.resize(size, 0);
+}
+
+// Define the errors (SubtitleErrorFlags) of the row.
+void SubtitleErrors::set(unsigned int row, guint flags) {
+   g_return_if_fail(row < m_flags.size());
+
+   if (m_flags[row] != 0)
+      --m_count;
+   if (flags != 0)
+      ++m_count;
+   m_flags[row] = flags;
+}
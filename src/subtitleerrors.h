@@ -0,0 +1,83 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm.h>
+
+#include <vector>
+
+// The errors of a subtitle, a bitmask of these flags.
+enum SubtitleErrorFlags {
+   SUBTITLE_ERROR_NONE = 0,
+   SUBTITLE_ERROR_OVERLAPPING = 1 << 0,
+   SUBTITLE_ERROR_MIN_GAP = 1 << 1,
+   SUBTITLE_ERROR_MAX_CPS = 1 << 2,
+   SUBTITLE_ERROR_MIN_CPS = 1 << 3,
+   SUBTITLE_ERROR_MIN_DISPLAY_TIME = 1 << 4,
+   SUBTITLE_ERROR_MAX_CPL = 1 << 5,
+   SUBTITLE_ERROR_MAX_LINES = 1 << 6
+};
+
+// The errors of each subtitle of a document, by row (num - 1).
+// They are found and kept up to date by the background checking of the
+// error checking plugin, the subtitle view, the waveform and the statusbar
+// read them instead of checking the subtitles when they are drawn.
+// When the errors are not valid (nothing checks the document), they are
+// all empty and the readers do their own checking.
+// The document emits "subtitle-errors-changed" when they are updated.
+class SubtitleErrors {
+  public:
+   // Return true if the errors are kept up to date.
+   bool is_valid() const {
+      return m_valid;
+   }
+
+   // Define if the errors are kept up to date.
+   // The errors are cleared.
+   void set_valid(bool state);
+
+   // Define the number of rows, the new rows have no error.
+   void resize(unsigned int size);
+
+   // Return the number of rows.
+   unsigned int size() const {
+      return m_flags.size();
+   }
+
+   // Return the errors (SubtitleErrorFlags) of the row,
+   // 0 if the row is unknown.
+   guint get(unsigned int row) const {
+      return (row < m_flags.size()) ? m_flags[row] : 0;
+   }
+
+   // Define the errors (SubtitleErrorFlags) of the row.
+   void set(unsigned int row, guint flags);
+
+   // Return the number of rows which have at least an error.
+   unsigned int count() const {
+      return m_count;
+   }
+
+  protected:
+   bool m_valid{false};
+   std::vector<guint> m_flags;
+   unsigned int m_count{0};
+};
@@ -20,6 +20,9 @@
 
 #include "subtitleformatsystem.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iostream>
 #include <map>
 #include <memory>
 
@@ -44,6 +47,67 @@ SubtitleFormatSystem::SubtitleFormatSystem() {
 SubtitleFormatSystem::~SubtitleFormatSystem() {
 }
 
+// Return the literal which starts every match of the pattern, or an empty
+// string if the pattern doesn't have one. Only the simple cases are handled
+// (no top level alternation, no inline option), it's only used to reject quickly the
+// formats which can't match.
+static std::string get_pattern_magic(const Glib::ustring& pattern) {
+   const std::string& raw = pattern.raw();
+
+   // Reject the top level alternations and the inline options
+   int depth = 0;
+   bool in_class = false;
+   for (std::string::size_type i = 0; i < raw.size(); ++i) {
+      if (raw[i] == '\\')
+         ++i;
+      else if (in_class)
+         in_class = (raw[i] != ']');
+      else if (raw[i] == '[')
+         in_class = true;
+      else if (raw[i] == '(' && i + 1 < raw.size() && raw[i + 1] == '?')
+         return std::string();
+      else if (raw[i] == '(')
+         ++depth;
+      else if (raw[i] == ')')
+         --depth;
+      else if (raw[i] == '|' && depth == 0)
+         return std::string();
+   }
+
+   std::string magic;
+   std::string::size_type i = 0;
+   if (i < raw.size() && raw[i] == '^')
+      ++i;
+
+   while (i < raw.size()) {
+      char c = raw[i];
+      if (c == '\\') {
+         if (i + 1 >= raw.size() || g_ascii_isalnum(raw[i + 1]))
+            break;
+         c = raw[i + 1];
+         i += 2;
+      } else if (strchr(".[]()*+?{}^$", c) != nullptr || (c & 0x80) != 0) {
+         break;
+      } else {
+         ++i;
+      }
+      // An optional character is not part of the magic
+      if (i < raw.size() && strchr("*?{", raw[i]) != nullptr)
+         break;
+      magic += c;
+   }
+   return magic;
+}
+
+// Check if the format can read the contents.
+bool SubtitleFormatSystem::match_format(const FormatEntry& entry, const Glib::ustring& contents) {
+   if (!entry.regex)
+      return false;
+   if (!entry.magic.empty() && contents.raw().find(entry.magic) == std::string::npos)
+      return false;
+   return entry.regex->match(contents);
+}
+
 // Try to determine the format of the subtitles in the submitted FileReader
 // Exceptions:
 // UnrecognizeFormatError.
@@ -52,25 +116,17 @@ Glib::ustring SubtitleFormatSystem::get_subtitle_format_from_small_contents(Read
 
    se_dbg_msg(SE_DBG_APP, "small content:\n%s", contents.c_str());
 
-   Glib::RegexCompileFlags compile_flags = Glib::REGEX_MULTILINE;
-
    se_dbg_msg(SE_DBG_APP, "Trying to determinate the file format...");
 
-   auto list_of_sf = get_subtitle_format_list();
+   auto entries = get_format_entries();
 
    // Try pattern matching first
-   for (const auto& sf : list_of_sf) {
-      SubtitleFormatInfo sfi = sf->get_info();
+   for (const auto& entry : entries) {
+      se_dbg_msg(SE_DBG_APP, "Try with '%s' format", entry->info.name.c_str());
 
-      se_dbg_msg(SE_DBG_APP, "Try with '%s' format", sfi.name.c_str());
-
-      Glib::ustring pattern = sfi.pattern;
-
-      if (Glib::Regex::match_simple(pattern, contents, compile_flags)) {
-         Glib::ustring name = sfi.name;
-
-         se_dbg_msg(SE_DBG_APP, "Determine the format as '%s'", name.c_str());
-         return name;
+      if (match_format(*entry, contents)) {
+         se_dbg_msg(SE_DBG_APP, "Determine the format as '%s'", entry->info.name.c_str());
+         return entry->info.name;
       }
    }
 
@@ -86,11 +142,10 @@ Glib::ustring SubtitleFormatSystem::get_subtitle_format_from_small_contents(Read
          Glib::ustring ext = filename.substr(pos + 1);
 
          // Try to match extension with format info
-         for (const auto& sf : list_of_sf) {
-            SubtitleFormatInfo sfi = sf->get_info();
-            if (sfi.extension == ext) {
-               se_dbg_msg(SE_DBG_APP, "Determined format as '%s' from extension", sfi.name.c_str());
-               return sfi.name;
+         for (const auto& entry : entries) {
+            if (entry->info.extension == ext) {
+               se_dbg_msg(SE_DBG_APP, "Determined format as '%s' from extension", entry->info.name.c_str());
+               return entry->info.name;
             }
          }
       }
@@ -124,12 +179,12 @@ Glib::ustring SubtitleFormatSystem::get_subtitle_format_from_small_contents(cons
 SubtitleFormatIO* SubtitleFormatSystem::create_subtitle_format_io(const Glib::ustring& name) {
    se_dbg_msg(SE_DBG_APP, "Trying to create the subtitle format '%s'", name.c_str());
 
-   auto list_of_sf = get_subtitle_format_list();
-   for (const auto& sf : list_of_sf) {
-      se_dbg_msg(SE_DBG_APP, "considering subtitle format'%s'...", sf->get_info().name.c_str());
+   auto entries = get_format_entries();
+   for (const auto& entry : entries) {
+      se_dbg_msg(SE_DBG_APP, "considering subtitle format'%s'...", entry->info.name.c_str());
 
-      if (sf->get_info().name == name)
-         return sf->create();
+      if (entry->info.name == name)
+         return entry->format->create();
    }
    throw UnrecognizeFormatError(build_message(_("Couldn't create the subtitle format '%s'."), name.c_str()));
 }
@@ -153,6 +208,7 @@ void SubtitleFormatSystem::open_from_reader(Document* document, Reader* reader,
    if (filereader != nullptr) {
       document->setFilename(Glib::filename_from_uri(filereader->get_uri()));
       document->setCharset(filereader->get_charset());
+      document->set_charset_confidence(filereader->get_charset_confidence());
    }
    document->setNewLine(reader->get_newline());
    document->setFormat(format);
@@ -179,6 +235,38 @@ void SubtitleFormatSystem::open_from_uri(Document* document, const Glib::ustring
    se_dbg_msg(SE_DBG_APP, "The file %s has been read with success.", uri.c_str());
 }
 
+// Try to open a subtitle file already read and converted to UTF-8
+// (the reading can be done outside the main thread).
+// If format is empty, the automatically detection is used.
+// Exceptions: UnrecognizeFormatError, Glib::Error...
+void SubtitleFormatSystem::open_from_file_reader(Document* document, FileReader* reader, const Glib::ustring& myformat) {
+   se_dbg_msg(SE_DBG_APP, "Trying to open the file %s with format '%s'", reader->get_uri().c_str(), myformat.c_str());
+
+   Glib::ustring format = myformat.empty() ? get_subtitle_format_from_file_reader(reader) : myformat;
+
+   open_from_reader(document, reader, format);
+
+   se_dbg_msg(SE_DBG_APP, "The file %s has been read with success.", reader->get_uri().c_str());
+}
+
+// Try to determine the format of a file already read, only the beginning
+// of the file is used. Can be called outside the main thread.
+// Exceptions: UnrecognizeFormatError.
+Glib::ustring SubtitleFormatSystem::get_subtitle_format_from_file_reader(FileReader* reader) {
+   // Like open_from_uri, only the beginning of the file is used to
+   // determine the format. Do not cut an UTF-8 character.
+   const std::string& data = reader->get_data().raw();
+   if (data.size() <= 1000)
+      return get_subtitle_format_from_small_contents(reader);
+
+   std::string::size_type size = 1000;
+   while (size > 0 && (static_cast<unsigned char>(data[size]) & 0xC0) == 0x80)
+      --size;
+
+   Reader small(data.substr(0, size));
+   return get_subtitle_format_from_small_contents(&small);
+}
+
 // Try to open a ustring as a subtitle file
 // Charset is assumed to be UTF-8.
 // Exceptions: UnrecognizeFormatError, Glib::Error...
@@ -265,19 +353,19 @@ void SubtitleFormatSystem::save_to_data(Document* document, Glib::ustring& dst,
 std::list<SubtitleFormatInfo> SubtitleFormatSystem::get_infos() {
    std::list<SubtitleFormatInfo> infos;
 
-   auto list_of_sf = get_subtitle_format_list();
-   for (const auto& sf : list_of_sf) {
-      infos.push_back(sf->get_info());
+   auto entries = get_format_entries();
+   for (const auto& entry : entries) {
+      infos.push_back(entry->info);
    }
    return infos;
 }
 
 // Return information about the subtitle format.
 bool SubtitleFormatSystem::get_info(const Glib::ustring& subtitle_format, SubtitleFormatInfo& info) {
-   auto infos = get_infos();
-   for (const auto& i : infos) {
-      if (i.name == subtitle_format) {
-         info = i;
+   auto entries = get_format_entries();
+   for (const auto& entry : entries) {
+      if (entry->info.name == subtitle_format) {
+         info = entry->info;
          return true;
       }
    }
@@ -286,34 +374,60 @@ bool SubtitleFormatSystem::get_info(const Glib::ustring& subtitle_format, Subtit
 
 // Check if the subtitle format is supported.
 bool SubtitleFormatSystem::is_supported(const Glib::ustring& format) {
-   auto list_of_sf = get_subtitle_format_list();
-   for (const auto& sf : list_of_sf) {
-      if (sf->get_info().name == format)
+   auto entries = get_format_entries();
+   for (const auto& entry : entries) {
+      if (entry->info.name == format)
          return true;
    }
    return false;
 }
 
-// Sort by name (SubtitleInfo.name)
-bool on_sort_sf(SubtitleFormat* a, SubtitleFormat* b) {
-   return a->get_info().name < b->get_info().name;
-}
-
 // Return a list of SubtitleFormat from ExtensionManager.
 SubtitleFormatList SubtitleFormatSystem::get_subtitle_format_list() {
    std::list<SubtitleFormat*> list;
-   // Get from ExtensionManager
+   for (const auto& entry : get_format_entries()) {
+      list.push_back(entry->format);
+   }
+   return list;
+}
+
+// Return the entries of the active subtitle formats sorted by name.
+// The entries are built the first time a format is seen and rebuilt
+// only if the extension has been reloaded.
+std::vector<const SubtitleFormatSystem::FormatEntry*> SubtitleFormatSystem::get_format_entries() {
+   // The workers of the DocumentLoader detect the formats, the entries are
+   // never removed and the extensions are not reloaded while they run.
+   std::lock_guard<std::mutex> lock(m_format_entries_mutex);
+
+   std::vector<const FormatEntry*> entries;
+
    auto sf_list = ExtensionManager::instance().get_info_list_from_categorie("subtitleformat");
    for (const auto& ext_info : sf_list) {
       if (ext_info->get_active() == false)
          continue;
 
       auto sf = dynamic_cast<SubtitleFormat*>(ext_info->get_extension());
-      if (sf)
-         list.push_back(sf);
+      if (sf == nullptr)
+         continue;
+
+      FormatEntry& entry = m_format_entries[ext_info];
+      if (entry.format != sf) {
+         entry.format = sf;
+         entry.info = sf->get_info();
+         entry.magic = get_pattern_magic(entry.info.pattern);
+         try {
+            entry.regex = Glib::Regex::create(entry.info.pattern, Glib::REGEX_MULTILINE | Glib::REGEX_OPTIMIZE);
+         } catch (const Glib::Error& ex) {
+            std::cerr << "Failed to compile the pattern of the format '" << entry.info.name << "': " << ex.what() << std::endl;
+            entry.regex.reset();
+         }
+         se_dbg_msg(SE_DBG_APP, "Compiled the pattern of '%s' (magic='%s')", entry.info.name.c_str(), entry.magic.c_str());
+      }
+      entries.push_back(&entry);
    }
-   list.sort(on_sort_sf);
-   return list;
+
+   std::sort(entries.begin(), entries.end(), [](const FormatEntry* a, const FormatEntry* b) { return a->info.name < b->info.name; });
+   return entries;
 }
 
 // Return quickly the extension used by the format or an empty string
@@ -20,9 +20,15 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <map>
+#include <mutex>
+#include <vector>
+
 #include "document.h"
 #include "subtitleformatio.h"
 
+class ExtensionInfo;
+class FileReader;
 class SubtitleFormat;
 
 typedef std::list<SubtitleFormat*> SubtitleFormatList;
@@ -39,6 +45,17 @@ class SubtitleFormatSystem {
    // Glib::Error...
    void open_from_uri(Document* document, const Glib::ustring& uri, const Glib::ustring& charset, const Glib::ustring& format = Glib::ustring());
 
+   // Try to open a subtitle file already read and converted to UTF-8
+   // (the reading can be done outside the main thread).
+   // If format is empty, the automatically detection is used.
+   // Exceptions: UnrecognizeFormatError, Glib::Error...
+   void open_from_file_reader(Document* document, FileReader* reader, const Glib::ustring& format = Glib::ustring());
+
+   // Try to determine the format of a file already read, only the beginning
+   // of the file is used. Can be called outside the main thread.
+   // Exceptions: UnrecognizeFormatError.
+   Glib::ustring get_subtitle_format_from_file_reader(FileReader* reader);
+
    // Try to open a ustring as a subtitle file
    // Charset is assumed to be UTF-8.
    // Exceptions: UnrecognizeFormatError, Glib::Error...
@@ -67,6 +84,17 @@ class SubtitleFormatSystem {
    Glib::ustring get_extension_of_format(const Glib::ustring& format);
 
   protected:
+   // A registered subtitle format with its information and its compiled
+   // sniffer. The pattern is compiled once, and the leading literal of the
+   // pattern (magic) is kept to reject the format with a simple search
+   // before running the regex.
+   struct FormatEntry {
+      SubtitleFormat* format{nullptr};
+      SubtitleFormatInfo info;
+      Glib::RefPtr<Glib::Regex> regex;
+      std::string magic;
+   };
+
    // Constructor
    SubtitleFormatSystem();
 
@@ -96,6 +124,18 @@ class SubtitleFormatSystem {
    // Return a list of SubtitleFormat from ExtensionManager.
    SubtitleFormatList get_subtitle_format_list();
 
+   // Return the entries of the active subtitle formats sorted by name.
+   // The entries are built the first time a format is seen and rebuilt
+   // only if the extension has been reloaded.
+   std::vector<const FormatEntry*> get_format_entries();
+
+   // Check if the format can read the contents.
+   static bool match_format(const FormatEntry& entry, const Glib::ustring& contents);
+
+  protected:
+   std::map<ExtensionInfo*, FormatEntry> m_format_entries;
+   std::mutex m_format_entries_mutex;
+
    // Abstract way to read content from file or data (ustring)
    // Exceptions: UnrecognizeFormatError, Glib::Error...
    void open_from_reader(Document* document, Reader* reader, const Glib::ustring& format = Glib::ustring());
@@ -53,6 +53,10 @@ class AddSubtitleCommand : public Command {
       get_document_subtitle_model()->rebuild_column_num();
    }
 
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) + Command::get_memory_size(m_backup);
+   }
+
   protected:
    std::map<Glib::ustring, Glib::ustring> m_backup;
 };
@@ -83,12 +87,25 @@ class RemoveSubtitleCommand : public Command {
       get_document_subtitle_model()->rebuild_column_num();
    }
 
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) + Command::get_memory_size(m_backup);
+   }
+
   protected:
    std::map<Glib::ustring, Glib::ustring> m_backup;
 };
 
 SubtitleModel::SubtitleModel(Document* doc) : m_document(doc) {
    set_column_types(m_column);
+
+   signal_row_changed().connect(sigc::mem_fun(*this, &SubtitleModel::on_row_changed_time_index));
+   signal_row_inserted().connect(sigc::hide(sigc::hide(sigc::mem_fun(*this, &SubtitleModel::invalidate_time_index))));
+   signal_row_deleted().connect(sigc::hide(sigc::mem_fun(*this, &SubtitleModel::invalidate_time_index)));
+   signal_rows_reordered().connect(sigc::hide(sigc::hide(sigc::hide(sigc::mem_fun(*this, &SubtitleModel::invalidate_time_index)))));
+
+   signal_row_inserted().connect(sigc::hide(sigc::hide(m_signal_rows_changed.make_slot())));
+   signal_row_deleted().connect(sigc::hide(m_signal_rows_changed.make_slot()));
+   signal_rows_reordered().connect(sigc::hide(sigc::hide(sigc::hide(m_signal_rows_changed.make_slot()))));
 }
 
 Gtk::TreeIter SubtitleModel::append() {
@@ -233,6 +250,15 @@ unsigned int SubtitleModel::getSize() {
 // grace a son numero
 Gtk::TreeIter SubtitleModel::find(unsigned int num) {
    Gtk::TreeNodeChildren rows = children();
+
+   // num is normally the row index + 1 (rebuild_column_num),
+   // check this row first before scanning the whole model
+   if (num > 0 && num <= rows.size()) {
+      Gtk::TreeIter it = rows[num - 1];
+      if ((*it)[m_column.num] == num)
+         return it;
+   }
+
    for (Gtk::TreeIter it = rows.begin(); it; ++it) {
       if ((*it)[m_column.num] == num)
          return it;
@@ -241,21 +267,80 @@ Gtk::TreeIter SubtitleModel::find(unsigned int num) {
    return nul;
 }
 
-Gtk::TreeIter SubtitleModel::find(const SubtitleTime& time) {
-   // We need to convert time to frame if the current model is frame based.
-   long val = 0;
+// We need to convert time to frame if the current model is frame based.
+long SubtitleModel::time_to_value(const SubtitleTime& time) {
    if (m_document->get_timing_mode() == TIME)
-      val = time.totalmsecs;
-   else
-      val = SubtitleTime::time_to_frame(time, get_framerate_value(m_document->get_framerate()));
+      return time.totalmsecs;
+   return SubtitleTime::time_to_frame(time, get_framerate_value(m_document->get_framerate()));
+}
+
+void SubtitleModel::invalidate_time_index() {
+   m_time_index_valid = false;
+}
+
+void SubtitleModel::check_time_index() {
+   if (m_time_index_valid)
+      return;
 
    Gtk::TreeNodeChildren rows = children();
+
+   std::vector<long> starts, ends;
+   starts.reserve(rows.size());
+   ends.reserve(rows.size());
+
    for (Gtk::TreeIter it = rows.begin(); it; ++it) {
-      if (val >= long((*it)[m_column.start_value]) && val <= long((*it)[m_column.end_value]))
-         return it;
+      starts.push_back((*it)[m_column.start_value]);
+      ends.push_back((*it)[m_column.end_value]);
    }
-   Gtk::TreeIter nul;
-   return nul;
+
+   m_time_index.build(starts, ends);
+   m_time_index_valid = true;
+}
+
+void SubtitleModel::on_row_changed_time_index(const Gtk::TreeModel::Path& path, const Gtk::TreeIter& iter) {
+   if (!m_time_index_valid || path.empty())
+      return;
+
+   unsigned int row = static_cast<unsigned int>(path[0]);
+   long start = (*iter)[m_column.start_value];
+   long end = (*iter)[m_column.end_value];
+
+   if (m_time_index.has_times(row, start, end))
+      return;
+
+   if (!m_time_index.update(row, start, end))
+      m_time_index_valid = false;
+}
+
+Gtk::TreeIter SubtitleModel::find(const SubtitleTime& time) {
+   check_time_index();
+
+   int row = m_time_index.find_first(time_to_value(time));
+   if (row < 0) {
+      Gtk::TreeIter nul;
+      return nul;
+   }
+   return children()[row];
+}
+
+std::vector<Gtk::TreeIter> SubtitleModel::find(const SubtitleTime& start, const SubtitleTime& end) {
+   check_time_index();
+
+   std::vector<Gtk::TreeIter> iters;
+
+   Gtk::TreeNodeChildren rows = children();
+   for (unsigned int row : m_time_index.find(time_to_value(start), time_to_value(end))) iters.push_back(rows[row]);
+   return iters;
+}
+
+std::vector<std::pair<Gtk::TreeIter, Gtk::TreeIter>> SubtitleModel::find_overlaps() {
+   check_time_index();
+
+   std::vector<std::pair<Gtk::TreeIter, Gtk::TreeIter>> iters;
+
+   Gtk::TreeNodeChildren rows = children();
+   for (const auto& pair : m_time_index.find_overlaps()) iters.push_back({rows[pair.first], rows[pair.second]});
+   return iters;
 }
 
 // hack ?
@@ -291,15 +376,14 @@ Gtk::TreeIter SubtitleModel::find_text(Gtk::TreeIter& start, const Glib::ustring
 }
 
 // recherche l'iterator precedant iter
+// The ListStore keeps its rows in a GSequence, stepping back from iter
+// is done by the model itself (gtk_tree_model_iter_previous) and stays
+// valid across insert/erase/reorder. No need to scan from the first row,
+// this is called for every start time change (update_gap_before).
 Gtk::TreeIter SubtitleModel::find_previous(const Gtk::TreeIter& iter) {
-   Gtk::TreeIter res;
-   Gtk::TreeNodeChildren rows = children();
-   for (Gtk::TreeIter it = rows.begin(); it; ++it) {
-      if (it == iter)
-         return res;
-
-      res = it;
-   }
+   Gtk::TreeIter res = iter;
+   if (res)
+      --res;
    return res;
 }
 
@@ -364,6 +448,44 @@ void SubtitleModel::rebuild_column_num() {
    }
 }
 
+// Return the value of the column, or the default value without reading
+// the GValue when the column is not asked.
+template <class T>
+static T get_column_value(const Gtk::TreeRow& row, const Gtk::TreeModelColumn<T>& column, guint mask, guint flag) {
+   if (mask & flag)
+      return row.get_value(column);
+   return T();
+}
+
+// Fill snapshot with a typed copy of all the rows, in one pass.
+void SubtitleModel::get_snapshot(SubtitleSnapshot& snapshot, guint mask) {
+   Gtk::TreeNodeChildren rows = children();
+
+   snapshot.clear(mask);
+   snapshot.reserve(rows.size());
+
+   for (Gtk::TreeIter it = rows.begin(); it; ++it) {
+      Gtk::TreeRow row = *it;
+
+      snapshot.append(get_column_value(row, m_column.num, mask, SubtitleSnapshot::NUM),
+                      get_column_value(row, m_column.start_value, mask, SubtitleSnapshot::START),
+                      get_column_value(row, m_column.end_value, mask, SubtitleSnapshot::END),
+                      get_column_value(row, m_column.duration_value, mask, SubtitleSnapshot::DURATION),
+                      get_column_value(row, m_column.layer, mask, SubtitleSnapshot::LAYER),
+                      get_column_value(row, m_column.style, mask, SubtitleSnapshot::STYLE),
+                      get_column_value(row, m_column.name, mask, SubtitleSnapshot::NAME),
+                      get_column_value(row, m_column.marginL, mask, SubtitleSnapshot::MARGIN_L),
+                      get_column_value(row, m_column.marginR, mask, SubtitleSnapshot::MARGIN_R),
+                      get_column_value(row, m_column.marginV, mask, SubtitleSnapshot::MARGIN_V),
+                      get_column_value(row, m_column.text, mask, SubtitleSnapshot::TEXT),
+                      get_column_value(row, m_column.translation, mask, SubtitleSnapshot::TRANSLATION));
+   }
+}
+
+sigc::signal<void>& SubtitleModel::signal_rows_changed() {
+   return m_signal_rows_changed;
+}
+
 bool SubtitleModel::drag_data_delete_vfunc(const TreeModel::Path& path) {
    m_document->add_command(new RemoveSubtitleCommand(m_document, get_iter(path)));
    m_document->finish_command();
@@ -22,7 +22,9 @@
 
 #include <gtkmm.h>
 
+#include "subtitlesnapshot.h"
 #include "subtitletime.h"
+#include "subtitletimeindex.h"
 
 class NameModel : public Gtk::ListStore {
   public:
@@ -131,10 +133,19 @@ class SubtitleModel : public Gtk::ListStore {
    // si time est compris entre start et end
    Gtk::TreeIter find(const SubtitleTime& time);
 
+   // Return the subtitles which intersect [start, end], in the order of the model.
+   // It uses the time index, O(log n + k).
+   std::vector<Gtk::TreeIter> find(const SubtitleTime& start, const SubtitleTime& end);
+
+   // Return every pair of subtitles whose times overlap, in the order of the model.
+   // It uses the time index, O(n log n + k).
+   std::vector<std::pair<Gtk::TreeIter, Gtk::TreeIter>> find_overlaps();
+
    // recherche a partir de start (+1) dans le text des subtitles
    Gtk::TreeIter find_text(Gtk::TreeIter& start, const Glib::ustring& text);
 
    // recherche l'iterator precedant iter
+   // (constant time, use the model neighbour)
    Gtk::TreeIter find_previous(const Gtk::TreeIter& iter);
 
    // recherche l'iterator suivant iter
@@ -164,7 +175,27 @@ class SubtitleModel : public Gtk::ListStore {
    // check la colonne num pour init de [1,size]
    void rebuild_column_num();
 
+   // Fill snapshot with a typed copy of all the rows, in one pass.
+   // Only the columns of the mask (SubtitleSnapshot::Column) are read.
+   void get_snapshot(SubtitleSnapshot& snapshot, guint mask = SubtitleSnapshot::ALL);
+
+   // Emitted when subtitles are inserted, removed or moved,
+   // the rows of the subtitles are no longer the same.
+   sigc::signal<void>& signal_rows_changed();
+
   protected:
+   // Convert the time to the value of the model (frame or msecs).
+   long time_to_value(const SubtitleTime& time);
+
+   // Rebuild the time index if a change has invalidated it.
+   void check_time_index();
+
+   // Keep the time index up to date with the times of the row,
+   // a change of text doesn't touch it.
+   void on_row_changed_time_index(const Gtk::TreeModel::Path& path, const Gtk::TreeIter& iter);
+
+   void invalidate_time_index();
+
    virtual bool drag_data_delete_vfunc(const TreeModel::Path& path);
 
    virtual bool drag_data_received_vfunc(const TreeModel::Path& dest, const Gtk::SelectionData& selection_data);
@@ -173,5 +204,10 @@ class SubtitleModel : public Gtk::ListStore {
    Document* m_document;
    SubtitleColumnRecorder m_column;
 
+   SubtitleTimeIndex m_time_index;
+   bool m_time_index_valid{false};
+
+   sigc::signal<void> m_signal_rows_changed;
+
    sigc::signal<void, const Gtk::TreePath&, const Gtk::TreePath&> m_my_signal_row_reorderer;
 };
@@ -45,6 +45,10 @@ class AppendSubtitleCommand : public Command {
       get_document_subtitle_model()->rebuild_column_num();
    }
 
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) + Command::get_memory_size(m_path);
+   }
+
   protected:
    Glib::ustring m_path;
 };
@@ -93,6 +97,14 @@ class RemoveSubtitlesCommand : public Command {
       document()->emit_signal("subtitle-insered");
    }
 
+   gsize get_memory_size() const {
+      gsize size = sizeof(*this) + Command::get_memory_size(m_description);
+      for (const auto& backup : m_backup) {
+         size += Command::get_memory_size(backup);
+      }
+      return size;
+   }
+
   protected:
    std::vector<std::map<Glib::ustring, Glib::ustring> > m_backup;
 };
@@ -125,6 +137,10 @@ class InsertSubtitleCommand : public Command {
       get_document_subtitle_model()->rebuild_column_num();
    }
 
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) + Command::get_memory_size(m_path);
+   }
+
   protected:
    TYPE m_type;
    Glib::ustring m_path;
@@ -146,6 +162,11 @@ class ReorderSubtitlesCommand : public Command {
       get_document_subtitle_model()->rebuild_column_num();
    }
 
+   gsize get_memory_size() const {
+      return sizeof(*this) + Command::get_memory_size(m_description) +
+             (m_new_order.capacity() + m_old_order.capacity()) * sizeof(gint);
+   }
+
   protected:
    std::vector<gint> m_new_order;
    std::vector<gint> m_old_order;
@@ -163,12 +184,17 @@ class SortedBuffer {
       return (a.time < b.time);
    }
 
+   // The times are in the document timing mode (FRAME or TIME),
+   // the order is the same.
    static void create_buffers(Subtitles& subtitles, std::vector<SortedBuffer>& buf) {
-      gint index = 0;
-      for (Subtitle s = subtitles.get_first(); s; ++s, ++index) {
+      // only the columns of the sort
+      SubtitleSnapshot snapshot;
+      subtitles.get_snapshot(snapshot, SubtitleSnapshot::NUM | SubtitleSnapshot::START);
+
+      for (guint index = 0; index < snapshot.size(); ++index) {
          buf[index].index = index;
-         buf[index].num = s.get_num();
-         buf[index].time = s.get_start().totalmsecs;
+         buf[index].num = snapshot.num(index);
+         buf[index].time = snapshot.start(index);
       }
    }
 
@@ -305,6 +331,52 @@ Subtitle Subtitles::find(const SubtitleTime& time) {
    return Subtitle(&m_document, m_document.get_subtitle_model()->find(time));
 }
 
+// Return the subtitles which intersect [start, end], in the order of the document.
+// It uses the time index of the model, the whole document isn't scanned.
+std::vector<Subtitle> Subtitles::find(const SubtitleTime& start, const SubtitleTime& end) {
+   std::vector<Subtitle> subs;
+   for (const Gtk::TreeIter& iter : m_document.get_subtitle_model()->find(start, end)) subs.push_back(Subtitle(&m_document, iter));
+   return subs;
+}
+
+// Return every pair of subtitles whose times overlap, in the order of the document.
+// It's a sweep line on the time index of the model, O(n log n + k).
+std::vector<std::pair<Subtitle, Subtitle>> Subtitles::find_overlaps() {
+   std::vector<std::pair<Subtitle, Subtitle>> subs;
+   for (const auto& pair : m_document.get_subtitle_model()->find_overlaps())
+      subs.push_back({Subtitle(&m_document, pair.first), Subtitle(&m_document, pair.second)});
+   return subs;
+}
+
+// Return a read only, typed copy of all the subtitles.
+// Prefer it for the passes which read the whole document.
+void Subtitles::get_snapshot(SubtitleSnapshot& snapshot) {
+   m_document.get_subtitle_model()->get_snapshot(snapshot);
+}
+
+// Same but only the columns of the mask (SubtitleSnapshot::Column) are filled.
+void Subtitles::get_snapshot(SubtitleSnapshot& snapshot, guint mask) {
+   m_document.get_subtitle_model()->get_snapshot(snapshot, mask);
+}
+
+// Call the slot with the row of the path.
+static void on_model_row_changed(const Gtk::TreeModel::Path& path, const Gtk::TreeIter&, const sigc::slot<void, unsigned int>& slot) {
+   if (!path.empty())
+      slot(path[0]);
+}
+
+// Connect to the changes of the subtitles,
+// the slot receives the row (num - 1) of the subtitle changed.
+sigc::connection Subtitles::connect_row_changed(const sigc::slot<void, unsigned int>& slot) {
+   return m_document.get_subtitle_model()->signal_row_changed().connect(sigc::bind(sigc::ptr_fun(&on_model_row_changed), slot));
+}
+
+// Connect to the insertion, the removal or the move of subtitles,
+// the rows of the subtitles are no longer the same.
+sigc::connection Subtitles::connect_rows_changed(const sigc::slot<void>& slot) {
+   return m_document.get_subtitle_model()->signal_rows_changed().connect(slot);
+}
+
 // Selection
 
 std::vector<Subtitle> Subtitles::get_selection() {
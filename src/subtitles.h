@@ -20,6 +20,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
+#include <utility>
 #include <vector>
 
 #include "subtitle.h"
@@ -59,6 +60,29 @@ class Subtitles {
 
    Subtitle find(const SubtitleTime& time);
 
+   // Return the subtitles which intersect [start, end], in the order of the document.
+   // An invalid subtitle (start > end) is found on [end, start].
+   std::vector<Subtitle> find(const SubtitleTime& start, const SubtitleTime& end);
+
+   // Return every pair of subtitles whose times overlap, in the order of the document.
+   // The subtitles which only touch don't overlap.
+   std::vector<std::pair<Subtitle, Subtitle>> find_overlaps();
+
+   // Return a read only, typed copy of all the subtitles.
+   // Prefer it for the passes which read the whole document.
+   void get_snapshot(SubtitleSnapshot& snapshot);
+
+   // Same but only the columns of the mask (SubtitleSnapshot::Column) are filled.
+   void get_snapshot(SubtitleSnapshot& snapshot, guint mask);
+
+   // Connect to the changes of the subtitles,
+   // the slot receives the row (num - 1) of the subtitle changed.
+   sigc::connection connect_row_changed(const sigc::slot<void, unsigned int>& slot);
+
+   // Connect to the insertion, the removal or the move of subtitles,
+   // the rows of the subtitles are no longer the same.
+   sigc::connection connect_rows_changed(const sigc::slot<void>& slot);
+
    // Selection
 
    std::vector<Subtitle> get_selection();
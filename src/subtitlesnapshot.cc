@@ -0,0 +1,167 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "subtitlesnapshot.h"
+
+#include <cstdlib>
+
+// The margins and the layer are stored as string in the model,
+// an empty or invalid value is 0.
+static int to_int(const Glib::ustring& value) {
+   return static_cast<int>(std::strtol(value.c_str(), nullptr, 10));
+}
+
+SubtitleSnapshot::SubtitleSnapshot() {
+   clear();
+}
+
+void SubtitleSnapshot::clear(guint mask) {
+   m_mask = mask;
+   m_size = 0;
+
+   m_num.clear();
+   m_start.clear();
+   m_end.clear();
+   m_duration.clear();
+   m_layer.clear();
+   m_margin_l.clear();
+   m_margin_r.clear();
+   m_margin_v.clear();
+   m_style.clear();
+   m_name.clear();
+
+   m_strings.clear();
+   m_string_ids.clear();
+
+   m_text_arena.clear();
+   m_text_offset.assign(1, 0);
+   m_translation_arena.clear();
+   m_translation_offset.assign(1, 0);
+}
+
+void SubtitleSnapshot::reserve(unsigned int n) {
+   if (m_mask & NUM)
+      m_num.reserve(n);
+   if (m_mask & START)
+      m_start.reserve(n);
+   if (m_mask & END)
+      m_end.reserve(n);
+   if (m_mask & DURATION)
+      m_duration.reserve(n);
+   if (m_mask & LAYER)
+      m_layer.reserve(n);
+   if (m_mask & MARGIN_L)
+      m_margin_l.reserve(n);
+   if (m_mask & MARGIN_R)
+      m_margin_r.reserve(n);
+   if (m_mask & MARGIN_V)
+      m_margin_v.reserve(n);
+   if (m_mask & STYLE)
+      m_style.reserve(n);
+   if (m_mask & NAME)
+      m_name.reserve(n);
+   if (m_mask & TEXT)
+      m_text_offset.reserve(n + 1);
+   if (m_mask & TRANSLATION)
+      m_translation_offset.reserve(n + 1);
+}
+
+unsigned int SubtitleSnapshot::size() const {
+   return m_size;
+}
+
+bool SubtitleSnapshot::empty() const {
+   return m_size == 0;
+}
+
+unsigned int SubtitleSnapshot::append(unsigned int num,
+                                     gint64 start,
+                                     gint64 end,
+                                     gint64 duration,
+                                     const Glib::ustring& layer,
+                                     const Glib::ustring& style,
+                                     const Glib::ustring& name,
+                                     const Glib::ustring& margin_l,
+                                     const Glib::ustring& margin_r,
+                                     const Glib::ustring& margin_v,
+                                     const Glib::ustring& text,
+                                     const Glib::ustring& translation) {
+   if (m_mask & NUM)
+      m_num.push_back(num);
+   if (m_mask & START)
+      m_start.push_back(start);
+   if (m_mask & END)
+      m_end.push_back(end);
+   if (m_mask & DURATION)
+      m_duration.push_back(duration);
+   if (m_mask & LAYER)
+      m_layer.push_back(to_int(layer));
+   if (m_mask & MARGIN_L)
+      m_margin_l.push_back(to_int(margin_l));
+   if (m_mask & MARGIN_R)
+      m_margin_r.push_back(to_int(margin_r));
+   if (m_mask & MARGIN_V)
+      m_margin_v.push_back(to_int(margin_v));
+   if (m_mask & STYLE)
+      m_style.push_back(intern(style));
+   if (m_mask & NAME)
+      m_name.push_back(intern(name));
+
+   if (m_mask & TEXT) {
+      m_text_arena.append(text.raw());
+      m_text_offset.push_back(m_text_arena.size());
+   }
+   if (m_mask & TRANSLATION) {
+      m_translation_arena.append(translation.raw());
+      m_translation_offset.push_back(m_translation_arena.size());
+   }
+
+   return m_size++;
+}
+
+std::string_view SubtitleSnapshot::text_view(unsigned int i) const {
+   return std::string_view(m_text_arena.data() + m_text_offset[i], m_text_offset[i + 1] - m_text_offset[i]);
+}
+
+std::string_view SubtitleSnapshot::translation_view(unsigned int i) const {
+   return std::string_view(m_translation_arena.data() + m_translation_offset[i],
+                           m_translation_offset[i + 1] - m_translation_offset[i]);
+}
+
+Glib::ustring SubtitleSnapshot::text(unsigned int i) const {
+   std::string_view view = text_view(i);
+   return Glib::ustring(view.begin(), view.end());
+}
+
+Glib::ustring SubtitleSnapshot::translation(unsigned int i) const {
+   std::string_view view = translation_view(i);
+   return Glib::ustring(view.begin(), view.end());
+}
+
+guint SubtitleSnapshot::intern(const Glib::ustring& str) {
+   auto it = m_string_ids.find(str);
+   if (it != m_string_ids.end())
+      return it->second;
+
+   guint id = m_strings.size();
+   m_strings.push_back(str);
+   m_string_ids[str] = id;
+   return id;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <glibmm.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A read only snapshot of the subtitles of a document, typed and column
+// oriented. Each field is stored in its own contiguous array: times as int64
+// (in the document timing mode, FRAME or TIME), layer and margins as numbers,
+// style and actor names as interned ids, texts in a single string arena.
+// The subtitles are still stored in the Gtk::ListStore (SubtitleModel), the
+// snapshot is a copy filled in one pass by Subtitles::get_snapshot() and it
+// isn't updated when the document changes. Use it for the batch passes
+// (sort, checking...) which read every subtitle instead of going through the
+// GValue of the model for each field.
+// A pass can only ask for the columns it reads (mask), the others are
+// not filled and must not be accessed.
+class SubtitleSnapshot {
+  public:
+   enum Column {
+      NUM = 1 << 0,
+      START = 1 << 1,
+      END = 1 << 2,
+      DURATION = 1 << 3,
+      LAYER = 1 << 4,
+      STYLE = 1 << 5,
+      NAME = 1 << 6,
+      MARGIN_L = 1 << 7,
+      MARGIN_R = 1 << 8,
+      MARGIN_V = 1 << 9,
+      TEXT = 1 << 10,
+      TRANSLATION = 1 << 11,
+      ALL = (1 << 12) - 1
+   };
+
+   SubtitleSnapshot();
+
+   // Remove all rows and interned strings,
+   // the next rows only fill the columns of the mask.
+   void clear(guint mask = ALL);
+
+   // Return the columns filled.
+   guint mask() const {
+      return m_mask;
+   }
+
+   // Reserve the memory for n rows.
+   void reserve(unsigned int n);
+
+   // Return the number of rows.
+   unsigned int size() const;
+
+   bool empty() const;
+
+   // Append a row and return its index.
+   // The values of the columns which are not in the mask are ignored.
+   unsigned int append(unsigned int num,
+                       gint64 start,
+                       gint64 end,
+                       gint64 duration,
+                       const Glib::ustring& layer,
+                       const Glib::ustring& style,
+                       const Glib::ustring& name,
+                       const Glib::ustring& margin_l,
+                       const Glib::ustring& margin_r,
+                       const Glib::ustring& margin_v,
+                       const Glib::ustring& text,
+                       const Glib::ustring& translation);
+
+   unsigned int num(unsigned int i) const {
+      return m_num[i];
+   }
+
+   gint64 start(unsigned int i) const {
+      return m_start[i];
+   }
+
+   gint64 end(unsigned int i) const {
+      return m_end[i];
+   }
+
+   gint64 duration(unsigned int i) const {
+      return m_duration[i];
+   }
+
+   int layer(unsigned int i) const {
+      return m_layer[i];
+   }
+
+   int margin_l(unsigned int i) const {
+      return m_margin_l[i];
+   }
+
+   int margin_r(unsigned int i) const {
+      return m_margin_r[i];
+   }
+
+   int margin_v(unsigned int i) const {
+      return m_margin_v[i];
+   }
+
+   // Interned id of the style/actor name, the same name has the same id.
+   guint style_id(unsigned int i) const {
+      return m_style[i];
+   }
+
+   guint name_id(unsigned int i) const {
+      return m_name[i];
+   }
+
+   const Glib::ustring& style(unsigned int i) const {
+      return m_strings[m_style[i]];
+   }
+
+   const Glib::ustring& name(unsigned int i) const {
+      return m_strings[m_name[i]];
+   }
+
+   // View on the text (UTF-8) in the arena, no copy.
+   std::string_view text_view(unsigned int i) const;
+
+   std::string_view translation_view(unsigned int i) const;
+
+   Glib::ustring text(unsigned int i) const;
+
+   Glib::ustring translation(unsigned int i) const;
+
+   // The whole arrays, for the loops over all rows.
+   const std::vector<gint64>& starts() const {
+      return m_start;
+   }
+
+   const std::vector<gint64>& ends() const {
+      return m_end;
+   }
+
+   const std::vector<gint64>& durations() const {
+      return m_duration;
+   }
+
+  protected:
+   guint intern(const Glib::ustring& str);
+
+  protected:
+   guint m_mask;
+   unsigned int m_size;
+
+   std::vector<unsigned int> m_num;
+   std::vector<gint64> m_start;
+   std::vector<gint64> m_end;
+   std::vector<gint64> m_duration;
+   std::vector<int> m_layer;
+   std::vector<int> m_margin_l;
+   std::vector<int> m_margin_r;
+   std::vector<int> m_margin_v;
+   std::vector<guint> m_style;
+   std::vector<guint> m_name;
+
+   // interned strings (style, actor)
+   std::vector<Glib::ustring> m_strings;
+   std::map<Glib::ustring, guint> m_string_ids;
+
+   // text and translation arena, the row i is [offset[i], offset[i+1])
+   std::string m_text_arena;
+   std::vector<std::string::size_type> m_text_offset;
+   std::string m_translation_arena;
+   std::vector<std::string::size_type> m_translation_offset;
+};
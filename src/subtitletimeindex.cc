@@ -0,0 +1,214 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "subtitletimeindex.h"
+
+#include <algorithm>
+#include <functional>
+
+void SubtitleTimeIndex::build(const std::vector<long>& starts, const std::vector<long>& ends) {
+   const unsigned int size = static_cast<unsigned int>(starts.size());
+
+   m_entries.resize(size);
+   for (unsigned int i = 0; i < size; ++i) m_entries[i] = {starts[i], ends[i], i};
+
+   // the subtitles are usually already sorted, don't pay the sort for them
+   auto less = [](const Entry& a, const Entry& b) {
+      return a.lo() < b.lo() || (a.lo() == b.lo() && a.row < b.row);
+   };
+   if (!std::is_sorted(m_entries.begin(), m_entries.end(), less))
+      std::sort(m_entries.begin(), m_entries.end(), less);
+
+   m_positions.resize(size);
+   for (unsigned int i = 0; i < size; ++i) m_positions[m_entries[i].row] = i;
+
+   m_max_hi.resize(size);
+   update_max_hi(0, false);
+}
+
+void SubtitleTimeIndex::update_max_hi(std::vector<long>::size_type from, bool increased) {
+   for (auto i = from; i < m_entries.size(); ++i) {
+      long max_hi = (i > 0) ? std::max(m_max_hi[i - 1], m_entries[i].hi()) : m_entries[i].hi();
+      // when a value increased, the next ones don't change once one is the same
+      if (increased && i > from && m_max_hi[i] == max_hi)
+         break;
+      m_max_hi[i] = max_hi;
+   }
+}
+
+bool SubtitleTimeIndex::update(unsigned int row, long start, long end) {
+   if (row >= m_positions.size())
+      return false;
+
+   unsigned int pos = m_positions[row];
+   Entry& entry = m_entries[pos];
+
+   const long lo = std::min(start, end);
+   const long hi = std::max(start, end);
+
+   if (entry.lo() != lo) {
+      // the entry must stay between its neighbours
+      if (pos > 0) {
+         const Entry& prev = m_entries[pos - 1];
+         if (prev.lo() > lo || (prev.lo() == lo && prev.row > row))
+            return false;
+      }
+      if (pos + 1 < m_entries.size()) {
+         const Entry& next = m_entries[pos + 1];
+         if (next.lo() < lo || (next.lo() == lo && next.row < row))
+            return false;
+      }
+   }
+
+   bool hi_changed = entry.hi() != hi;
+   bool increased = hi > entry.hi();
+
+   entry.start = start;
+   entry.end = end;
+
+   if (hi_changed)
+      update_max_hi(pos, increased);
+   return true;
+}
+
+bool SubtitleTimeIndex::has_times(unsigned int row, long start, long end) const {
+   if (row >= m_positions.size())
+      return false;
+   const Entry& entry = m_entries[m_positions[row]];
+   return entry.start == start && entry.end == end;
+}
+
+std::vector<unsigned int> SubtitleTimeIndex::find(long start, long end) const {
+   std::vector<unsigned int> rows;
+
+   // the entries [first, last) can intersect:
+   // their lower time is <= end and the max of the higher times up to them is >= start
+   auto last = std::upper_bound(m_entries.begin(), m_entries.end(), end, [](long value, const Entry& e) {
+      return value < e.lo();
+   });
+   auto first = m_entries.begin() + (std::lower_bound(m_max_hi.begin(), m_max_hi.end(), start) - m_max_hi.begin());
+
+   for (auto it = first; it < last; ++it) {
+      if (it->hi() >= start)
+         rows.push_back(it->row);
+   }
+   std::sort(rows.begin(), rows.end());
+   return rows;
+}
+
+int SubtitleTimeIndex::find_first(long time) const {
+   // an invalid subtitle (start > end) never contains a time
+   for (unsigned int row : find(time, time)) {
+      const Entry& entry = m_entries[m_positions[row]];
+      if (entry.start <= time && time <= entry.end)
+         return static_cast<int>(row);
+   }
+   return -1;
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> SubtitleTimeIndex::find_overlaps() const {
+   std::vector<std::pair<unsigned int, unsigned int>> pairs;
+
+   // the positions of the entries not ended, in a heap by their higher time
+   std::vector<unsigned int> active;
+   auto ends_after = [this](unsigned int a, unsigned int b) {
+      return m_entries[a].hi() > m_entries[b].hi();
+   };
+
+   for (unsigned int pos = 0; pos < m_entries.size(); ++pos) {
+      const Entry& entry = m_entries[pos];
+
+      // the entries ended before this one can't overlap it or the next ones
+      while (!active.empty() && m_entries[active.front()].hi() <= entry.lo()) {
+         std::pop_heap(active.begin(), active.end(), ends_after);
+         active.pop_back();
+      }
+
+      for (unsigned int other : active) {
+         // an entry without duration only overlaps the entries started before it
+         if (m_entries[other].lo() < entry.hi())
+            pairs.push_back(std::minmax(m_entries[other].row, entry.row));
+      }
+
+      if (entry.lo() < entry.hi()) {
+         active.push_back(pos);
+         std::push_heap(active.begin(), active.end(), ends_after);
+      }
+   }
+   std::sort(pairs.begin(), pairs.end());
+   return pairs;
+}
+
+std::vector<unsigned int> SubtitleTimeIndex::find_overlaps(const SubtitleTimeIndex& other) const {
+   struct Event {
+      long lo;
+      long hi;
+      unsigned int row;
+      bool mine;
+   };
+
+   std::vector<Event> events;
+   events.reserve(m_entries.size() + other.m_entries.size());
+   for (const Entry& entry : m_entries) events.push_back({entry.lo(), entry.hi(), entry.row, true});
+   for (const Entry& entry : other.m_entries) events.push_back({entry.lo(), entry.hi(), entry.row, false});
+
+   // at the same lower time the entries without duration come first,
+   // the entries not ended then always start before them
+   std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+      return a.lo < b.lo || (a.lo == b.lo && a.hi < b.hi);
+   });
+
+   std::vector<unsigned int> rows;
+
+   // the entries not ended, in heaps by their higher time: all of the other
+   // index, only the ones not found yet of this index
+   std::vector<long> others;
+   std::vector<std::pair<long, unsigned int>> mine;
+
+   for (const Event& event : events) {
+      while (!others.empty() && others.front() <= event.lo) {
+         std::pop_heap(others.begin(), others.end(), std::greater<long>());
+         others.pop_back();
+      }
+      while (!mine.empty() && mine.front().first <= event.lo) {
+         std::pop_heap(mine.begin(), mine.end(), std::greater<std::pair<long, unsigned int>>());
+         mine.pop_back();
+      }
+
+      if (event.mine) {
+         if (!others.empty()) {
+            rows.push_back(event.row);
+         } else if (event.lo < event.hi) {
+            mine.push_back({event.hi, event.row});
+            std::push_heap(mine.begin(), mine.end(), std::greater<std::pair<long, unsigned int>>());
+         }
+      } else {
+         for (const auto& entry : mine) rows.push_back(entry.second);
+         mine.clear();
+
+         if (event.lo < event.hi) {
+            others.push_back(event.hi);
+            std::push_heap(others.begin(), others.end(), std::greater<long>());
+         }
+      }
+   }
+   std::sort(rows.begin(), rows.end());
+   return rows;
+}
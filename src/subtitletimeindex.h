@@ -0,0 +1,87 @@
+#pragma once
+
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include <utility>
+#include <vector>
+
+// Index of the times of the subtitles of a model, to find the rows which
+// intersect an interval without scanning the whole model.
+// The entries are sorted by their lower time and each one keeps the max of
+// the higher times of the entries before it, a query is O(log n + k).
+// The times are the values of the model (frame or msecs). An invalid
+// subtitle (start > end) covers [end, start], like it's displayed.
+class SubtitleTimeIndex {
+  public:
+   // Rebuild the index from the times of the rows (in the order of the model).
+   void build(const std::vector<long>& starts, const std::vector<long>& ends);
+
+   // Update the times of a row.
+   // Return false if the order changes, the index needs to be rebuilt.
+   bool update(unsigned int row, long start, long end);
+
+   // Return true if the row has these times in the index.
+   bool has_times(unsigned int row, long start, long end) const;
+
+   // Return the rows which intersect [start, end], sorted by row.
+   std::vector<unsigned int> find(long start, long end) const;
+
+   // Return the first row (in the order of the model) where start <= time <= end,
+   // or -1 if there is none.
+   int find_first(long time) const;
+
+   // Return every pair of rows (first < second) whose times overlap, sorted.
+   // Two subtitles overlap when each one starts before the end of the other,
+   // the subtitles which only touch don't. It's a sweep line on the sorted
+   // entries with a heap of the entries not ended, O(n log n + k) for k pairs.
+   std::vector<std::pair<unsigned int, unsigned int>> find_overlaps() const;
+
+   // Return the rows which overlap at least one row of the other index, sorted.
+   // The same sweep line on the entries of both indexes, O((n + m) log(n + m)).
+   std::vector<unsigned int> find_overlaps(const SubtitleTimeIndex& other) const;
+
+  protected:
+   // Recompute the max of the higher times from the entry 'from'.
+   // If only a value increased, it stops at the first unchanged max.
+   void update_max_hi(std::vector<long>::size_type from, bool increased);
+
+  protected:
+   struct Entry {
+      long start;
+      long end;
+      unsigned int row;
+
+      long lo() const {
+         return start < end ? start : end;
+      }
+
+      long hi() const {
+         return start < end ? end : start;
+      }
+   };
+
+   // sorted by lower time then by row
+   std::vector<Entry> m_entries;
+   // m_max_hi[i] = max(m_entries[0..i].hi())
+   std::vector<long> m_max_hi;
+   // the position of each row in m_entries
+   std::vector<unsigned int> m_positions;
+};
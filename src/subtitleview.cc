@@ -269,6 +269,9 @@ SubtitleView::SubtitleView(Document& doc) {
    // Update the columns size
    m_refDocument->get_signal("edit-timing-mode-changed").connect(sigc::mem_fun(*this, &Gtk::TreeView::columns_autosize));
 
+   // The colors of the timing come from the errors found by the background checking
+   m_refDocument->get_signal("subtitle-errors-changed").connect(sigc::mem_fun(*this, &Gtk::Widget::queue_draw));
+
    // Setup my own copy of needed timing variables
    min_duration = cfg::get_int("timing", "min-display");
    max_cpl = cfg::get_int("timing", "max-characters-per-line");
@@ -409,6 +412,22 @@ void SubtitleView::createColumnLayer() {
    // set_tooltips(column, _("Layer number."));
 }
 
+// Return in errors the errors (SubtitleErrorFlags) found by the background
+// checking, or false if the document isn't checked.
+// The row is the one of the iterator moved by offset (-1 for the previous).
+bool SubtitleView::get_subtitle_errors(const Gtk::TreeModel::iterator& iter, int offset, guint& errors) {
+   const SubtitleErrors& subtitle_errors = m_refDocument->get_subtitle_errors();
+   if (!subtitle_errors.is_valid())
+      return false;
+
+   // the row of a subtitle is its number - 1
+   unsigned int num = (*iter)[m_column.num];
+   int row = static_cast<int>(num) - 1 + offset;
+
+   errors = (row >= 0) ? subtitle_errors.get(row) : 0;
+   return true;
+}
+
 void SubtitleView::cps_data_func(const Gtk::CellRenderer* renderer, const Gtk::TreeModel::iterator& iter) {
    CellRendererTime* trenderer = (CellRendererTime*)renderer;
    Subtitle cur_sub(m_refDocument, iter);
@@ -416,7 +435,12 @@ void SubtitleView::cps_data_func(const Gtk::CellRenderer* renderer, const Gtk::T
    Glib::ustring color("black");  // default
    Glib::ustring cps_text_string = cur_sub.get_characters_per_second_text_string();
    if (check_timing) {
-      const int cmp = cur_sub.check_cps_text(min_cps, max_cps);
+      guint errors = 0;
+      int cmp = 0;
+      if (get_subtitle_errors(iter, 0, errors))
+         cmp = (errors & SUBTITLE_ERROR_MAX_CPS) ? 1 : (errors & SUBTITLE_ERROR_MIN_CPS) ? -1 : 0;
+      else
+         cmp = cur_sub.check_cps_text(min_cps, max_cps);
       if (cmp > 0) {
          color = "red";
          cps_text_string = "<b>" + cps_text_string + "</b>";
@@ -432,6 +456,12 @@ void SubtitleView::cpl_text_data_func(const Gtk::CellRenderer* renderer, const G
    Glib::ustring cpl_text = cur_sub.get_characters_per_line_text();
 
    if (check_timing) {
+      // Only a subtitle with a too long line needs to be checked
+      guint errors = 0;
+      bool check_lines = true;
+      if (get_subtitle_errors(iter, 0, errors))
+         check_lines = (errors & SUBTITLE_ERROR_MAX_CPL) != 0;
+
       // Parse each line and build markup with colors per line
       std::istringstream ss(cpl_text);
       std::string line;
@@ -440,7 +470,7 @@ void SubtitleView::cpl_text_data_func(const Gtk::CellRenderer* renderer, const G
       while (std::getline(ss, line)) {
          int cpl = utility::string_to_int(line);
 
-         if (cpl > max_cpl) {
+         if (check_lines && cpl > max_cpl) {
             // This line exceeds limit - make it red
             lines.push_back(Glib::ustring::compose("<span foreground=\"red\"><b>%1</b></span>", line));
          } else {
@@ -473,8 +503,13 @@ void SubtitleView::duration_data_func(const Gtk::CellRenderer* renderer, const G
    // Display text in red if the check timing option is enabled and
    // if the current subtitle don't respect the minimum duration
    if (check_timing) {
-      if (cur_sub.get_duration().totalmsecs < min_duration)  // duration in msec
+      guint errors = 0;
+      if (get_subtitle_errors(iter, 0, errors)) {
+         if (errors & SUBTITLE_ERROR_MIN_DISPLAY_TIME)
+            color = "red";
+      } else if (cur_sub.get_duration().totalmsecs < min_duration) {  // duration in msec
          color = "red";
+      }
    }
 
    trenderer->property_markup() = cur_sub.convert_value_to_time_string((*iter)[m_column.duration_value], color);
@@ -489,8 +524,14 @@ void SubtitleView::start_time_data_func(const Gtk::CellRenderer* renderer, const
    // Display text in red if the check timing option is enabled and
    // if the current subtitle don't respect gap before subtitle
    if (check_timing) {
-      if (cur_sub.check_gap_before(min_gap) == false)
+      // the gap is an error of the previous subtitle
+      guint errors = 0;
+      if (get_subtitle_errors(iter, -1, errors)) {
+         if (errors & (SUBTITLE_ERROR_MIN_GAP | SUBTITLE_ERROR_OVERLAPPING))
+            color = "red";
+      } else if (cur_sub.check_gap_before(min_gap) == false) {
          color = "red";
+      }
    }
 
    trenderer->property_markup() = cur_sub.convert_value_to_time_string((*iter)[m_column.start_value], color);
@@ -505,8 +546,13 @@ void SubtitleView::end_time_data_func(const Gtk::CellRenderer* renderer, const G
    // Display text in red if the check timing option is enabled and
    // if the current subtitle don't respect gap before subtitle
    if (check_timing) {
-      if (cur_sub.check_gap_after(min_gap) == false)
+      guint errors = 0;
+      if (get_subtitle_errors(iter, 0, errors)) {
+         if (errors & (SUBTITLE_ERROR_MIN_GAP | SUBTITLE_ERROR_OVERLAPPING))
+            color = "red";
+      } else if (cur_sub.check_gap_after(min_gap) == false) {
          color = "red";
+      }
    }
 
    trenderer->property_markup() = cur_sub.convert_value_to_time_string((*iter)[m_column.end_value], color);
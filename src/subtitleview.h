@@ -153,6 +153,11 @@ class SubtitleView : public Gtk::TreeView {
    // Finds next nonskippable column. if it does not exists Returns nullptr
    Gtk::TreeViewColumn* find_next_nonskippable_column(bool going_right);
 
+   // Return in errors the errors (SubtitleErrorFlags) found by the background
+   // checking, or false if the document isn't checked.
+   // The row is the one of the iterator moved by offset (-1 for the previous).
+   bool get_subtitle_errors(const Gtk::TreeModel::iterator& iter, int offset, guint& errors);
+
    void cpl_text_data_func(const Gtk::CellRenderer* renderer, const Gtk::TreeModel::iterator& iter);
 
    void cps_data_func(const Gtk::CellRenderer* renderer, const Gtk::TreeModel::iterator& iter);
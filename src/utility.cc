@@ -23,6 +23,8 @@
 #include <glibmm.h>
 #include <gtkmm.h>
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -327,6 +329,60 @@ Glib::ustring add_or_replace_extension(const Glib::ustring& filename, const Glib
    return renamed;
 }
 
+// Compute a fingerprint of the media file: the SHA-256 of its size, of its
+// first and of its last 64 KiB. It's stable whatever the location of the
+// file and doesn't need to read a whole movie.
+Glib::ustring compute_media_hash(const Glib::ustring& uri) {
+   const std::streamoff chunk_size = 64 * 1024;
+
+   std::string filename;
+   try {
+      filename = Glib::filename_from_uri(uri);
+   } catch (const Glib::ConvertError&) {
+      return Glib::ustring();
+   }
+
+   std::ifstream file(filename.c_str(), std::ios_base::binary);
+   if (!file)
+      return Glib::ustring();
+
+   file.seekg(0, std::ios_base::end);
+   std::streamoff file_size = file.tellg();
+   if (file_size < 0)
+      return Glib::ustring();
+
+   Glib::Checksum checksum(Glib::Checksum::CHECKSUM_SHA256);
+
+   // the size is hashed as a little endian guint64
+   guchar size_field[8];
+   for (int i = 0; i < 8; ++i) size_field[i] = static_cast<guchar>((static_cast<guint64>(file_size) >> (8 * i)) & 0xff);
+   checksum.update(size_field, sizeof(size_field));
+
+   std::vector<char> buffer(static_cast<size_t>(chunk_size));
+   std::streamoff offsets[2] = {0, std::max<std::streamoff>(file_size - chunk_size, 0)};
+   for (std::streamoff offset : offsets) {
+      file.seekg(offset, std::ios_base::beg);
+      file.read(buffer.data(), chunk_size);
+      checksum.update(reinterpret_cast<const guchar*>(buffer.data()), static_cast<gsize>(file.gcount()));
+      file.clear();
+   }
+   return checksum.get_string();
+}
+
+// Return false if the fingerprint saved with the data of a media (waveform,
+// keyframes) isn't the one of the media file. An empty hash (old files)
+// or a media which can't be read is not a mismatch.
+bool media_hash_matches(const Glib::ustring& hash, const Glib::ustring& media_uri) {
+   if (hash.empty() || media_uri.empty())
+      return true;
+
+   Glib::ustring media_hash = compute_media_hash(media_uri);
+   if (media_hash.empty())
+      return true;
+
+   return hash == media_hash;
+}
+
 }  // namespace utility
 
 namespace ASS {
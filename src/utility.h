@@ -150,6 +150,15 @@ Glib::ustring get_stripped_text(const Glib::ustring& text);
 void set_transient_parent(Gtk::Window& window);
 
 Glib::ustring add_or_replace_extension(const Glib::ustring& filename, const Glib::ustring& extension);
+
+// Fingerprint of a media file (hexadecimal SHA-256 of its size and of
+// its first and last 64 KiB), empty if the file can't be read.
+Glib::ustring compute_media_hash(const Glib::ustring& uri);
+
+// Return false if the fingerprint saved with the data of a media (waveform,
+// keyframes) isn't the one of the media file. An empty hash (old files)
+// or a media which can't be read is not a mismatch.
+bool media_hash_matches(const Glib::ustring& hash, const Glib::ustring& media_uri);
 }  // namespace utility
 
 namespace ASS {
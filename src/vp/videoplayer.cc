@@ -306,17 +306,26 @@ bool VideoPlayer::find_subtitle() {
          show_subtitle_text();
       } else if (time < m_subtitle.get_start()) {    // is the next ?
          show_subtitle_null();
+
+         // or a seek back on another subtitle
+         Subtitle sub = doc->subtitles().find(time);
+         if (is_good_subtitle(sub, position)) {
+            m_subtitle = sub;
+            show_subtitle_text();
+         }
       } else if (time >= m_subtitle.get_end()) {     // it's the old...
          // ... try with the next subtitle
          show_subtitle_null();
 
          Subtitle next = doc->subtitles().get_next(m_subtitle);
-         if (next) {
+         if (next && is_good_subtitle(next, position)) {
             m_subtitle = next;
+            show_subtitle_text();
+         } else {
+            // a seek or a gap, the time index finds it without a scan
+            m_subtitle = doc->subtitles().find(time);
             if (is_good_subtitle(m_subtitle, position))
                show_subtitle_text();
-         } else {
-            m_subtitle = Subtitle();
          }
       }
    }
@@ -22,9 +22,21 @@
 
 #include <math.h>
 
+#include <string.h>
+
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
+// Number of values of a level summarised by one value of the next level.
+static const guint64 PEAK_LEVEL_FACTOR = 4;
+
+// Size of the media hash field of the version 3
+static const gsize MEDIA_HASH_SIZE = 64;
+
+// Bits of the quantised values of the version 3
+static const int QUANTISED_BITS = 16;
+
 // Open Wavefrom from file
 Glib::RefPtr<Waveform> Waveform::create_from_file(const Glib::ustring& uri) {
    Glib::RefPtr<Waveform> wf = Glib::RefPtr<Waveform>(new Waveform);
@@ -73,42 +85,256 @@ unsigned int Waveform::get_n_channels() {
    return m_n_channels;
 }
 
-bool Waveform::open(const Glib::ustring& file_uri) {
-   Glib::ustring filename = Glib::filename_from_uri(file_uri);
+Waveform::Peak Waveform::get_peak(unsigned int channel, guint64 first, guint64 last) {
+   Peak peak;
 
-   std::ifstream file(filename.c_str(), std::ios_base::binary);
+   if (channel >= m_n_channels)
+      return peak;
 
-   if (!file) {
-      return false;
+   const std::vector<double>& samples = m_channels[channel];
+
+   last = std::min<guint64>(last, samples.size());
+   if (first >= last)
+      return peak;
+
+   guint64 length = last - first;
+
+   // the coarsest level which has at least one value in the range
+   const PeakLevel* level = nullptr;
+   for (const auto& l : m_peak_levels[channel]) {
+      if (l.factor > length)
+         break;
+      level = &l;
    }
 
-   std::string line;
+   double sum_squares = 0;
 
-   if (!std::getline(file, line)) {
-      file.close();
-      return false;
+   if (level == nullptr) {
+      peak.min = peak.max = static_cast<float>(samples[first]);
+      for (guint64 i = first; i < last; ++i) {
+         float value = static_cast<float>(samples[i]);
+         peak.min = std::min(peak.min, value);
+         peak.max = std::max(peak.max, value);
+         sum_squares += samples[i] * samples[i];
+      }
+      peak.rms = static_cast<float>(sqrt(sum_squares / static_cast<double>(length)));
+      return peak;
    }
 
-   int version = 0;
+   // the blocks are aligned on the level, the range is extended to them
+   guint64 begin = first / level->factor;
+   guint64 end = std::min<guint64>((last + level->factor - 1) / level->factor, level->max.size());
 
-   if (line == "waveform") {
-      version = 1;
-   } else if (line == "waveform v2") {
-      version = 2;
-   } else {
-      file.close();
-      return false;
+   peak.min = level->min[begin];
+   peak.max = level->max[begin];
+   for (guint64 i = begin; i < end; ++i) {
+      peak.min = std::min(peak.min, level->min[i]);
+      peak.max = std::max(peak.max, level->max[i]);
+      sum_squares += static_cast<double>(level->rms[i]) * level->rms[i];
    }
+   peak.rms = static_cast<float>(sqrt(sum_squares / static_cast<double>(end - begin)));
+   return peak;
+}
 
-   if (!std::getline(file, line)) {
-      file.close();
-      return false;
+void Waveform::build_peak_levels() {
+   for (unsigned int ch = 0; ch < 3; ++ch) {
+      std::vector<PeakLevel>& levels = m_peak_levels[ch];
+      levels.clear();
+
+      if (ch >= m_n_channels)
+         continue;
+
+      const std::vector<double>& samples = m_channels[ch];
+      const guint64 n_samples = samples.size();
+
+      // first level, from the raw samples
+      if (n_samples <= 1)
+         continue;
+
+      {
+         PeakLevel level;
+         level.factor = PEAK_LEVEL_FACTOR;
+
+         guint64 size = (n_samples + level.factor - 1) / level.factor;
+         level.min.resize(size);
+         level.max.resize(size);
+         level.rms.resize(size);
+
+         for (guint64 i = 0; i < size; ++i) {
+            guint64 begin = i * level.factor;
+            guint64 end = std::min(begin + level.factor, n_samples);
+
+            double min = samples[begin], max = samples[begin], sum_squares = 0;
+            for (guint64 j = begin; j < end; ++j) {
+               min = std::min(min, samples[j]);
+               max = std::max(max, samples[j]);
+               sum_squares += samples[j] * samples[j];
+            }
+            level.min[i] = static_cast<float>(min);
+            level.max[i] = static_cast<float>(max);
+            level.rms[i] = static_cast<float>(sqrt(sum_squares / static_cast<double>(end - begin)));
+         }
+         levels.push_back(std::move(level));
+      }
+
+      // next levels, each one from the previous
+      while (levels.back().max.size() > 1) {
+         const PeakLevel& prev = levels.back();
+         const guint64 prev_size = prev.max.size();
+
+         PeakLevel level;
+         level.factor = prev.factor * PEAK_LEVEL_FACTOR;
+
+         guint64 size = (prev_size + PEAK_LEVEL_FACTOR - 1) / PEAK_LEVEL_FACTOR;
+         level.min.resize(size);
+         level.max.resize(size);
+         level.rms.resize(size);
+
+         for (guint64 i = 0; i < size; ++i) {
+            guint64 begin = i * PEAK_LEVEL_FACTOR;
+            guint64 end = std::min(begin + PEAK_LEVEL_FACTOR, prev_size);
+
+            float min = prev.min[begin], max = prev.max[begin];
+            double sum_squares = 0, count = 0;
+            for (guint64 j = begin; j < end; ++j) {
+               min = std::min(min, prev.min[j]);
+               max = std::max(max, prev.max[j]);
+               // the last block of a level can be shorter than the others
+               double weight = static_cast<double>(std::min(prev.factor, n_samples - j * prev.factor));
+               sum_squares += static_cast<double>(prev.rms[j]) * prev.rms[j] * weight;
+               count += weight;
+            }
+            level.min[i] = min;
+            level.max[i] = max;
+            level.rms[i] = static_cast<float>(sqrt(sum_squares / count));
+         }
+         levels.push_back(std::move(level));
+      }
+   }
+}
+
+// Cursor over the contents of a waveform file.
+// All the reads are bounds checked, they return false past the end.
+class WaveformFileCursor {
+  public:
+   WaveformFileCursor(const gchar* data, gsize size) : m_data(data), m_size(size), m_pos(0) {
+   }
+
+   bool read(void* dest, gsize n) {
+      if (n > m_size - m_pos)
+         return false;
+      memcpy(dest, m_data + m_pos, n);
+      m_pos += n;
+      return true;
+   }
+
+   // Return a pointer on the next n bytes and skip them.
+   const guint8* take(gsize n) {
+      if (n > m_size - m_pos)
+         return nullptr;
+      const guint8* p = reinterpret_cast<const guint8*>(m_data + m_pos);
+      m_pos += n;
+      return p;
    }
 
+   bool read_line(std::string& line) {
+      const gchar* begin = m_data + m_pos;
+      const gchar* end = static_cast<const gchar*>(memchr(begin, '\n', m_size - m_pos));
+      if (end == nullptr)
+         return false;
+      line.assign(begin, end);
+      m_pos += (end - begin) + 1;
+      return true;
+   }
+
+   // Little endian integer of n bytes
+   bool read_le(guint64& value, gsize n) {
+      const guint8* p = take(n);
+      if (p == nullptr)
+         return false;
+      value = 0;
+      for (gsize i = 0; i < n; ++i) value |= static_cast<guint64>(p[i]) << (8 * i);
+      return true;
+   }
+
+   bool read_float(float& value) {
+      guint64 bits = 0;
+      if (!read_le(bits, 4))
+         return false;
+      guint32 bits32 = static_cast<guint32>(bits);
+      memcpy(&value, &bits32, sizeof(value));
+      return true;
+   }
+
+  protected:
+   const gchar* m_data;
+   gsize m_size;
+   gsize m_pos;
+};
+
+// Append a little endian integer of n bytes
+static void put_le(std::string& data, guint64 value, gsize n) {
+   for (gsize i = 0; i < n; ++i) data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+static void put_float(std::string& data, float value) {
+   guint32 bits = 0;
+   memcpy(&bits, &value, sizeof(bits));
+   put_le(data, bits, 4);
+}
+
+// Quantise the value in the range [lo, hi] on QUANTISED_BITS (nearest).
+static guint32 quantise(double value, float lo, float hi) {
+   const double steps = static_cast<double>((1u << QUANTISED_BITS) - 1);
+   double q = (hi > lo) ? (value - lo) / (hi - lo) * steps : 0;
+   q = floor(q + 0.5);
+   return static_cast<guint32>(CLAMP(q, 0, steps));
+}
+
+static float dequantise(guint32 value, float lo, float hi) {
+   const double steps = static_cast<double>((1u << QUANTISED_BITS) - 1);
+   return static_cast<float>(lo + (hi - lo) * (value / steps));
+}
+
+// Append the values quantised in the range [lo, hi].
+template <class T>
+static void put_quantised(std::string& data, const std::vector<T>& values, float lo, float hi) {
+   for (T value : values) put_le(data, quantise(value, lo, hi), QUANTISED_BITS / 8);
+}
+
+// Read 'size' quantised values in 'values'.
+template <class T>
+static bool read_quantised(WaveformFileCursor& cursor, std::vector<T>& values, guint64 size, float lo, float hi) {
+   const gsize bytes = static_cast<gsize>(QUANTISED_BITS / 8);
+   if (size > G_MAXSIZE / bytes)
+      return false;
+   const guint8* p = cursor.take(static_cast<gsize>(size) * bytes);
+   if (p == nullptr)
+      return false;
+
+   values.resize(size);
+   for (guint64 i = 0; i < size; ++i) values[i] = dequantise(p[2 * i] | (p[2 * i + 1] << 8), lo, hi);
+   return true;
+}
+
+Glib::ustring Waveform::get_media_hash() {
+   return m_media_hash;
+}
+
+// The version 1 and 2 are a text header followed by the native values
+// (guint channels, gint64 duration and for each channel the size_type and doubles).
+bool Waveform::open_v2(WaveformFileCursor& cursor, int version) {
+   std::string line;
+   if (!cursor.read_line(line))
+      return false;
+
    m_video_uri = line;
 
-   file.read((char*)&m_n_channels, sizeof(m_n_channels));
-   file.read((char*)&m_duration, sizeof(m_duration));
+   if (!cursor.read(&m_n_channels, sizeof(m_n_channels)) || !cursor.read(&m_duration, sizeof(m_duration)))
+      return false;
+
+   if (m_n_channels > 3)
+      return false;
 
    if (version == 1) {
       m_duration = m_duration / 1000000;  // GST_MSECOND=1000000;
@@ -117,22 +343,142 @@ bool Waveform::open(const Glib::ustring& file_uri) {
    for (unsigned int n = 0; n < m_n_channels; ++n) {
       std::vector<double>::size_type size = 0;
 
-      file.read((char*)&size, sizeof(size));
+      if (!cursor.read(&size, sizeof(size)) || size > G_MAXSIZE / sizeof(double))
+         return false;
 
       m_channels[n].resize(size);
 
-      for (unsigned int i = 0; i < size; ++i) {
-         file.read((char*)&m_channels[n][i], sizeof(double));
+      if (!cursor.read(m_channels[n].data(), size * sizeof(double)))
+         return false;
+   }
+
+   build_peak_levels();
+   return true;
+}
+
+// The version 3 is fixed width and little endian:
+//
+// "waveform v3\n"
+// guint32 number of channels
+// gint64  duration (msecs)
+// char    media hash [64], hexadecimal SHA-256 (see utility::compute_media_hash)
+// guint32 size of the video uri followed by the uri
+// For each channel:
+//   float   lo, hi the range of the samples and of the min and max of the pyramid
+//   guint64 number of samples followed by the samples
+//   float   the maximum of the RMS values of the pyramid (the range is [0, max])
+//   guint32 number of levels of the pyramid
+//   For each level:
+//     guint64 size followed by the min, the max and the RMS values
+// The samples and the values of the pyramid are quantised on 16 bits.
+//
+// The pyramid is loaded as it is, the levels must be the ones of
+// build_peak_levels (factor and size), the file is invalid otherwise.
+bool Waveform::open_v3(WaveformFileCursor& cursor) {
+   guint64 n_channels = 0, duration = 0, uri_size = 0;
+
+   if (!cursor.read_le(n_channels, 4) || n_channels > 3)
+      return false;
+   if (!cursor.read_le(duration, 8))
+      return false;
+
+   const guint8* hash = cursor.take(MEDIA_HASH_SIZE);
+   if (hash == nullptr)
+      return false;
+
+   if (!cursor.read_le(uri_size, 4))
+      return false;
+   const guint8* uri = cursor.take(static_cast<gsize>(uri_size));
+   if (uri == nullptr)
+      return false;
+
+   m_n_channels = static_cast<guint>(n_channels);
+   m_duration = static_cast<gint64>(duration);
+   m_media_hash = std::string(reinterpret_cast<const char*>(hash), strnlen(reinterpret_cast<const char*>(hash), MEDIA_HASH_SIZE));
+   m_video_uri = std::string(reinterpret_cast<const char*>(uri), static_cast<gsize>(uri_size));
+
+   for (unsigned int n = 0; n < m_n_channels; ++n) {
+      float lo = 0, hi = 0, rms_hi = 0;
+      guint64 n_samples = 0, n_levels = 0;
+
+      if (!cursor.read_float(lo) || !cursor.read_float(hi))
+         return false;
+
+      if (!cursor.read_le(n_samples, 8))
+         return false;
+      if (!read_quantised(cursor, m_channels[n], n_samples, lo, hi))
+         return false;
+
+      if (!cursor.read_float(rms_hi))
+         return false;
+      if (!cursor.read_le(n_levels, 4) || n_levels > 64)
+         return false;
+
+      std::vector<PeakLevel>& levels = m_peak_levels[n];
+      levels.resize(n_levels);
+
+      guint64 factor = 1, prev_size = n_samples;
+      for (PeakLevel& level : levels) {
+         guint64 size = 0;
+         if (prev_size <= 1 || !cursor.read_le(size, 8) || size != (prev_size + PEAK_LEVEL_FACTOR - 1) / PEAK_LEVEL_FACTOR)
+            return false;
+
+         factor *= PEAK_LEVEL_FACTOR;
+         level.factor = factor;
+         if (!read_quantised(cursor, level.min, size, lo, hi) || !read_quantised(cursor, level.max, size, lo, hi) ||
+             !read_quantised(cursor, level.rms, size, 0, rms_hi))
+            return false;
+         prev_size = size;
       }
+      // the coarsest level is a single block
+      if (prev_size > 1)
+         return false;
    }
+   return true;
+}
 
-   file.close();
+bool Waveform::open(const Glib::ustring& file_uri) {
+   Glib::ustring filename = Glib::filename_from_uri(file_uri);
+
+   // The file is mapped and decoded in bulk, there is no per-sample I/O.
+   GMappedFile* mapped = g_mapped_file_new(filename.c_str(), FALSE, NULL);
+   if (mapped == NULL)
+      return false;
+
+   WaveformFileCursor cursor(g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped));
+
+   bool valid = false;
+
+   std::string line;
+   if (cursor.read_line(line)) {
+      if (line == "waveform") {
+         valid = open_v2(cursor, 1);
+      } else if (line == "waveform v2") {
+         valid = open_v2(cursor, 2);
+      } else if (line == "waveform v3") {
+         valid = open_v3(cursor);
+      }
+   }
+
+   g_mapped_file_unref(mapped);
+
+   if (!valid) {
+      for (unsigned int n = 0; n < 3; ++n) {
+         m_channels[n].clear();
+         m_peak_levels[n].clear();
+      }
+      m_n_channels = 0;
+      return false;
+   }
 
    m_waveform_uri = file_uri;
 
    return true;
 }
 
+// Always save in the version 3 (see open_v3).
+// The pyramid is saved with the samples, nothing is computed when the
+// file is opened.
 bool Waveform::save(const Glib::ustring& file_uri) {
    Glib::ustring filename = Glib::filename_from_uri(file_uri);
 
@@ -141,25 +487,63 @@ bool Waveform::save(const Glib::ustring& file_uri) {
    if (!file)
       return false;
 
-   file << "waveform v2" << std::endl;
+   // The whole file is built in memory and written at once
+   std::string data = "waveform v3\n";
 
-   file << m_video_uri << std::endl;
+   put_le(data, m_n_channels, 4);
+   put_le(data, static_cast<guint64>(m_duration), 8);
 
-   file.write((const char*)&m_n_channels, sizeof(m_n_channels));
-   file.write((const char*)&m_duration, sizeof(m_duration));
+   std::string hash = m_media_hash.raw().substr(0, MEDIA_HASH_SIZE);
+   hash.resize(MEDIA_HASH_SIZE, '\0');
+   data += hash;
+
+   put_le(data, m_video_uri.bytes(), 4);
+   data += m_video_uri.raw();
 
    for (unsigned int n = 0; n < m_n_channels; ++n) {
-      std::vector<double>::size_type size = m_channels[n].size();
+      const std::vector<double>& samples = m_channels[n];
 
-      file.write((const char*)&size, sizeof(size));
+      float lo = 0, hi = 0;
+      if (!samples.empty()) {
+         auto range = std::minmax_element(samples.begin(), samples.end());
+         lo = static_cast<float>(*range.first);
+         hi = static_cast<float>(*range.second);
+      }
 
-      for (unsigned int i = 0; i < size; ++i) {
-         file.write((const char*)&m_channels[n][i], sizeof(double));
+      const std::vector<PeakLevel>& levels = m_peak_levels[n];
+
+      float rms_hi = 0;
+      for (const auto& level : levels) {
+         if (!level.rms.empty())
+            rms_hi = std::max(rms_hi, *std::max_element(level.rms.begin(), level.rms.end()));
+      }
+
+      // 2 bytes by sample, and the levels add 3 values by block (a third
+      // of the samples in all)
+      data.reserve(data.size() + samples.size() * 4 + levels.size() * 8 + 64);
+
+      put_float(data, lo);
+      put_float(data, hi);
+
+      put_le(data, samples.size(), 8);
+      put_quantised(data, samples, lo, hi);
+
+      put_float(data, rms_hi);
+      put_le(data, levels.size(), 4);
+      for (const auto& level : levels) {
+         put_le(data, level.max.size(), 8);
+         put_quantised(data, level.min, lo, hi);
+         put_quantised(data, level.max, lo, hi);
+         put_quantised(data, level.rms, 0, rms_hi);
       }
    }
 
+   file.write(data.data(), static_cast<std::streamsize>(data.size()));
    file.close();
 
+   if (!file)
+      return false;
+
    m_waveform_uri = file_uri;
 
    return true;
@@ -24,6 +24,8 @@
 
 #include <vector>
 
+class WaveformFileCursor;
+
 class Waveform {
   public:
    Waveform();
@@ -42,6 +44,22 @@ class Waveform {
 
    unsigned int get_n_channels();
 
+   // Summary of a range of samples.
+   struct Peak {
+      float min{0};
+      float max{0};
+      float rms{0};
+   };
+
+   // Return the min, max and RMS of the samples [first, last) of the channel.
+   // The values are read from the coarsest level of the pyramid which still
+   // fits in the range, so the cost doesn't depend on the length of the range.
+   Peak get_peak(unsigned int channel, guint64 first, guint64 last);
+
+   // Build the min/max/RMS pyramid of each channel from m_channels.
+   // Must be called each time the samples are changed.
+   void build_peak_levels();
+
    bool open(const Glib::ustring& uri);
 
    bool save(const Glib::ustring& uri);
@@ -51,6 +69,9 @@ class Waveform {
 
    Glib::ustring get_uri();
 
+   // Fingerprint of the source media, empty if unknown.
+   Glib::ustring get_media_hash();
+
    void reference() const;
    void unreference() const;
 
@@ -58,10 +79,27 @@ class Waveform {
 
    Glib::ustring m_waveform_uri;
    Glib::ustring m_video_uri;
+   Glib::ustring m_media_hash;
    guint m_n_channels{0};
    std::vector<double> m_channels[3];
    gint64 m_duration{0};
 
+   // One level of the pyramid, each value summarises 'factor' samples.
+   struct PeakLevel {
+      guint64 factor{1};
+      std::vector<float> min;
+      std::vector<float> max;
+      std::vector<float> rms;
+   };
+
+   // Levels of each channel, from the finest to the coarsest.
+   // The raw samples (m_channels) are the implicit level of factor 1.
+   std::vector<PeakLevel> m_peak_levels[3];
+
   protected:
+   bool open_v2(WaveformFileCursor& cursor, int version);
+
+   bool open_v3(WaveformFileCursor& cursor);
+
    mutable int ref_count_{0};
 };
@@ -0,0 +1,270 @@
+// subtitleeditor -- a tool to create or edit subtitle
+//
+// https://subtitleeditor.github.io/subtitleeditor/
+// https://github.com/subtitleeditor/subtitleeditor/
+//
+// Copyright @ 2005-2018, kitone
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+// Measure the time to draw a frame of the waveform renderers (cairo and gl)
+// at several zoom levels, the view scrolls like during the playback.
+// It isn't built by default: make -C src waveform-benchmark
+//
+// Usage: waveform-benchmark [frames by zoom level]
+//
+// The gl renderer runs without a GPU with Mesa llvmpipe:
+// LIBGL_ALWAYS_SOFTWARE=1 xvfb-run src/waveform-benchmark
+
+#include <gtkmm.h>
+
+#ifdef ENABLE_GL
+#include <epoxy/gl.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "document.h"
+#include "subtitleeditorwindow.h"
+#include "utility.h"
+#include "waveform.h"
+#include "waveformrenderer.h"
+
+WaveformRenderer* create_waveform_renderer_cairo();
+
+#ifdef ENABLE_GL
+WaveformRenderer* create_waveform_renderer_gl(const Glib::RefPtr<Gdk::Window>& window);
+#endif  // ENABLE_GL
+
+// The renderers ask the player to the window, there is no player here.
+class BenchmarkWindow : public Gtk::Window, public SubtitleEditorWindow {
+  public:
+   Glib::RefPtr<Gtk::UIManager> get_ui_manager() {
+      return Glib::RefPtr<Gtk::UIManager>();
+   }
+
+   Document* get_current_document() {
+      return NULL;
+   }
+
+   DocumentList get_documents() {
+      return DocumentList();
+   }
+
+   Player* get_player() {
+      return NULL;
+   }
+
+   WaveformManager* get_waveform_manager() {
+      return NULL;
+   }
+
+   Gtk::Statusbar* get_statusbar() {
+      return NULL;
+   }
+};
+
+// A waveform of two hours, 10 values by second like the generator.
+static Glib::RefPtr<Waveform> create_waveform() {
+   Glib::RefPtr<Waveform> wf(new Waveform);
+   wf->m_n_channels = 2;
+   wf->m_duration = 2 * 60 * 60 * 1000;
+
+   const guint64 size = wf->m_duration / 100;
+   for (guint c = 0; c < wf->m_n_channels; ++c) {
+      wf->m_channels[c].resize(size);
+      for (guint64 i = 0; i < size; ++i) wf->m_channels[c][i] = std::fabs(sin(i * 0.05 + c) * sin(i * 0.0007)) * g_random_double_range(0.5, 1);
+   }
+   wf->build_peak_levels();
+   return wf;
+}
+
+// A subtitle of 2 seconds every 3 seconds.
+static void create_subtitles(Document& doc, long duration) {
+   Subtitles subtitles = doc.subtitles();
+   for (long time = 0; time + 3000 <= duration; time += 3000) {
+      Subtitle sub = subtitles.append();
+      sub.set_start_and_end(SubtitleTime(time), SubtitleTime(time + 2000));
+      sub.set_text(build_message("Subtitle at %ld", time / 1000));
+   }
+}
+
+class Benchmark {
+  public:
+   Benchmark(BenchmarkWindow& window, Document& doc, const Glib::RefPtr<Waveform>& wf, int frames)
+       : m_window(window), m_document(doc), m_waveform(wf), m_frames(frames) {
+   }
+
+   // Draw 'frames' frames at each zoom level and print the times.
+   void run(const Glib::ustring& name, WaveformRenderer* renderer, bool gl) {
+      m_renderer = renderer;
+      m_gl = gl;
+
+      renderer->signal_document().connect(sigc::mem_fun(*this, &Benchmark::get_document));
+      renderer->signal_zoom().connect(sigc::mem_fun(*this, &Benchmark::get_zoom));
+      renderer->signal_scale().connect(sigc::mem_fun(*this, &Benchmark::get_scale));
+      renderer->signal_scrolling().connect(sigc::mem_fun(*this, &Benchmark::get_scrolling));
+      renderer->player_time.connect(sigc::mem_fun(*this, &Benchmark::get_player_time));
+
+      Gtk::Widget* widget = renderer->widget();
+      widget->signal_draw().connect(sigc::mem_fun(*this, &Benchmark::on_draw_begin), false);
+      widget->signal_draw().connect(sigc::mem_fun(*this, &Benchmark::on_draw_end), true);
+
+      m_window.add(*widget);
+      widget->show();
+      renderer->set_waveform(m_waveform);
+
+      const int zooms[] = {1, 10, 100, 1000};
+      for (int zoom : zooms) {
+         m_zoom = zoom;
+         m_scrolling = 0;
+         m_times.clear();
+
+         // the first frame builds the caches of the zoom, it isn't counted
+         draw_frame(true);
+         m_times.clear();
+
+         const int width = widget->get_width();
+         const int length = width * zoom;
+         for (int i = 0; i < m_frames; ++i) {
+            // scroll a tenth of the view, like the playback
+            m_scrolling = std::min(m_scrolling + width / 10, std::max(length - width, 0));
+            draw_frame(false);
+         }
+         print(name, zoom);
+      }
+
+      m_window.remove();
+   }
+
+  protected:
+   Document* get_document() {
+      return &m_document;
+   }
+
+   int get_zoom() {
+      return m_zoom;
+   }
+
+   float get_scale() {
+      return 1.0f;
+   }
+
+   int get_scrolling() {
+      return m_scrolling;
+   }
+
+   long get_player_time() {
+      return m_renderer->get_time_by_pos(m_scrolling);
+   }
+
+   // Redraw and wait the end of the draw.
+   void draw_frame(bool force) {
+      m_drawn = false;
+      if (force)
+         m_renderer->force_redraw_all();
+      else
+         m_renderer->redraw_all();
+
+      while (!m_drawn) Gtk::Main::iteration();
+   }
+
+   bool on_draw_begin(const Cairo::RefPtr<Cairo::Context>&) {
+      m_timer.start();
+      return false;
+   }
+
+   // The gl commands are finished, the time of the gpu is counted too.
+   bool on_draw_end(const Cairo::RefPtr<Cairo::Context>&) {
+#ifdef ENABLE_GL
+      if (m_gl) {
+         static_cast<Gtk::GLArea*>(m_renderer->widget())->make_current();
+         glFinish();
+      }
+#endif  // ENABLE_GL
+      m_times.push_back(m_timer.elapsed() * 1000);
+      m_drawn = true;
+      return false;
+   }
+
+   void print(const Glib::ustring& name, int zoom) {
+      if (m_times.empty())
+         return;
+
+      std::vector<double> times = m_times;
+      std::sort(times.begin(), times.end());
+
+      double sum = 0;
+      for (double time : times) sum += time;
+
+      printf("%-8s %6d %8zu %10.3f %10.3f %10.3f\n",
+             name.c_str(),
+             zoom,
+             times.size(),
+             sum / times.size(),
+             times[times.size() / 2],
+             times.back());
+   }
+
+  protected:
+   BenchmarkWindow& m_window;
+   Document& m_document;
+   Glib::RefPtr<Waveform> m_waveform;
+   int m_frames;
+
+   WaveformRenderer* m_renderer{nullptr};
+   bool m_gl{false};
+   int m_zoom{1};
+   int m_scrolling{0};
+
+   Glib::Timer m_timer;
+   std::vector<double> m_times;
+   bool m_drawn{false};
+};
+
+int main(int argc, char* argv[]) {
+   Gtk::Main kit(argc, argv);
+
+   int frames = (argc > 1) ? std::max(atoi(argv[1]), 1) : 100;
+
+   BenchmarkWindow window;
+   window.set_default_size(1200, 200);
+   window.show();
+
+   Glib::RefPtr<Waveform> wf = create_waveform();
+
+   Document doc(false);
+   create_subtitles(doc, wf->get_duration());
+
+   Benchmark benchmark(window, doc, wf, frames);
+
+   printf("%-8s %6s %8s %10s %10s %10s\n", "renderer", "zoom", "frames", "mean (ms)", "median", "max");
+
+   benchmark.run("cairo", create_waveform_renderer_cairo(), false);
+
+#ifdef ENABLE_GL
+   WaveformRenderer* renderer = create_waveform_renderer_gl(window.get_window());
+   if (renderer)
+      benchmark.run("gl", renderer, true);
+   else
+      std::cerr << "The gl renderer is not available" << std::endl;
+#endif  // ENABLE_GL
+
+   return EXIT_SUCCESS;
+}
@@ -32,7 +32,7 @@
 WaveformRenderer* create_waveform_renderer_cairo();
 
 #ifdef ENABLE_GL
-WaveformRenderer* create_waveform_renderer_gl();
+WaveformRenderer* create_waveform_renderer_gl(const Glib::RefPtr<Gdk::Window>& window);
 #endif  // ENABLE_GL
 
 WaveformEditor::WaveformEditor(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>& builder)
@@ -116,8 +116,13 @@ void WaveformEditor::on_create_renderer() {
    Glib::ustring renderer_name = cfg::get_string("waveform", "renderer");
 
 #ifdef ENABLE_GL
+   WaveformRenderer* renderer = NULL;
    if (renderer_name == "gl") {
-      init_renderer(create_waveform_renderer_gl());
+      // fall back to cairo if the window system doesn't support OpenGL
+      renderer = create_waveform_renderer_gl(get_window());
+   }
+   if (renderer) {
+      init_renderer(renderer);
    } else if (renderer_name == "cairo") {
       init_renderer(create_waveform_renderer_cairo());
    } else {  // cairo by default
@@ -152,12 +157,15 @@ void WaveformEditor::init_document(Document* doc) {
       CONNECT("document-changed", on_document_changed);
       CONNECT("subtitle-selection-changed", on_subtitle_selection_changed);
       CONNECT("subtitle-time-changed", on_subtitle_time_changed);
+      CONNECT("subtitle-errors-changed", on_subtitle_errors_changed);
 
 #undef CONNECT
 
       init_scrollbar();
    }
 
+   if (has_renderer())
+      renderer()->subtitles_changed();
    redraw_renderer();
 }
 
@@ -401,6 +409,8 @@ bool WaveformEditor::open_waveform(const Glib::ustring& uri) {
    }
 
    Glib::RefPtr<Waveform> wf = Waveform::create_from_file(uri);
+   if (wf && !utility::media_hash_matches(wf->get_media_hash(), wf->get_video_uri()))
+      std::cerr << "The waveform '" << uri << "' has been generated from another version of the video" << std::endl;
 
    set_waveform(wf);
 
@@ -490,6 +500,7 @@ void WaveformEditor::on_document_changed() {
    if ((has_renderer() && has_waveform()) == false)
       return;
 
+   renderer()->subtitles_changed();
    redraw_renderer();
 }
 
@@ -506,6 +517,7 @@ void WaveformEditor::on_subtitle_selection_changed() {
    if (m_cfg_scrolling_with_selection && player_playing == false)
       center_with_selected_subtitle();
 
+   renderer()->selection_changed();
    redraw_renderer();
 }
 
@@ -515,6 +527,17 @@ void WaveformEditor::on_subtitle_time_changed() {
    if ((has_renderer() && has_waveform()) == false)
       return;
 
+   renderer()->subtitles_changed();
+   redraw_renderer();
+}
+
+// This callback is connected at the current document.
+// The errors of the subtitles have been updated, they are drawn with another color.
+void WaveformEditor::on_subtitle_errors_changed() {
+   if ((has_renderer() && has_waveform()) == false)
+      return;
+
+   renderer()->subtitles_changed();
    redraw_renderer();
 }
 
@@ -579,7 +602,8 @@ std::pair<long, long> WaveformEditor::select_with_player() {
    if (player() && has_document() && m_cfg_select_with_player) {
       Subtitles subs = document()->subtitles();
       long playerpos = player()->get_position();
-      for (Subtitle cursub = subs.get_first(); cursub; cursub = subs.get_next(cursub)) {
+      // only the subtitles around the player position, from the time index
+      for (Subtitle cursub : subs.find(SubtitleTime(playerpos), SubtitleTime(playerpos))) {
          if ((cursub.get_start().totalmsecs <= playerpos) && (cursub.get_end().totalmsecs > playerpos)) {
             document()->subtitles().select(cursub);
             document()->emit_signal("subtitle-selection-changed");
@@ -663,6 +687,7 @@ bool WaveformEditor::on_button_press_event_renderer(GdkEventButton* ev) {
       if (sub)
          document()->subtitles().select(sub);
 
+      renderer()->selection_changed();
       redraw_renderer();
       return true;
    }
@@ -186,6 +186,10 @@ class WaveformEditor : public WaveformManager, public Gtk::Box {
    // The time of subtitle has changed, it's need to redraw the view.
    void on_subtitle_time_changed();
 
+   // This callback is connected at the current document.
+   // The errors of the subtitles have been updated, they are drawn with another color.
+   void on_subtitle_errors_changed();
+
    // This callback is connected at the player.
    // The keyframes has changed, it's need to redraw the view.
    void on_player_message(Player::Message msg);
@@ -50,6 +50,7 @@ void WaveformRenderer::init_default_config() {
    SET_COLOR(m_color_subtitle_selected, 0.9f, 0.5f, 0.3f, 0.6f);
    SET_COLOR(m_color_subtitle_invalid, 1.0f, 1.0f, 0.0f,
              0.8f);  // invalid time start > end
+   SET_COLOR(m_color_subtitle_error, 0.9f, 0.2f, 0.2f, 0.6f);
    SET_COLOR(m_color_text, 1.0f, 1.0f, 1.0f, 1.0f);
    SET_COLOR(m_color_keyframe, 0.3f, 0.6f, 1.0f, 1.0f);
 
@@ -76,6 +77,7 @@ void WaveformRenderer::init_default_config() {
    check_color("color-subtitle", m_color_subtitle);
    check_color("color-subtitle-selected", m_color_subtitle_selected);
    check_color("color-subtitle-invalid", m_color_subtitle_invalid);
+   check_color("color-subtitle-error", m_color_subtitle_error);
    check_color("color-text", m_color_text);
    check_color("color-player-position", m_color_player_position);
    check_color("color-keyframe", m_color_keyframe);
@@ -95,6 +97,7 @@ void WaveformRenderer::load_config() {
    get_color("color-subtitle", m_color_subtitle);
    get_color("color-subtitle-selected", m_color_subtitle_selected);
    get_color("color-subtitle-invalid", m_color_subtitle_invalid);
+   get_color("color-subtitle-error", m_color_subtitle_error);
    get_color("color-text", m_color_text);
    get_color("color-player-position", m_color_player_position);
    get_color("color-keyframe", m_color_keyframe);
@@ -116,6 +119,12 @@ void WaveformRenderer::waveform_changed() {
 void WaveformRenderer::keyframes_changed() {
 }
 
+void WaveformRenderer::subtitles_changed() {
+}
+
+void WaveformRenderer::selection_changed() {
+}
+
 void WaveformRenderer::redraw_all() {
 }
 
@@ -194,6 +203,8 @@ void WaveformRenderer::on_config_waveform_renderer_changed(const Glib::ustring&
       string_to_rgba(value, m_color_subtitle_selected);
    } else if ("color-subtitle-invalid" == key) {
       string_to_rgba(value, m_color_subtitle_invalid);
+   } else if ("color-subtitle-error" == key) {
+      string_to_rgba(value, m_color_subtitle_error);
    } else if ("color-text" == key) {
       string_to_rgba(value, m_color_text);
    } else if ("color-player-position" == key) {
@@ -44,6 +44,12 @@ class WaveformRenderer {
 
    virtual void keyframes_changed();
 
+   // The times, the text or the number of subtitles are changed.
+   virtual void subtitles_changed();
+
+   // Only the selection of the subtitles is changed.
+   virtual void selection_changed();
+
    virtual void redraw_all();
 
    virtual void force_redraw_all();
@@ -94,6 +100,7 @@ class WaveformRenderer {
    float m_color_subtitle[4];
    float m_color_subtitle_selected[4];
    float m_color_subtitle_invalid[4];  // invalid time start > end
+   float m_color_subtitle_error[4];    // error found by the background checking
    float m_color_text[4];              // used for time, subtitle text ...
    float m_color_player_position[4];
    float m_color_keyframe[4];
@@ -27,6 +27,9 @@
 
 #define TRIANGLE_SIZE 10
 
+// Width of the tiles of the cached layers
+#define TILE_WIDTH 256
+
 // Cairo Waveform renderer
 class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
   public:
@@ -41,17 +44,23 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
    void set_color(const Cairo::RefPtr<Cairo::Context>& cr, float color[4]);
 
    // The waveform is changed.
-   // Need to force to redisplay the waveform (m_wf_surface)
+   // Need to force to redisplay the waveform (m_waveform_tiles)
    void waveform_changed();
 
    // The keyframe is changed.
-   // Need to redisplay the waveform.
+   // Need to redisplay the keyframes layer.
    void keyframes_changed();
 
+   // The subtitles are changed, the boxes and the text need to be redisplayed.
+   void subtitles_changed();
+
+   // Only the selection is changed, the text is still valid.
+   void selection_changed();
+
    // Call queue_draw
    void redraw_all();
 
-   // Delete the surface and redraw
+   // Delete all the layers and redraw
    void force_redraw_all();
 
    bool on_configure_event(GdkEventConfigure* ev);
@@ -72,7 +81,7 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
    // Display the time text every X seconds (msec)
    void draw_timeline_time(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area, long msec);
 
-   // Draw the waveform by the call of draw_channel.
+   // Draw the waveform in the area [x, x + width] by the call of draw_channel.
    void draw_waveform(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area);
 
    void draw_channel(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area, unsigned int channel);
@@ -84,9 +93,12 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
    // position of the end in the area : get_pos_by_time(subtitle.get_end)
    void draw_subtitle_text(const Cairo::RefPtr<Cairo::Context>& cr, const Subtitle& sub, int start, int end);
 
-   // Draw subtitles visible
+   // Draw the boxes of the subtitles in the area [x, x + width]
    void draw_subtitles(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area);
 
+   // Draw the text of the subtitles in the area [x, x + width]
+   void draw_subtitles_text(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area);
+
    // Draw the left and the right marker of the subtitle selected.
    void draw_marker(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area);
 
@@ -97,10 +109,41 @@ class WaveformRendererCairo : public Gtk::DrawingArea, public WaveformRenderer {
    // and the duration of the selected subtitle
    void display_time_info(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area);
 
+   // Draw the keyframes in the area [x, x + width]
    void draw_keyframes(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area);
 
   protected:
-   Cairo::RefPtr<Cairo::Surface> m_wf_surface;
+   // A layer is cached in tiles of TILE_WIDTH pixels, indexed by their
+   // position in the whole area (with the scrolling). Scrolling or moving
+   // the player only blits the tiles, a tile is drawn once for a zoom.
+   typedef std::map<int, Cairo::RefPtr<Cairo::Surface>> Tiles;
+
+   // Draw a layer in the area [x, x + width] of the rectangle,
+   // the context is in the coordinates of the whole area.
+   typedef void (WaveformRendererCairo::*LayerFunc)(const Cairo::RefPtr<Cairo::Context>&, const Gdk::Rectangle&);
+
+   // Paint the visible tiles of the layer, the missing ones are drawn with func.
+   void paint_layer(const Cairo::RefPtr<Cairo::Context>& cr, Tiles& tiles, LayerFunc func, const Gdk::Rectangle& area);
+
+   // Delete all the tiles
+   void clear_layers();
+
+   // Delete the tiles which depend on the zoom, the scale or the size of the area
+   // if one of them has changed since the last draw.
+   void check_layers(const Gdk::Rectangle& area);
+
+  protected:
+   Tiles m_waveform_tiles;
+   Tiles m_keyframes_tiles;
+   Tiles m_subtitles_tiles;
+   Tiles m_text_tiles;
+
+   // the state used to draw the tiles
+   int m_tiles_zoom{0};
+   float m_tiles_scale{0};
+   int m_tiles_width{0};
+   int m_tiles_height{0};
+
    Glib::RefPtr<Pango::Layout> m_layout_text;
 };
 
@@ -127,18 +170,33 @@ void WaveformRendererCairo::set_color(const Cairo::RefPtr<Cairo::Context>& cr, f
 }
 
 // The waveform is changed.
-// Need to force to redisplay the waveform (m_wf_surface)
+// Need to force to redisplay the waveform (m_waveform_tiles)
 void WaveformRendererCairo::waveform_changed() {
    se_dbg(SE_DBG_WAVEFORM);
 
-   if (m_wf_surface)
-      m_wf_surface.clear();
+   clear_layers();
    queue_draw();
 }
 
 void WaveformRendererCairo::keyframes_changed() {
    se_dbg(SE_DBG_WAVEFORM);
 
+   m_keyframes_tiles.clear();
+   queue_draw();
+}
+
+void WaveformRendererCairo::subtitles_changed() {
+   se_dbg(SE_DBG_WAVEFORM);
+
+   m_subtitles_tiles.clear();
+   m_text_tiles.clear();
+   queue_draw();
+}
+
+void WaveformRendererCairo::selection_changed() {
+   se_dbg(SE_DBG_WAVEFORM);
+
+   m_subtitles_tiles.clear();
    queue_draw();
 }
 
@@ -149,20 +207,67 @@ void WaveformRendererCairo::redraw_all() {
    queue_draw();
 }
 
-// Delete the surface and redraw
+// Delete all the layers and redraw
 void WaveformRendererCairo::force_redraw_all() {
    se_dbg(SE_DBG_WAVEFORM);
 
-   if (m_wf_surface)
-      m_wf_surface.clear();
+   clear_layers();
    queue_draw();
 }
 
+void WaveformRendererCairo::clear_layers() {
+   m_waveform_tiles.clear();
+   m_keyframes_tiles.clear();
+   m_subtitles_tiles.clear();
+   m_text_tiles.clear();
+}
+
+void WaveformRendererCairo::check_layers(const Gdk::Rectangle& area) {
+   // the positions depend on the zoom and the width
+   if (m_tiles_zoom != zoom() || m_tiles_width != area.get_width() || m_tiles_height != area.get_height()) {
+      clear_layers();
+      m_tiles_zoom = zoom();
+      m_tiles_width = area.get_width();
+      m_tiles_height = area.get_height();
+   }
+   // only the waveform depends on the scale
+   if (m_tiles_scale != scale()) {
+      m_waveform_tiles.clear();
+      m_tiles_scale = scale();
+   }
+}
+
+void WaveformRendererCairo::paint_layer(const Cairo::RefPtr<Cairo::Context>& cr, Tiles& tiles, LayerFunc func, const Gdk::Rectangle& area) {
+   int start_area = get_start_area();
+   int first = start_area / TILE_WIDTH;
+   int last = (start_area + area.get_width() - 1) / TILE_WIDTH;
+
+   // forget the tiles far from the view
+   tiles.erase(tiles.begin(), tiles.lower_bound(first - 1));
+   tiles.erase(tiles.upper_bound(last + 1), tiles.end());
+
+   for (int i = first; i <= last; ++i) {
+      int x = i * TILE_WIDTH;
+
+      Cairo::RefPtr<Cairo::Surface>& tile = tiles[i];
+      if (!tile) {
+         tile = Cairo::Surface::create(cr->get_target(), Cairo::CONTENT_COLOR_ALPHA, TILE_WIDTH, area.get_height());
+
+         Cairo::RefPtr<Cairo::Context> tile_cr = Cairo::Context::create(tile);
+         tile_cr->translate(-x, 0);
+         (this->*func)(tile_cr, Gdk::Rectangle(x, 0, TILE_WIDTH, area.get_height()));
+      }
+
+      cr->set_source(tile, x - start_area, 0);
+      cr->rectangle(x - start_area, 0, TILE_WIDTH, area.get_height());
+      cr->fill();
+   }
+}
+
 bool WaveformRendererCairo::on_configure_event(GdkEventConfigure* /*ev*/) {
    se_dbg(SE_DBG_WAVEFORM);
 
-   if (m_wf_surface)
-      m_wf_surface.clear();
+   clear_layers();
    queue_draw();
 
    // return false IMPORTANT!!!
@@ -174,18 +279,17 @@ bool WaveformRendererCairo::on_configure_event(GdkEventConfigure* /*ev*/) {
 // - waveform (draw_waveform)
 // - subtitle (draw_subtitles)
 // - time info (display_time_info)
+// The waveform, the keyframes and the subtitles come from the cached layers,
+// the marker and the player position are drawn over them.
 bool WaveformRendererCairo::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
    se_dbg(SE_DBG_WAVEFORM);
 
-   static Glib::Timer m_timer;
+   Glib::Timer timer;
 
    // check minimum size
    if (get_width() < 20 || get_height() < 10)
       return false;
 
-   if (se_dbg_check_flags(SE_DBG_WAVEFORM))
-      m_timer.start();
-
    // background
    set_color(cr, m_color_background);
    cr->rectangle(0, 0, get_width(), get_height());
@@ -194,45 +298,24 @@ bool WaveformRendererCairo::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
    if (m_waveform) {
       Gdk::Rectangle warea(0, 0, get_width(), get_height() - 30);
 
-      // check
-      {
-         static int old_start_area = get_start_area();
-         static double old_zoom = zoom();
-         static double old_scale = scale();
-
-         if (old_zoom != zoom() || old_scale != scale() || old_start_area != get_start_area()) {
-            m_wf_surface.clear();
-            old_start_area = get_start_area();
-            old_zoom = zoom();
-            old_scale = scale();
-         }
-      }
+      check_layers(warea);
 
-      if (!m_wf_surface) {
-         m_wf_surface = Cairo::Surface::create(cr->get_target(), Cairo::CONTENT_COLOR_ALPHA, get_width(), get_height());
-
-         Cairo::RefPtr<Cairo::Context> wf_cr = Cairo::Context::create(m_wf_surface);
+      cr->save();
+      cr->translate(0, 30);
 
-         draw_waveform(wf_cr, warea);
-      }
+      paint_layer(cr, m_waveform_tiles, &WaveformRendererCairo::draw_waveform, warea);
+      paint_layer(cr, m_keyframes_tiles, &WaveformRendererCairo::draw_keyframes, warea);
 
-      if (m_wf_surface) {
-         cr->save();
-         cr->translate(0, 30);
-         cr->set_source(m_wf_surface, 0, 0);
-         cr->paint();
-         cr->restore();
+      if (document()) {
+         paint_layer(cr, m_subtitles_tiles, &WaveformRendererCairo::draw_subtitles, warea);
+         if (m_display_subtitle_text)
+            paint_layer(cr, m_text_tiles, &WaveformRendererCairo::draw_subtitles_text, warea);
       }
 
-      cr->save();
-      cr->translate(-get_start_area(), 30);
-
-      draw_keyframes(cr, warea);
+      cr->translate(-get_start_area(), 0);
 
-      if (document()) {
-         draw_subtitles(cr, warea);
+      if (document())
          draw_marker(cr, warea);
-      }
 
       draw_player_position(cr, warea);
 
@@ -245,14 +328,13 @@ bool WaveformRendererCairo::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
    }  // has_waveform
 
    if (se_dbg_check_flags(SE_DBG_WAVEFORM)) {
-      double seconds = m_timer.elapsed();
+      double seconds = timer.elapsed();
 
       Glib::ustring fps = build_message("%d frames in %f seconds = %.3f FPS", 1 /*frame*/, seconds, static_cast<float>(1 /*frame*/ / seconds));
 
       set_color(cr, m_color_text);
       cr->move_to(10, get_height() - 10);
       cr->show_text(fps);
-      m_timer.reset();
    }
    return true;
 }
@@ -371,7 +453,7 @@ void WaveformRendererCairo::draw_waveform(const Cairo::RefPtr<Cairo::Context>& c
    for (unsigned int i = 0; i < n_channels; ++i) {
       cr->save();
       cr->translate(0, i * ch_height);
-      draw_channel(cr, Gdk::Rectangle(0, 0, area.get_width(), ch_height), i);
+      draw_channel(cr, Gdk::Rectangle(area.get_x(), 0, area.get_width(), ch_height), i);
       cr->restore();
    }
 }
@@ -382,10 +464,6 @@ void WaveformRendererCairo::draw_channel(const Cairo::RefPtr<Cairo::Context>& cr
    if (!m_waveform)
       return;
 
-   std::vector<double>& peaks = m_waveform->m_channels[channel];
-
-   set_color(cr, m_color_wave);
-
    int bottom = area.get_height();
 
    double scale_value = scale() * area.get_height();
@@ -394,32 +472,42 @@ void WaveformRendererCairo::draw_channel(const Cairo::RefPtr<Cairo::Context>& cr
 
    se_dbg_msg(SE_DBG_WAVEFORM, "init drawing values");
 
-   int skip = 4;
-   int z = zoom();
-
-   double begin = peaks.size() * (static_cast<double>(get_start_area()) / (width * z));
-   double move = peaks.size() * (static_cast<double>(skip) / (width * z));
-   int length = width;
-   int peaks_size = peaks.size();
-
-   double x = begin;
+   // Each pixel column is summarised by the peak pyramid of the waveform,
+   // the cost of a column is the same at every zoom level.
+   double samples_per_pixel = static_cast<double>(m_waveform->get_size()) / (width * zoom());
+   double begin = samples_per_pixel * area.get_x();
+   int x = area.get_x();
+   int length = area.get_width();
+
+   std::vector<Waveform::Peak> peaks(length);
+   for (int t = 0; t < length; ++t) {
+      guint64 first = static_cast<guint64>(begin + t * samples_per_pixel);
+      guint64 last = std::max(static_cast<guint64>(begin + (t + 1) * samples_per_pixel), first + 1);
+      peaks[t] = m_waveform->get_peak(channel, first, last);
+   }
 
-   se_dbg_msg(SE_DBG_WAVEFORM, "begin %f  move %f  length %d  peaks_size %d", begin, move, length, peaks_size);
+   se_dbg_msg(SE_DBG_WAVEFORM, "begin %f  samples per pixel %f  length %d", begin, samples_per_pixel, length);
 
    se_dbg_msg(SE_DBG_WAVEFORM, "start drawing peaks");
 
-   cr->line_to(0, bottom);
-   for (int t = 0; t < length; t += skip, x += move) {
-      int px = static_cast<int>(x);
-      if (px > peaks_size)
-         break;
-      double peakOnScreen = peaks[px] * scale_value;
-
-      peakOnScreen = CLAMP(peakOnScreen, 0, bottom);
+   // the peaks, the transients stay visible at every zoom level
+   set_color(cr, m_color_wave);
+   cr->move_to(x, bottom);
+   for (int t = 0; t < length; ++t) {
+      double peakOnScreen = CLAMP(peaks[t].max * scale_value, 0, bottom);
+      cr->line_to(x + t, bottom - peakOnScreen);
+   }
+   cr->line_to(x + length, bottom);
+   cr->fill();
 
-      cr->line_to(t, bottom - peakOnScreen);
+   // the RMS, the body of the signal
+   cr->set_source_rgba(m_color_wave_fill[0], m_color_wave_fill[1], m_color_wave_fill[2], m_color_wave_fill[3] * 0.3);
+   cr->move_to(x, bottom);
+   for (int t = 0; t < length; ++t) {
+      double rmsOnScreen = CLAMP(peaks[t].rms * scale_value, 0, bottom);
+      cr->line_to(x + t, bottom - rmsOnScreen);
    }
-   cr->line_to(length, bottom);
+   cr->line_to(x + length, bottom);
    cr->fill();
 
    se_dbg_msg(SE_DBG_WAVEFORM, "end of drawing peaks");
@@ -454,7 +542,7 @@ void WaveformRendererCairo::draw_subtitle_text(const Cairo::RefPtr<Cairo::Contex
    cr->restore();
 }
 
-// Draw subtitles visible
+// Draw the boxes of the subtitles in the area [x, x + width]
 void WaveformRendererCairo::draw_subtitles(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area) {
    se_dbg(SE_DBG_WAVEFORM);
 
@@ -463,63 +551,44 @@ void WaveformRendererCairo::draw_subtitles(const Cairo::RefPtr<Cairo::Context>&
 
    int h = area.get_height();
 
-   SubtitleTime start_clip(get_time_by_pos(get_start_area()));
-   SubtitleTime end_clip(get_time_by_pos(get_end_area()));
+   SubtitleTime start_clip(get_time_by_pos(area.get_x()));
+   SubtitleTime end_clip(get_time_by_pos(area.get_x() + area.get_width()));
 
    Subtitles subs = document()->subtitles();
    Subtitle selected = subs.get_first_selected();
-
-   if (selected) {
-      for (Subtitle sub = subs.get_first(); sub; ++sub) {
-         SubtitleTime start = sub.get_start();
-         SubtitleTime end = sub.get_end();
-
-         if (start < start_clip && end < start_clip)
-            continue;
-         if (start > end_clip && end > end_clip)
-            break;
-
-         int s = get_pos_by_time(start.totalmsecs);
-         int e = get_pos_by_time(end.totalmsecs);
-
-         if (s > e) {
-            set_color(cr, m_color_subtitle_invalid);
-         } else if (selected == sub) {
-            set_color(cr, m_color_subtitle_selected);
-         } else {
-            set_color(cr, m_color_subtitle);
-         }
-
-         cr->rectangle(s, 0, e - s, h);
-         cr->fill();
-
-         if (m_display_subtitle_text)
-            draw_subtitle_text(cr, sub, s, e);
+   const SubtitleErrors& errors = document()->get_subtitle_errors();
+
+   for (Subtitle sub : subs.find(start_clip, end_clip)) {
+      int s = get_pos_by_time(sub.get_start().totalmsecs);
+      int e = get_pos_by_time(sub.get_end().totalmsecs);
+
+      if (s > e) {
+         set_color(cr, m_color_subtitle_invalid);
+      } else if (selected && selected == sub) {
+         set_color(cr, m_color_subtitle_selected);
+      } else if (errors.get(sub.get_num() - 1) != 0) {
+         set_color(cr, m_color_subtitle_error);
+      } else {
+         set_color(cr, m_color_subtitle);
       }
-   } else {
-      for (Subtitle sub = subs.get_first(); sub; ++sub) {
-         SubtitleTime start = sub.get_start();
-         SubtitleTime end = sub.get_end();
 
-         if (start < start_clip && end < start_clip)
-            continue;
-         if (start > end_clip && end > end_clip)
-            break;
+      cr->rectangle(s, 0, e - s, h);
+      cr->fill();
+   }
+}
 
-         int s = get_pos_by_time(start.totalmsecs);
-         int e = get_pos_by_time(end.totalmsecs);
+// Draw the text of the subtitles in the area [x, x + width]
+void WaveformRendererCairo::draw_subtitles_text(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area) {
+   se_dbg(SE_DBG_WAVEFORM);
 
-         if (s > e)
-            set_color(cr, m_color_subtitle_invalid);
-         else
-            set_color(cr, m_color_subtitle);
+   if (!document())
+      return;
 
-         cr->rectangle(s, 0, e - s, h);
-         cr->fill();
+   SubtitleTime start_clip(get_time_by_pos(area.get_x()));
+   SubtitleTime end_clip(get_time_by_pos(area.get_x() + area.get_width()));
 
-         if (m_display_subtitle_text)
-            draw_subtitle_text(cr, sub, s, e);
-      }
+   for (Subtitle sub : document()->subtitles().find(start_clip, end_clip)) {
+      draw_subtitle_text(cr, sub, get_pos_by_time(sub.get_start().totalmsecs), get_pos_by_time(sub.get_end().totalmsecs));
    }
 }
 
@@ -644,13 +713,11 @@ void WaveformRendererCairo::draw_keyframes(const Cairo::RefPtr<Cairo::Context>&
 
    set_color(cr, m_color_keyframe);
 
-   long start_clip = get_time_by_pos(get_start_area());
-   long end_clip = get_time_by_pos(get_end_area());
+   // the lines on the border of the area are also drawn by the next tile
+   long start_clip = get_time_by_pos(area.get_x() - 2);
+   long end_clip = get_time_by_pos(area.get_x() + area.get_width() + 2);
 
-   for (auto it = keyframes->begin(); it != keyframes->end(); ++it) {
-      // display only if it's in the area
-      if (*it < start_clip && *it < end_clip)
-         continue;
+   for (auto it = keyframes->lower_bound(start_clip); it != keyframes->end(); ++it) {
       if (*it > end_clip)
          break;  // the next keyframes are out of the area
 
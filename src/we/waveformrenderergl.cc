@@ -20,8 +20,14 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 
-#include <GL/gl.h>
-#include <gtkglmm.h>
+#include <epoxy/gl.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
 
 #include "document.h"
 #include "keyframes.h"
@@ -30,10 +36,154 @@
 #include "utility.h"
 #include "waveformrenderer.h"
 
-#define FONT_SIZE 256
+#define TRIANGLE_SIZE 10
+
+// Height of the timeline, the waveform is drawn under it
+#define TIMELINE_HEIGHT 30
+
+// Only the core profile of OpenGL 3.3 is used (instancing with divisor),
+// it's available with the software rasterizer of Mesa (llvmpipe).
+
+// The corners of a quad, drawn as a triangle strip
+static const GLfloat quad_corners[] = {0, 0, 1, 0, 0, 1, 1, 1};
+
+// The waveform, one instance is a block of the pyramid.
+// u_channel = x of the first block, width of a block, bottom and height of the channel
+static const char* waveform_vertex_shader =
+   "#version 330 core\n"
+   "layout(location = 0) in vec2 a_corner;\n"
+   "layout(location = 1) in vec2 a_peak;\n"
+   "uniform vec2 u_viewport;\n"
+   "uniform vec4 u_channel;\n"
+   "uniform float u_scale;\n"
+   "uniform int u_component;\n"
+   "void main() {\n"
+   "   float value = u_component == 0 ? a_peak.x : a_peak.y;\n"
+   "   value = clamp(value * u_scale, 0.0, u_channel.w);\n"
+   "   vec2 p = vec2(u_channel.x + (float(gl_InstanceID) + a_corner.x) * u_channel.y, u_channel.z - a_corner.y * value);\n"
+   "   gl_Position = vec4(p.x / u_viewport.x * 2.0 - 1.0, 1.0 - p.y / u_viewport.y * 2.0, 0.0, 1.0);\n"
+   "}\n";
+
+static const char* color_fragment_shader =
+   "#version 330 core\n"
+   "uniform vec4 u_color;\n"
+   "out vec4 frag_color;\n"
+   "void main() {\n"
+   "   frag_color = u_color;\n"
+   "}\n";
+
+// The boxes, the lines and the triangles, one instance is a Primitive.
+// The rectangle is transformed by u_transform (x scale, x offset, y scale, y offset),
+// then widened to u_min_width pixels. A triangle is the quad without its last corner.
+static const char* primitive_vertex_shader =
+   "#version 330 core\n"
+   "layout(location = 0) in vec2 a_corner;\n"
+   "layout(location = 1) in vec4 a_rect;\n"
+   "layout(location = 2) in vec4 a_color;\n"
+   "layout(location = 3) in float a_triangle;\n"
+   "uniform vec2 u_viewport;\n"
+   "uniform vec4 u_transform;\n"
+   "uniform float u_min_width;\n"
+   "out vec4 v_color;\n"
+   "void main() {\n"
+   "   vec4 r = a_rect * u_transform.xzxz + u_transform.ywyw;\n"
+   "   float grow = max(u_min_width - abs(r.z - r.x), 0.0) * 0.5;\n"
+   "   r.x -= grow;\n"
+   "   r.z += grow;\n"
+   "   vec2 corner = a_corner;\n"
+   "   if (a_triangle > 0.5 && gl_VertexID == 3)\n"
+   "      corner = vec2(1.0, 0.0);\n"
+   "   vec2 p = mix(r.xy, r.zw, corner);\n"
+   "   gl_Position = vec4(p.x / u_viewport.x * 2.0 - 1.0, 1.0 - p.y / u_viewport.y * 2.0, 0.0, 1.0);\n"
+   "   v_color = a_color;\n"
+   "}\n";
+
+static const char* primitive_fragment_shader =
+   "#version 330 core\n"
+   "in vec4 v_color;\n"
+   "out vec4 frag_color;\n"
+   "void main() {\n"
+   "   frag_color = v_color;\n"
+   "}\n";
+
+// The text layer, drawn by Cairo in a texture of the size of the widget.
+// The texture is a ring on the area, u_offset is the start of the area in it.
+static const char* texture_vertex_shader =
+   "#version 330 core\n"
+   "layout(location = 0) in vec2 a_corner;\n"
+   "uniform float u_offset;\n"
+   "out vec2 v_coord;\n"
+   "void main() {\n"
+   "   v_coord = vec2(a_corner.x + u_offset, a_corner.y);\n"
+   "   gl_Position = vec4(a_corner.x * 2.0 - 1.0, 1.0 - a_corner.y * 2.0, 0.0, 1.0);\n"
+   "}\n";
+
+static const char* texture_fragment_shader =
+   "#version 330 core\n"
+   "in vec2 v_coord;\n"
+   "uniform sampler2D u_texture;\n"
+   "out vec4 frag_color;\n"
+   "void main() {\n"
+   "   frag_color = texture(u_texture, v_coord);\n"
+   "}\n";
+
+// Compile the shader, return 0 on error.
+static GLuint compile_shader(GLenum type, const char* source) {
+   GLuint shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, NULL);
+   glCompileShader(shader);
+
+   GLint status = 0;
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+   if (status == GL_FALSE) {
+      GLchar log[1024] = {0};
+      glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+      std::cerr << "Failed to compile the shader of the waveform: " << log << std::endl;
+
+      glDeleteShader(shader);
+      return 0;
+   }
+   return shader;
+}
+
+// Compile and link the program, return 0 on error.
+static GLuint create_program(const char* vertex_source, const char* fragment_source) {
+   GLuint vertex = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   GLuint fragment = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+   if (vertex == 0 || fragment == 0) {
+      glDeleteShader(vertex);
+      glDeleteShader(fragment);
+      return 0;
+   }
+
+   GLuint program = glCreateProgram();
+   glAttachShader(program, vertex);
+   glAttachShader(program, fragment);
+   glLinkProgram(program);
+
+   // the program keeps them
+   glDeleteShader(vertex);
+   glDeleteShader(fragment);
+
+   GLint status = 0;
+   glGetProgramiv(program, GL_LINK_STATUS, &status);
+   if (status == GL_FALSE) {
+      GLchar log[1024] = {0};
+      glGetProgramInfoLog(program, sizeof(log), NULL, log);
+      std::cerr << "Failed to link the program of the waveform: " << log << std::endl;
+
+      glDeleteProgram(program);
+      return 0;
+   }
+   return program;
+}
 
 // OpenGL Waveform renderer
-class WaveformRendererGL : public Gtk::GL::DrawingArea, public WaveformRenderer {
+// The peak pyramid of the waveform is uploaded once in a buffer,
+// each frame only draws instances of a quad from it. The subtitles and
+// the keyframes are also kept in buffers, in time coordinates, so they
+// are rebuilt only when they change, not when the view is scrolled or zoomed.
+class WaveformRendererGL : public Gtk::GLArea, public WaveformRenderer {
   public:
    WaveformRendererGL();
 
@@ -42,112 +192,157 @@ class WaveformRendererGL : public Gtk::GL::DrawingArea, public WaveformRenderer
    // Return the widget attached to the renderer.
    Gtk::Widget* widget();
 
-   // Create GdkGLConfig (RGB | DEPTH | DOUBLE | STENCIL)
-   Glib::RefPtr<Gdk::GL::Config> create_glconfig();
+   // The waveform is changed.
+   // Need to upload again the peak pyramid.
+   void waveform_changed();
+
+   // The keyframe is changed.
+   // Need to rebuild the keyframes buffer.
+   void keyframes_changed();
 
-   // Try to create OpenGL font (with support of display list)
-   bool create_gl_font(const Glib::ustring& font_desc);
+   // The subtitles are changed, the boxes and the text need to be rebuilt.
+   void subtitles_changed();
 
-   // Use pango to get the size of the text (pixel)
-   int get_text_width(const Glib::ustring& text);
+   // Only the selection is changed, the color of the boxes need to be rebuilt.
+   void selection_changed();
 
-   // Use the Raster Position to display text
-   void draw_text(float x, float y, const Glib::ustring& text);
+   // Call queue_render
+   void redraw_all();
 
-   // Generate font
-   void on_realize();
+   // Rebuild all the buffers and redraw
+   void force_redraw_all();
 
-   // Just redisplay with redraw_all
-   bool on_configure_event(GdkEventConfigure* ev);
+  protected:
+   // A box, a line or a triangle.
+   // The triangle has its right angle in (x0, y0).
+   struct Primitive {
+      float rect[4];  // x0, y0, x1, y1
+      float color[4];
+      float triangle;
+   };
+
+   typedef std::vector<Primitive> Primitives;
+
+   // The position of a level of the pyramid in the waveform buffer.
+   struct Level {
+      guint64 factor;
+      guint64 offset;  // in blocks
+      guint64 size;
+   };
+
+   // Create the programs and the buffers
+   void on_realize();
 
-   // Expose widget
-   // Clear buffer
-   // Draw timeline, channels and markers
-   // Swap Buffer
-   bool on_expose_event(GdkEventExpose* ev);
+   // Delete the programs and the buffers
+   void on_unrealize();
 
    // Display all scene:
-   // - timeline (draw_timeline)
    // - waveform (draw_waveform)
-   // - subtitle (draw_subtitles)
-   // - time info (display_time_info)
-   void draw(GdkEventExpose* ev);
+   // - keyframes and subtitles (draw_primitives)
+   // - marker, player position and timeline
+   // - text layer (timeline, subtitles text, time info)
+   bool on_render(const Glib::RefPtr<Gdk::GLContext>& context);
 
-   // Draw the left and the right marker of the subtitle selected.
-   void draw_marker(const Gdk::Rectangle& rect);
+   // Upload the samples and the levels of the pyramid of each channel.
+   void upload_waveform();
 
-   // Draw subtitles visible
-   void draw_subtitles(const Gdk::Rectangle& rect);
+   // Draw the visible blocks of the level matching the zoom.
+   void draw_waveform(const Gdk::Rectangle& area);
 
-   // Draw the text of the subtitles visible
-   void draw_subtitles_text(const Gdk::Rectangle& rect);
+   void draw_channel(const Gdk::Rectangle& area, unsigned int channel);
 
-   // Draw the channel in the area with the lines methods
-   void draw_channel_with_line_strip(const Gdk::Rectangle& area, int channel);
+   // Build the boxes of all the subtitles (x in msecs, y in [0:1])
+   void build_subtitles(Primitives& primitives);
 
-   // Draw the channel in the area with the quad methods
-   void draw_channel_with_quad_strip(const Gdk::Rectangle& area, int channel);
+   // Build the lines of all the keyframes (x in msecs, y in [0:1])
+   void build_keyframes(Primitives& primitives);
 
-   // Display all of timeline: Time, seconds
-   void draw_timeline(const Gdk::Rectangle& area);
+   // Build the left and the right marker of the subtitle selected (pixels).
+   void build_marker(Primitives& primitives, const Gdk::Rectangle& area);
 
-   // Display the time every X seconds ("msec") with "upper" height
-   void draw_timeline_msecs(const Gdk::Rectangle& area, long msec, int upper);
+   // Build the lines of the timeline (pixels).
+   void build_timeline(Primitives& primitives, const Gdk::Rectangle& area, long msec, int upper);
 
-   // Display the time text every X seconds (msec)
-   void draw_timeline_time(const Gdk::Rectangle& area, long msec);
+   // Upload the primitives in the buffer and draw them.
+   // transform = x scale, x offset, y scale, y offset
+   void draw_primitives(GLuint buffer, const Primitives& primitives, const float transform[4], float min_width);
 
-   // Display the time of the mouse
-   // and the duration of the selected subtitle
-   void display_time_info(const Gdk::Rectangle& area);
+   // Draw the instances of the primitives already in the buffer.
+   void draw_primitives(GLuint buffer, GLsizei count, const float transform[4], float min_width);
 
-   // Draw the keyframes position.
-   void draw_keyframes(const Gdk::Rectangle& area);
+   // Return the step of the timeline (msecs), the labels don't overlap.
+   long get_timeline_step(const Cairo::RefPtr<Cairo::Context>& cr);
 
-   // Delete the OpenGL Display List (Waveform)
-   void delete_display_lists();
+   // Draw with Cairo the timeline time, the text of the subtitles
+   // and the time info in the text layer, then upload it.
+   // When the view is only scrolled, only the part which scrolled into view is drawn.
+   void update_text_layer(const Gdk::Rectangle& area, Primitives& timeline);
 
-   // The Waveform used a display list for optimize the render.
-   // If the OpenGL display list (waveform) is not yet create:
-   // - Create the display list and draw the waveform inside.
-   // Call the display list for drawing the waveform.
-   void draw_waveform(const Gdk::Rectangle& rect);
+   // Draw and upload the pixels [from:to) of the area in the ring of the text layer.
+   void draw_text_range(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area, long step, int from, int to);
 
-   // The waveform is changed.
-   // Need to force to redisplay the waveform.
-   // Delete the display list
-   void waveform_changed();
+   void draw_timeline_time(const Cairo::RefPtr<Cairo::Context>& cr, long msec, int from, int to);
 
-   // The keyframe is changed.
-   // Need to redisplay the waveform.
-   void keyframes_changed();
+   void draw_subtitles_text(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area, int from, int to);
 
-   // Call queue_draw
-   void redraw_all();
+   // Display the time of the mouse
+   // and the duration of the selected subtitle
+   void display_time_info(const Cairo::RefPtr<Cairo::Context>& cr);
 
-   // Delete display list and redraw
-   void force_redraw_all();
+   // Add a line of 'width' pixels (or msecs) centered on x
+   static void add_line(Primitives& primitives, float x, float y0, float y1, float width, const float color[4]);
+
+   static void add_rect(Primitives& primitives, float x0, float y0, float x1, float y1, const float color[4], bool triangle = false);
 
   protected:
-   Pango::FontDescription m_fontDescription;
-   GLuint m_fontListBase;
-   int m_fontHeight;
-
-   // waveform
-   Gdk::Rectangle m_displayListRect;
-   GLuint m_displayList;
-   GLsizei m_displayListSize;
+   GLuint m_vao{0};
+   GLuint m_quad_buffer{0};
+
+   GLuint m_waveform_program{0};
+   GLuint m_primitive_program{0};
+   GLuint m_texture_program{0};
+
+   // peak pyramid, (max, rms) by block
+   GLuint m_waveform_buffer{0};
+   std::vector<Level> m_levels[3];
+   bool m_waveform_dirty{true};
+
+   GLuint m_subtitles_buffer{0};
+   GLsizei m_subtitles_count{0};
+   bool m_subtitles_dirty{true};
+
+   GLuint m_keyframes_buffer{0};
+   GLsizei m_keyframes_count{0};
+   bool m_keyframes_dirty{true};
+
+   // marker, player position and timeline, rebuilt each frame
+   GLuint m_overlay_buffer{0};
+
+   // text layer, redrawn when the view is changed.
+   // The pixel x of the area is in the column x % width of the surface and
+   // the texture, so a scroll only needs to draw the new columns.
+   Cairo::RefPtr<Cairo::ImageSurface> m_text_surface;
+   GLuint m_text_texture{0};
+   int m_text_width{0};
+   int m_text_height{0};
+   int m_text_start_area{-1};
+   int m_text_zoom{0};
+   bool m_text_dirty{true};
+   Primitives m_timeline;
+
+   Glib::RefPtr<Pango::Layout> m_layout_text;
 };
 
-// Constructor
-WaveformRendererGL::WaveformRendererGL() : WaveformRenderer(), m_fontListBase(0), m_fontHeight(0), m_displayList(0), m_displayListSize(0) {
-   Glib::RefPtr<Gdk::GL::Config> glconfig = create_glconfig();
-   if (glconfig)
-      set_gl_capability(glconfig);
+WaveformRendererGL::WaveformRendererGL() : WaveformRenderer() {
+   se_dbg(SE_DBG_WAVEFORM);
+
+   set_required_version(3, 3);
+   set_has_alpha(false);
 }
 
 WaveformRendererGL::~WaveformRendererGL() {
-   // Display lists are deleted with the opengl context
+   se_dbg(SE_DBG_WAVEFORM);
+   // Buffers are deleted with the opengl context (on_unrealize)
 }
 
 // Return the widget attached to the renderer.
@@ -155,696 +350,684 @@ Gtk::Widget* WaveformRendererGL::widget() {
    return this;
 }
 
-// Create GdkGLConfig (RGB | DEPTH | DOUBLE | STENCIL)
-Glib::RefPtr<Gdk::GL::Config> WaveformRendererGL::create_glconfig() {
-   Glib::RefPtr<Gdk::GL::Config> glconfig;
-
-   glconfig = Gdk::GL::Config::create(Gdk::GL::MODE_RGB | Gdk::GL::MODE_DEPTH | Gdk::GL::MODE_DOUBLE |
-                                      Gdk::GL::MODE_STENCIL /* | Gdk::GL::MODE_MULTISAMPLE*/);
-   if (!glconfig) {
-      std::cerr << "Gtk::GL::Config Failed To create double-buffered visual." << std::endl;
+void WaveformRendererGL::on_realize() {
+   se_dbg(SE_DBG_WAVEFORM);
 
-      glconfig = Gdk::GL::Config::create(Gdk::GL::MODE_RGB | Gdk::GL::MODE_DEPTH | Gdk::GL::MODE_STENCIL);
-      if (!glconfig) {
-         std::cerr << "Gtk::GL::Config Failed To create single-buffered visual." << std::endl;
-         std::cerr << "Used another Waveform Renderer" << std::endl;
+   Gtk::GLArea::on_realize();
 
-         return Glib::RefPtr<Gdk::GL::Config>(NULL);
-      }
+   make_current();
+   try {
+      throw_if_error();
+   } catch (const Gdk::GLError& ex) {
+      std::cerr << "Failed to create the OpenGL context of the waveform: " << ex.what() << std::endl;
+      return;
    }
 
-   return glconfig;
-}
+   m_waveform_program = create_program(waveform_vertex_shader, color_fragment_shader);
+   m_primitive_program = create_program(primitive_vertex_shader, primitive_fragment_shader);
+   m_texture_program = create_program(texture_vertex_shader, texture_fragment_shader);
 
-// Try to create OpenGL font (with display list)
-bool WaveformRendererGL::create_gl_font(const Glib::ustring& font_desc_str) {
-   if (m_fontListBase > 0) {
-      // destroy font list
-      glDeleteLists(m_fontListBase, FONT_SIZE);
-      m_fontListBase = 0;
-      m_fontHeight = 0;
-      m_fontDescription = Pango::FontDescription();
-   }
+   glGenVertexArrays(1, &m_vao);
+   glBindVertexArray(m_vao);
 
-   // OpenGL list
-   m_fontListBase = glGenLists(FONT_SIZE);
+   glGenBuffers(1, &m_quad_buffer);
+   glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+   glBufferData(GL_ARRAY_BUFFER, sizeof(quad_corners), quad_corners, GL_STATIC_DRAW);
 
-   Pango::FontDescription font_desc(font_desc_str);
+   // the corner of the quad is shared by all the programs
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
-   Glib::RefPtr<Pango::Font> font = Gdk::GL::Font::use_pango_font(font_desc, 0, FONT_SIZE, m_fontListBase);
-   if (!font) {
-      std::cerr << "*** Can't load font :" << font_desc_str << std::endl;
+   glGenBuffers(1, &m_waveform_buffer);
+   glGenBuffers(1, &m_subtitles_buffer);
+   glGenBuffers(1, &m_keyframes_buffer);
+   glGenBuffers(1, &m_overlay_buffer);
 
-      glDeleteLists(m_fontListBase, FONT_SIZE);
-      return false;
-   }
+   glGenTextures(1, &m_text_texture);
+   glBindTexture(GL_TEXTURE_2D, m_text_texture);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-   Pango::FontMetrics font_metrics = font->get_metrics();
+   // the new buffers are empty
+   m_waveform_dirty = m_subtitles_dirty = m_keyframes_dirty = m_text_dirty = true;
+   m_text_width = m_text_height = 0;
+}
 
-   m_fontHeight = font_metrics.get_ascent() + font_metrics.get_descent();
-   m_fontHeight = PANGO_PIXELS(m_fontHeight);
+void WaveformRendererGL::on_unrealize() {
+   se_dbg(SE_DBG_WAVEFORM);
+
+   make_current();
+   try {
+      throw_if_error();
+
+      GLuint buffers[] = {m_quad_buffer, m_waveform_buffer, m_subtitles_buffer, m_keyframes_buffer, m_overlay_buffer};
+      glDeleteBuffers(5, buffers);
+      glDeleteTextures(1, &m_text_texture);
+      glDeleteVertexArrays(1, &m_vao);
+      glDeleteProgram(m_waveform_program);
+      glDeleteProgram(m_primitive_program);
+      glDeleteProgram(m_texture_program);
+   } catch (const Gdk::GLError& ex) {
+      std::cerr << ex.what() << std::endl;
+   }
 
-   m_fontDescription = font_desc;
+   m_quad_buffer = m_waveform_buffer = m_subtitles_buffer = m_keyframes_buffer = m_overlay_buffer = 0;
+   m_text_texture = m_vao = 0;
+   m_text_surface.clear();
+   m_waveform_program = m_primitive_program = m_texture_program = 0;
 
-   return true;
+   Gtk::GLArea::on_unrealize();
 }
 
-// Use pango to get the size of the text (pixel)
-int WaveformRendererGL::get_text_width(const Glib::ustring& text) {
-   Glib::RefPtr<Pango::Layout> layout = create_pango_layout(text);
-   if (layout) {
-      int text_width = 0, text_height = 0;
+// Display all scene
+bool WaveformRendererGL::on_render(const Glib::RefPtr<Gdk::GLContext>& /*context*/) {
+   se_dbg(SE_DBG_WAVEFORM);
 
-      layout->set_font_description(m_fontDescription);
-      layout->get_pixel_size(text_width, text_height);
+   Glib::Timer timer;
 
-      return text_width;
-   }
-   return 0;
-}
+   glClearColor(m_color_background[0], m_color_background[1], m_color_background[2], m_color_background[3]);
+   glClear(GL_COLOR_BUFFER_BIT);
 
-// Use the Raster Position to display text
-void WaveformRendererGL::draw_text(float x, float y, const Glib::ustring& text) {
-   glRasterPos2f(x, y);
+   // check minimum size and the programs
+   if (get_width() < 20 || get_height() < 10)
+      return true;
+   if (m_waveform_program == 0 || m_primitive_program == 0 || m_texture_program == 0)
+      return true;
 
-   glListBase(m_fontListBase);
-   glCallLists(text.length(), GL_UNSIGNED_BYTE, text.c_str());
-}
+   if (!m_waveform)
+      return true;
 
-// Generate OpenGL font
-void WaveformRendererGL::on_realize() {
-   Gtk::DrawingArea::on_realize();
+   glBindVertexArray(m_vao);
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-   if (!is_gl_capable())
-      return;
+   Gdk::Rectangle warea(0, TIMELINE_HEIGHT, get_width(), get_height() - TIMELINE_HEIGHT);
 
-   Glib::RefPtr<Gdk::GL::Window> gl = get_gl_window();
+   draw_waveform(warea);
 
-   if (!gl->gl_begin(get_gl_context()))
-      return;
+   // the subtitles and the keyframes are in msecs, the y in [0:1] of the area
+   float px_by_msec = m_waveform->get_duration() > 0 ? static_cast<float>(get_width()) * zoom() / m_waveform->get_duration() : 0;
+   float scene_transform[4] = {px_by_msec, static_cast<float>(-get_start_area()), static_cast<float>(warea.get_height()),
+                               static_cast<float>(warea.get_y())};
+   float pixel_transform[4] = {1, 0, 1, 0};
 
-   if (!create_gl_font("courier bold 10")) {
-      create_gl_font(get_pango_context()->get_font_description().to_string());
+   if (m_keyframes_dirty) {
+      Primitives keyframes;
+      build_keyframes(keyframes);
+      draw_primitives(m_keyframes_buffer, keyframes, scene_transform, 2);
+      m_keyframes_count = keyframes.size();
+      m_keyframes_dirty = false;
+   } else {
+      draw_primitives(m_keyframes_buffer, m_keyframes_count, scene_transform, 2);
    }
 
-   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-   glEnable(GL_LINE_SMOOTH);
-   glEnable(GL_MULTISAMPLE);
+   if (document()) {
+      if (m_subtitles_dirty) {
+         Primitives subtitles;
+         build_subtitles(subtitles);
+         draw_primitives(m_subtitles_buffer, subtitles, scene_transform, 0);
+         m_subtitles_count = subtitles.size();
+         m_subtitles_dirty = false;
+      } else {
+         draw_primitives(m_subtitles_buffer, m_subtitles_count, scene_transform, 0);
+      }
+   }
 
-   gl->gl_end();
-}
+   // the text layer is only redrawn when the view is changed
+   if (m_text_dirty || m_display_time_info || m_text_width != get_width() || m_text_height != get_height() ||
+       m_text_start_area != get_start_area() || m_text_zoom != zoom()) {
+      update_text_layer(warea, m_timeline);
+   }
 
-// Just redisplay with redraw_all
-bool WaveformRendererGL::on_configure_event(GdkEventConfigure* ev) {
-   Gtk::DrawingArea::on_configure_event(ev);
+   Primitives overlay(m_timeline);
 
-   redraw_all();
+   if (document())
+      build_marker(overlay, warea);
 
-   // return false IMPORTANT!!!
-   return false;
-}
+   add_line(overlay, get_pos_by_time(player_time()) - get_start_area(), warea.get_y(), get_height(), 2, m_color_player_position);
 
-// Expose widget
-// Clear buffer
-// Draw timeline, channels and markers
-// Swap Buffer
-bool WaveformRendererGL::on_expose_event(GdkEventExpose* ev) {
-   static Glib::Timer m_timer;
+   draw_primitives(m_overlay_buffer, overlay, pixel_transform, 0);
 
-   // check minimum size
-   if (get_width() < 20 || get_height() < 10)
-      return false;
+   // text layer, the surface of cairo is premultiplied
+   glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+   glUseProgram(m_texture_program);
+   glActiveTexture(GL_TEXTURE0);
+   glBindTexture(GL_TEXTURE_2D, m_text_texture);
+   glUniform1i(glGetUniformLocation(m_texture_program, "u_texture"), 0);
+   glUniform1f(glGetUniformLocation(m_texture_program, "u_offset"), static_cast<float>(m_text_start_area) / m_text_width);
+   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-   if (se_dbg_check_flags(SE_DBG_WAVEFORM))
-      m_timer.start();
+   glDisable(GL_BLEND);
+   glUseProgram(0);
+   glBindVertexArray(0);
 
-   // If window system doesn't support OpenGL
-   // display in the area a message
-   if (!is_gl_capable()) {
-      Glib::ustring error_msg(
-         _("Window system doesn't support OpenGL.\n"
-           "Please try with another renderer."));
+   if (se_dbg_check_flags(SE_DBG_WAVEFORM)) {
+      glFinish();
+      double seconds = timer.elapsed();
 
-      Glib::RefPtr<Pango::Layout> layout = create_pango_layout(error_msg);
+      se_dbg_msg(SE_DBG_WAVEFORM, "%d frames in %f seconds = %.3f FPS", 1 /*frame*/, seconds, static_cast<float>(1 /*frame*/ / seconds));
+   }
+   return true;
+}
 
-      layout->set_alignment(Pango::ALIGN_CENTER);
+// Upload the samples and the levels of the pyramid of each channel.
+// A block is (max, rms), the raw samples are the level of factor 1.
+void WaveformRendererGL::upload_waveform() {
+   se_dbg(SE_DBG_WAVEFORM);
 
-      Pango::FontDescription desc = get_pango_context()->get_font_description();
-      desc.set_weight(Pango::WEIGHT_BOLD);
-      layout->set_font_description(desc);
+   std::vector<GLfloat> blocks;
 
-      // display the message at the center
-      int x, y, w, h;
-      layout->get_pixel_size(w, h);
+   for (unsigned int ch = 0; ch < 3; ++ch) m_levels[ch].clear();
 
-      x = (get_width() - w) / 2;
-      y = (get_height() - h) / 2;
+   if (m_waveform) {
+      for (unsigned int ch = 0; ch < m_waveform->get_n_channels(); ++ch) {
+         const std::vector<double>& samples = m_waveform->m_channels[ch];
 
-      get_window()->draw_layout(get_style()->get_black_gc(), x, y, layout);
+         m_levels[ch].push_back({1, blocks.size() / 2, samples.size()});
+         for (double s : samples) {
+            blocks.push_back(static_cast<GLfloat>(s));
+            blocks.push_back(static_cast<GLfloat>(fabs(s)));
+         }
 
-      return true;
+         for (const auto& level : m_waveform->m_peak_levels[ch]) {
+            m_levels[ch].push_back({level.factor, blocks.size() / 2, level.max.size()});
+            for (std::size_t i = 0; i < level.max.size(); ++i) {
+               blocks.push_back(level.max[i]);
+               blocks.push_back(level.rms[i]);
+            }
+         }
+      }
    }
 
-   Glib::RefPtr<Gdk::GL::Window> gl = get_gl_window();
+   glBindBuffer(GL_ARRAY_BUFFER, m_waveform_buffer);
+   glBufferData(GL_ARRAY_BUFFER, blocks.size() * sizeof(GLfloat), blocks.data(), GL_STATIC_DRAW);
 
-   if (!gl->gl_begin(get_gl_context()))
-      return false;
+   m_waveform_dirty = false;
+}
 
-   glClearColor(m_color_background[0], m_color_background[1], m_color_background[2], m_color_background[3]);
-   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+void WaveformRendererGL::draw_waveform(const Gdk::Rectangle& area) {
+   se_dbg(SE_DBG_WAVEFORM);
 
-   glClearStencil(0);
-   glStencilMask(1);
+   if (m_waveform_dirty)
+      upload_waveform();
 
-   // Reshape
-   int width = get_width();
-   int height = get_height();
+   unsigned int n_channels = m_waveform->get_n_channels();
+   if (n_channels == 0)
+      return;
 
-   glViewport(0, 0, width, height);
+   glUseProgram(m_waveform_program);
+   glUniform2f(glGetUniformLocation(m_waveform_program, "u_viewport"), get_width(), get_height());
 
-   glMatrixMode(GL_PROJECTION);
-   glLoadIdentity();
+   glBindBuffer(GL_ARRAY_BUFFER, m_waveform_buffer);
+   glEnableVertexAttribArray(1);
+   glVertexAttribDivisor(1, 1);
 
-   glOrtho(0, width, 0, height, -10, 10);
+   int ch_height = area.get_height() / n_channels;
 
-   glMatrixMode(GL_MODELVIEW);
-   glLoadIdentity();
+   for (unsigned int i = 0; i < n_channels; ++i) {
+      draw_channel(Gdk::Rectangle(area.get_x(), area.get_y() + i * ch_height, area.get_width(), ch_height), i);
+   }
 
-   // Display Scene
-   if (m_waveform && is_sensitive()) {
-      draw(ev);
+   glVertexAttribDivisor(1, 0);
+   glDisableVertexAttribArray(1);
+}
 
-      if (se_dbg_check_flags(SE_DBG_WAVEFORM)) {
-         double seconds = m_timer.elapsed();
-         m_timer.reset();
+void WaveformRendererGL::draw_channel(const Gdk::Rectangle& area, unsigned int channel) {
+   if (m_levels[channel].empty())
+      return;
 
-         Glib::ustring fps = build_message("%d frames in %f seconds = %.3f FPS", 1, seconds, static_cast<float>(1 / seconds));
+   double samples_per_pixel = static_cast<double>(m_waveform->get_size()) / (get_width() * zoom());
+   if (samples_per_pixel <= 0)
+      return;
 
-         glColor4fv(m_color_text);
-         draw_text(10, 10, fps);
-      }
+   // the finest level which has blocks of one pixel at least,
+   // the blocks never overlap and the cost only depends on the width
+   const Level* level = &m_levels[channel].front();
+   for (const auto& l : m_levels[channel]) {
+      level = &l;
+      if (l.factor >= samples_per_pixel)
+         break;
    }
 
-   // Swap Buffer
-   if (gl->is_double_buffered())
-      gl->swap_buffers();
-   else
-      glFlush();
+   double block_width = level->factor / samples_per_pixel;
+   double begin = samples_per_pixel * get_start_area();
 
-   gl->gl_end();
-   return true;
-}
+   guint64 first = static_cast<guint64>(begin / level->factor);
+   if (first >= level->size)
+      return;
+   GLsizei count = static_cast<GLsizei>(std::min<guint64>(static_cast<guint64>(area.get_width() / block_width) + 2, level->size - first));
 
-// Display all scene:
-// - timeline (draw_timeline)
-// - waveform (draw_waveform)
-// - subtitle (draw_subtitles)
-// - time info (display_time_info)
-void WaveformRendererGL::draw(GdkEventExpose* ev) {
-   Gdk::Rectangle timeline_area(0, 0, get_width(), 30);
-   Gdk::Rectangle waveform_area(0, 0, get_width(), get_height() - 30);
+   float x = static_cast<float>(first * block_width - get_start_area());
 
-   // waveform
-   glPushMatrix();
-   draw_waveform(waveform_area);
-   glPopMatrix();
+   glUniform4f(glGetUniformLocation(m_waveform_program, "u_channel"), x, block_width, area.get_y() + area.get_height(), area.get_height());
+   glUniform1f(glGetUniformLocation(m_waveform_program, "u_scale"), scale() * area.get_height());
 
-   if (document()) {
-      glEnable(GL_BLEND);
+   glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const GLvoid*>((level->offset + first) * 2 * sizeof(GLfloat)));
 
-      draw_subtitles(waveform_area);
+   GLint u_component = glGetUniformLocation(m_waveform_program, "u_component");
+   GLint u_color = glGetUniformLocation(m_waveform_program, "u_color");
 
-      glDisable(GL_BLEND);
+   // the peaks, the transients stay visible at every zoom level
+   glUniform1i(u_component, 0);
+   glUniform4fv(u_color, 1, m_color_wave);
+   glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
 
-      // draw_subtitles_text(waveform_area);
+   // the RMS, the body of the signal
+   glUniform1i(u_component, 1);
+   glUniform4f(u_color, m_color_wave_fill[0], m_color_wave_fill[1], m_color_wave_fill[2], m_color_wave_fill[3] * 0.3f);
+   glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+}
 
-      draw_marker(waveform_area);
+void WaveformRendererGL::build_subtitles(Primitives& primitives) {
+   Subtitles subs = document()->subtitles();
+   Subtitle selected = subs.get_first_selected();
+   const SubtitleErrors& errors = document()->get_subtitle_errors();
+
+   unsigned int row = 0;
+   for (Subtitle sub = subs.get_first(); sub; ++sub, ++row) {
+      long s = sub.get_start().totalmsecs;
+      long e = sub.get_end().totalmsecs;
+
+      const float* color = m_color_subtitle;
+      if (s > e)
+         color = m_color_subtitle_invalid;
+      else if (selected && selected == sub)
+         color = m_color_subtitle_selected;
+      else if (errors.get(row) != 0)
+         color = m_color_subtitle_error;
+
+      add_rect(primitives, s, 0, e, 1, color);
    }
+}
 
-   // time line
-   glPushMatrix();
-   glTranslatef(-get_start_area(), get_height() - timeline_area.get_height(), 0);
-   draw_timeline(timeline_area);
-   glPopMatrix();
-
-   // FIXME: test it
-   // keyframes
-   // draw_keyframes(waveform_area);
-
-   // player position
-   {
-      glColor4fv(m_color_player_position);
-
-      int player_position = get_pos_by_time(player_time());
-
-      glPushMatrix();
-      glTranslatef(-get_start_area(), 0, 0);
-      glBegin(GL_LINES);
-      glVertex2f(player_position, 0);
-      glVertex2f(player_position, waveform_area.get_height());
-      glEnd();
-      glPopMatrix();
-   }
+void WaveformRendererGL::build_keyframes(Primitives& primitives) {
+   Player* player = SubtitleEditorWindow::get_instance()->get_player();
+   if (player == NULL)
+      return;
 
-   if (document() && m_display_time_info)
-      display_time_info(waveform_area);
+   Glib::RefPtr<KeyFrames> keyframes = player->get_keyframes();
+   if (!keyframes)
+      return;
+
+   // the width is given by the min width of the draw
+   for (auto it = keyframes->begin(); it != keyframes->end(); ++it) add_line(primitives, *it, 0, 1, 0, m_color_keyframe);
 }
 
-// Draw the channel in the area with the lines methods
-void WaveformRendererGL::draw_channel_with_line_strip(const Gdk::Rectangle& area, int channel) {
-   if (!m_waveform)
+// Draw the left and the right marker of the subtitle selected.
+void WaveformRendererGL::build_marker(Primitives& primitives, const Gdk::Rectangle& area) {
+   Subtitle selected = document()->subtitles().get_first_selected();
+   if (!selected)
       return;
 
-   std::vector<double>& peaks = m_waveform->m_channels[channel];
-
-   float skip = static_cast<float>(area.get_width()) / peaks.size();
+   float top = area.get_y();
+   float bottom = area.get_y() + area.get_height();
 
-   float px = 0;
+   float start = get_pos_by_time(selected.get_start().totalmsecs) - get_start_area();
+   float end = get_pos_by_time(selected.get_end().totalmsecs) - get_start_area();
 
-   glColor4fv(m_color_wave_fill);
+   float color_marker_left[] = {1.0f, 0.0f, 0.0f, 1.0f};
+   float color_marker_right[] = {1.0f, 0.6f, 0.0f, 1.0f};
 
-   glBegin(GL_LINE_STRIP);
+   float size = TRIANGLE_SIZE;
 
-   for (const auto it = peaks.begin(); it != peaks.end(); ++it, px += skip) glVertex2d(px, *it);
+   add_line(primitives, start, top, bottom, 2, color_marker_left);
+   add_rect(primitives, start, top, start + size, top + size, color_marker_left, true);
+   add_rect(primitives, start, bottom, start + size, bottom - size, color_marker_left, true);
 
-   glEnd();
+   add_line(primitives, end, top, bottom, 2, color_marker_right);
+   add_rect(primitives, end, top, end - size, top + size, color_marker_right, true);
+   add_rect(primitives, end, bottom, end - size, bottom - size, color_marker_right, true);
 }
 
-// Draw the channel in the area with the lines methods
-void WaveformRendererGL::draw_channel_with_quad_strip(const Gdk::Rectangle& area, int channel) {
-   if (!m_waveform)
-      return;
-
-   std::vector<double>& peaks = m_waveform->m_channels[channel];
+// Display the time every X seconds ("msec") with "upper" height
+void WaveformRendererGL::build_timeline(Primitives& primitives, const Gdk::Rectangle& area, long msec, int upper) {
+   int height = area.get_height();
 
-   float skip = static_cast<float>(area.get_width()) / peaks.size();
+   int start_area = get_start_area();
 
-   float px = 0;
+   long start = get_time_by_pos(start_area);
+   long end = get_time_by_pos(get_end_area());
 
-   glColor4fv(m_color_wave);
+   start -= start % msec;
 
-   glBegin(GL_QUAD_STRIP);
-   for (const auto it it = peaks.begin(); it != peaks.end(); ++it, px += skip) {
-      glVertex2d(px, 0);
-      glVertex2d(px, *it);
+   for (long t = start; t < end; t += msec) {
+      add_line(primitives, get_pos_by_time(t) - start_area, height - upper, height, 2, m_color_text);
    }
-   glEnd();
 }
 
-// Delete the OpenGL Display List (Waveform)
-void WaveformRendererGL::delete_display_lists() {
-   if (m_displayListSize > 0) {
-      glDeleteLists(m_displayList, m_displayListSize);
+void WaveformRendererGL::draw_primitives(GLuint buffer, const Primitives& primitives, const float transform[4], float min_width) {
+   glBindBuffer(GL_ARRAY_BUFFER, buffer);
+   glBufferData(GL_ARRAY_BUFFER, primitives.size() * sizeof(Primitive), primitives.data(), GL_DYNAMIC_DRAW);
 
-      m_displayList = m_displayListSize = 0;
-   }
+   draw_primitives(buffer, primitives.size(), transform, min_width);
 }
 
-// The Waveform used a display list for optimize the render.
-// If the OpenGL display list (waveform) is not yet create:
-// - Create the display list and draw the waveform inside.
-// Call the display list for drawing the waveform.
-void WaveformRendererGL::draw_waveform(const Gdk::Rectangle& rect) {
-   if (!m_waveform)
+void WaveformRendererGL::draw_primitives(GLuint buffer, GLsizei count, const float transform[4], float min_width) {
+   if (count == 0)
       return;
 
-   unsigned int n_channels = m_waveform->get_n_channels();
-
-   int h = rect.get_height() / n_channels;
-
-   if (m_displayListSize == 0) {
-      // display to rectangle 10x10
-      // after is scale to the widget area (size + zoom)
-      Gdk::Rectangle area(0, 0, 10, 10);
-      m_displayListRect = area;
+   glUseProgram(m_primitive_program);
+   glUniform2f(glGetUniformLocation(m_primitive_program, "u_viewport"), get_width(), get_height());
+   glUniform4fv(glGetUniformLocation(m_primitive_program, "u_transform"), 1, transform);
+   glUniform1f(glGetUniformLocation(m_primitive_program, "u_min_width"), min_width);
 
-      m_displayListSize = n_channels;
+   glBindBuffer(GL_ARRAY_BUFFER, buffer);
 
-      m_displayList = glGenLists(m_displayListSize);
-      for (unsigned int i = 0; i < n_channels; ++i) {
-         glNewList(m_displayList + i, GL_COMPILE);
+   const GLsizei stride = sizeof(Primitive);
+   glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(Primitive, rect)));
+   glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(Primitive, color)));
+   glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(Primitive, triangle)));
 
-         draw_channel_with_quad_strip(area, i);
-         draw_channel_with_line_strip(area, i);
-
-         glEndList();
-      }
+   for (GLuint i = 1; i <= 3; ++i) {
+      glEnableVertexAttribArray(i);
+      glVertexAttribDivisor(i, 1);
    }
 
-   glEnable(GL_SCISSOR_TEST);
-   glEnable(GL_BLEND);
-
-   float d = m_displayListRect.get_width();
-   float r = rect.get_width();
+   glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
 
-   float s = r / d;
-
-   for (unsigned int i = 0; i < n_channels; ++i) {
-      // clamp in waveform area
-      glScissor(0, h * i, rect.get_width(), h);
-
-      // position to channel area
-      glPushMatrix();
-      glTranslatef(-get_start_area(), h * i, 0);
-      // apply scale and zoom
-      glScalef(s * zoom(), scale() * rect.get_height(), 1);
-      // display the channel
-      glCallList(m_displayList + i);
-
-      glPopMatrix();
+   for (GLuint i = 1; i <= 3; ++i) {
+      glVertexAttribDivisor(i, 0);
+      glDisableVertexAttribArray(i);
    }
-   glDisable(GL_SCISSOR_TEST);
-   glDisable(GL_BLEND);
 }
 
-// Display all of timeline: Time, seconds
-void WaveformRendererGL::draw_timeline(const Gdk::Rectangle& area) {
-   long start = 0;
-   long end = get_width() * zoom();
-
-   // horizontal line
-   glColor4fv(m_color_text);
-
-   glBegin(GL_LINES);
-   glVertex2f(start, 0);
-   glVertex2f(end, 0);
-   glEnd();
-
-   // seconds
+// Return the step of the timeline (msecs), the labels don't overlap.
+long WaveformRendererGL::get_timeline_step(const Cairo::RefPtr<Cairo::Context>& cr) {
    long sec_1 = SubtitleTime(0, 0, 1, 0).totalmsecs;
-   long sec_5 = SubtitleTime(0, 0, 5, 0).totalmsecs;
-   long sec_10 = SubtitleTime(0, 0, 10, 0).totalmsecs;
 
    if (get_pos_by_time(sec_1) <= 0)
-      return;
+      return 0;
 
-   int text_width = get_text_width("0:00:00");
+   Cairo::TextExtents extents;
+   cr->get_text_extents("0:00:00", extents);
 
-   float margin = text_width + text_width * 0.5;
+   float margin = static_cast<float>(extents.width + extents.width * 0.5);
    while (get_pos_by_time(sec_1) < margin) {
       // for a sufficiently long duration sec_* will overflow before
       // the loop terminates. check the largest of them.
-      if (sec_10 > (LONG_MAX / 2))
+      if (sec_1 * 10 > (LONG_MAX / 2))
          break;
       sec_1 *= 2;
-      sec_5 *= 2;
-      sec_10 *= 2;
    }
-
-   draw_timeline_msecs(area, sec_1, 3);
-   draw_timeline_msecs(area, sec_5, 6);
-   draw_timeline_msecs(area, sec_10, 10);
-
-   draw_timeline_time(area, sec_1);
+   return sec_1;
 }
 
-// Display the time every X seconds ("msec") with "upper" height
-void WaveformRendererGL::draw_timeline_msecs(const Gdk::Rectangle& area, long msec, int upper) {
-   long start = 0;
-   long end = get_time_by_pos(get_width() * zoom());
-
-   glBegin(GL_LINES);
-   for (long t = start; t < end; t += msec) {
-      int x = get_pos_by_time(t);
+// Draw with Cairo the timeline time, the text of the subtitles
+// and the time info in the text layer, then upload it.
+// The lines of the timeline are built at the same time.
+void WaveformRendererGL::update_text_layer(const Gdk::Rectangle& area, Primitives& timeline) {
+   se_dbg(SE_DBG_WAVEFORM);
 
-      glVertex2f(x, 0);
-      glVertex2f(x, upper);
-   }
-   glEnd();
-}
+   int width = get_width();
+   int height = get_height();
+   int start_area = get_start_area();
 
-// Display the time text every X seconds (msec)
-void WaveformRendererGL::draw_timeline_time(const Gdk::Rectangle& area, long msec) {
-   int height = area.get_height();
+   // the surface and the texture are only reallocated with the size of the widget
+   bool resized = !m_text_surface || m_text_width != width || m_text_height != height;
+   if (resized) {
+      m_text_surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
 
-   long start = 0;
-   long end = get_time_by_pos(get_width() * zoom());
+      glBindTexture(GL_TEXTURE_2D, m_text_texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+   }
 
-   // make the list for text
-   glListBase(m_fontListBase);
+   Cairo::RefPtr<Cairo::Context> cr = Cairo::Context::create(m_text_surface);
 
-   Glib::ustring text = "0:00:00";
+   Gdk::Rectangle tarea(0, 0, width, TIMELINE_HEIGHT);
 
-   // center the text
-   float middle = get_text_width(text) * 0.5;
+   timeline.clear();
+   add_rect(timeline, 0, TIMELINE_HEIGHT - 1, width, TIMELINE_HEIGHT + 1, m_color_text);
 
-   glPushMatrix();
-   glTranslatef(-middle, height - 15, 0);
+   long sec_1 = get_timeline_step(cr);
+   if (sec_1 > 0) {
+      build_timeline(timeline, tarea, sec_1, 3);
+      build_timeline(timeline, tarea, sec_1 * 5, 6);
+      build_timeline(timeline, tarea, sec_1 * 10, 10);
+   }
 
-   for (long t = start; t < end; t += msec) {
-      int x = get_pos_by_time(t);
+   // font
+   cr->set_font_size(13);
+
+   int from = start_area;
+   int to = start_area + width;
+   // only scrolled, the rest of the ring is still valid
+   if (!resized && !m_text_dirty && m_text_zoom == zoom() && std::abs(start_area - m_text_start_area) < width) {
+      if (start_area > m_text_start_area)
+         from = m_text_start_area + width;
+      else
+         to = m_text_start_area;
+   }
 
-      text = SubtitleTime(t).str().substr(0, 7);
+   draw_text_range(cr, area, sec_1, from, to);
 
-      glRasterPos2f(x, 0);
-      glCallLists(text.length(), GL_UNSIGNED_BYTE, text.c_str());
-   }
-   glPopMatrix();
+   m_text_width = width;
+   m_text_height = height;
+   m_text_start_area = start_area;
+   m_text_zoom = zoom();
+   // the time info follows the mouse, it's removed by the next draw
+   m_text_dirty = m_display_time_info;
 }
 
-// Display the time of the mouse
-// and the duration of the selected subtitle
-void WaveformRendererGL::display_time_info(const Gdk::Rectangle& area) {
-   int text_width = get_text_width(SubtitleTime::null());
-
-   int xpos = 0, ypos = 0;
-   Gdk::ModifierType mod;
+// Draw and upload the pixels [from:to) of the area in the ring of the text layer.
+// The range is split where it wraps around the end of the surface.
+void WaveformRendererGL::draw_text_range(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area, long step, int from, int to) {
+   int width = m_text_surface->get_width();
+   int height = m_text_surface->get_height();
+
+   glBindTexture(GL_TEXTURE_2D, m_text_texture);
+   // the stride of cairo is a multiple of 4 bytes, so a whole number of pixels
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, m_text_surface->get_stride() / 4);
+
+   while (from < to) {
+      int x = (from % width + width) % width;
+      int size = std::min(to - from, width - x);
+
+      cr->save();
+      cr->rectangle(x, 0, size, height);
+      cr->clip();
+      cr->set_operator(Cairo::OPERATOR_CLEAR);
+      cr->paint();
+      cr->set_operator(Cairo::OPERATOR_OVER);
+
+      // from now in the coordinates of the whole area
+      cr->translate(x - from, 0);
+
+      if (step > 0)
+         draw_timeline_time(cr, step, from, from + size);
+
+      if (document() && m_display_subtitle_text) {
+         cr->save();
+         cr->translate(0, area.get_y());
+         draw_subtitles_text(cr, area, from, from + size);
+         cr->restore();
+      }
 
-   get_window()->get_pointer(xpos, ypos, mod);
-   // opengl
-   ypos = area.get_height() - ypos;
+      if (m_display_time_info) {
+         cr->save();
+         cr->translate(get_start_area(), 0);
+         display_time_info(cr);
+         cr->restore();
+      }
+      cr->restore();
 
-   int xpos_area = get_mouse_coords(xpos);
+      m_text_surface->flush();
 
-   // display the time of the mouse in the area
-   Glib::ustring time = SubtitleTime(get_time_by_pos(xpos_area)).str();
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, x, 0, size, height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, m_text_surface->get_data());
 
-   glColor4fv(m_color_text);
-   draw_text(xpos - text_width * 0.5, ypos, time);
+      from += size;
+   }
 
-   // display the duration of the current subtitle
-   Subtitle selected = document()->subtitles().get_first_selected();
-   if (selected) {
-      SubtitleTime start = selected.get_start();
-      SubtitleTime duration = selected.get_duration();
+   glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
 
-      int sub_center = get_pos_by_time(start.totalmsecs + duration.totalmsecs / 2);
+// Display the time text every X seconds (msec),
+// the labels across the bounds of [from:to) are also drawn.
+void WaveformRendererGL::draw_timeline_time(const Cairo::RefPtr<Cairo::Context>& cr, long msec, int from, int to) {
+   cr->set_source_rgba(m_color_text[0], m_color_text[1], m_color_text[2], m_color_text[3]);
 
-      glColor4fv(m_color_text);
-      draw_text(sub_center - get_start_area() - text_width * 0.5, ypos - m_fontHeight, duration.str());
-   }
-}
+   Cairo::TextExtents extents;
+   cr->get_text_extents("0:00:00", extents);
 
-void WaveformRendererGL::draw_keyframes(const Gdk::Rectangle& rect) {
-   Player* player = SubtitleEditorWindow::get_instance()->get_player();
-   if (player == NULL)
-      return;
+   double height = extents.height + 5;
 
-   Glib::RefPtr<KeyFrames> keyframes = player->get_keyframes();
-   if (!keyframes)
-      return;
+   double center = extents.width * 0.5;
 
-   int height = rect.get_height();
+   long start = get_time_by_pos(std::max(0, from - static_cast<int>(extents.width)));
+   long end = get_time_by_pos(to + static_cast<int>(extents.width));
 
-   glColor4fv(m_color_keyframe);
+   start -= start % msec;
 
-   long start_clip = get_time_by_pos(get_start_area());
-   long end_clip = get_time_by_pos(get_end_area());
+   for (long t = start; t < end; t += msec) {
+      int x = get_pos_by_time(t);
 
-   glBegin(GL_LINES);
-   for (KeyFrames::const_iterator it = keyframes->begin(); it != keyframes->end(); ++it) {
-      // display only if it's in the area
-      if (*it < start_clip && *it < end_clip)
-         continue;
-      if (*it > end_clip)
-         break;  // the next keyframes are out of the area
+      cr->move_to(x - center, height);
 
-      long pos = get_pos_by_time(*it);
-      glVertex2f(pos, 0);
-      glVertex2f(pos, height);
+      cr->show_text(SubtitleTime(t).str().substr(0, 7));
    }
-   glEnd();
+   cr->stroke();
 }
 
-// Draw the left and the right marker of the subtitle selected.
-void WaveformRendererGL::draw_marker(const Gdk::Rectangle& rect) {
-   Subtitle selected = document()->subtitles().get_first_selected();
-   if (!selected)
-      return;
-
-   int height = rect.get_height();
-
-   int start = get_pos_by_time(selected.get_start().totalmsecs) - get_start_area();
-   int end = get_pos_by_time(selected.get_end().totalmsecs) - get_start_area();
-
-   glBegin(GL_LINES);
-   // start line
-   glColor3f(1, 0, 0);
-   glVertex2f(start, 0);
-   glVertex2f(start, height);
-   // end line
-   glColor3f(1, .6, 0);
-   glVertex2f(end, 0);
-   glVertex2f(end, height);
-   glEnd();
-
-   // triangle size (top and bottom)
-   int size = 10;
-
-   glBegin(GL_TRIANGLES);
-
-   glColor3f(1, 0, 0);
-   // start + bottom
-   glVertex2f(start, 0);
-   glVertex2f(start, size);
-   glVertex2f(start + size, 0);
-   // start + top
-   glVertex2f(start, height);
-   glVertex2f(start + size, height);
-   glVertex2f(start, height - size);
-
-   glColor3f(1, .6, 0);
-   // end + bottom
-   glVertex2f(end, 0);
-   glVertex2f(end - size, 0);
-   glVertex2f(end, size);
-   // end + top
-   glVertex2f(end, height);
-   glVertex2f(end, height - size);
-   glVertex2f(end - size, height);
-   glEnd();
-}
-
-// Draw subtitles visible
-void WaveformRendererGL::draw_subtitles(const Gdk::Rectangle& rect) {
-   if (!document())
-      return;
+// Draw the text of the subtitles visible in [from:to) of the area,
+// the context is in the coordinates of the whole area.
+void WaveformRendererGL::draw_subtitles_text(const Cairo::RefPtr<Cairo::Context>& cr, const Gdk::Rectangle& area, int from, int to) {
+   SubtitleTime start_clip(get_time_by_pos(from));
+   SubtitleTime end_clip(get_time_by_pos(to));
 
-   SubtitleTime start_clip(get_time_by_pos(get_start_area()));
-   SubtitleTime end_clip(get_time_by_pos(get_end_area()));
+   if (!m_layout_text)
+      m_layout_text = Pango::Layout::create(cr);
 
-   int height = rect.get_height();
-
-   Subtitles subs = document()->subtitles();
-   Subtitle selected = subs.get_first_selected();
+   for (Subtitle sub : document()->subtitles().find(start_clip, end_clip)) {
+      int start = get_pos_by_time(sub.get_start().totalmsecs);
+      int end = get_pos_by_time(sub.get_end().totalmsecs);
 
-   glPushMatrix();
-   glTranslatef(-get_start_area(), 0, 0);
+      cr->save();
 
-   if (selected) {
-      for (Subtitle sub = subs.get_first(); sub; ++sub) {
-         SubtitleTime start = sub.get_start();
-         SubtitleTime end = sub.get_end();
-
-         if (start < start_clip && end < start_clip)
-            continue;
-         if (start > end_clip && end > end_clip)
-            break;
-
-         int s = get_pos_by_time(start.totalmsecs);
-         int e = get_pos_by_time(end.totalmsecs);
-
-         if (s > e)
-            glColor4fv(m_color_subtitle_invalid);
-         else if (selected == sub)
-            glColor4fv(m_color_subtitle_selected);
-         else
-            glColor4fv(m_color_subtitle);
-
-         glRectf(s, 0, e, height);
-      }
-   } else {
-      for (Subtitle sub = subs.get_first(); sub; ++sub) {
-         SubtitleTime start = sub.get_start();
-         SubtitleTime end = sub.get_end();
+      cr->rectangle(start, 0, end - start, area.get_height());
+      cr->clip();
 
-         if (start < start_clip && end < start_clip)
-            continue;
-         if (start > end_clip && end > end_clip)
-            break;
+      cr->set_source_rgba(m_color_text[0], m_color_text[1], m_color_text[2], m_color_text[3]);
+      cr->move_to(start, TRIANGLE_SIZE * 2);
 
-         int s = get_pos_by_time(start.totalmsecs);
-         int e = get_pos_by_time(end.totalmsecs);
+      m_layout_text->set_text(sub.get_text());
+      m_layout_text->update_from_cairo_context(cr);
+      m_layout_text->add_to_cairo_context(cr);
 
-         if (s > e)
-            glColor4fv(m_color_subtitle_invalid);
-         else
-            glColor4fv(m_color_subtitle);
+      cr->fill();
 
-         glRectf(s, 0, e, height);
-      }
+      cr->restore();
    }
-   glPopMatrix();
 }
 
-// Draw the text of the subtitles visible
-void WaveformRendererGL::draw_subtitles_text(const Gdk::Rectangle& rect) {
-   if (!document())
-      return;
-
-   SubtitleTime start_clip(get_time_by_pos(get_start_area()));
-   SubtitleTime end_clip(get_time_by_pos(get_end_area()));
+// Display the time of the mouse
+// and the duration of the selected subtitle
+void WaveformRendererGL::display_time_info(const Cairo::RefPtr<Cairo::Context>& cr) {
+   Cairo::TextExtents extents;
+   cr->get_text_extents(SubtitleTime::null(), extents);
 
-   float height = rect.get_height() - m_fontHeight * 2;
+   double text_width = extents.width;
+   double text_height = extents.height;
 
-   Subtitles subs = document()->subtitles();
-   Subtitle selected = subs.get_first_selected();
+   int xpos = 0, ypos = 0;
+   Gdk::ModifierType mod;
 
-   glPushMatrix();
-   glTranslatef(-get_start_area(), 0, 0);
+   get_window()->get_pointer(xpos, ypos, mod);
 
-   glColor4fv(m_color_text);
-   glListBase(m_fontListBase);
+   // display the time of the mouse in the area
+   Glib::ustring time = SubtitleTime(get_time_by_pos(get_mouse_coords(xpos))).str();
 
-   for (Subtitle sub = subs.get_first(); sub; ++sub) {
-      SubtitleTime start = sub.get_start();
-      SubtitleTime end = sub.get_end();
+   cr->set_source_rgba(m_color_text[0], m_color_text[1], m_color_text[2], m_color_text[3]);
 
-      if (start < start_clip && end < start_clip)
-         continue;
-      if (start > end_clip && end > end_clip)
-         break;
+   cr->move_to(xpos - text_width * 0.5, ypos - text_height);
+   cr->show_text(time);
 
-      int s = get_pos_by_time(start.totalmsecs);
-      // int e = get_pos_by_time(end.totalmsecs);
+   if (document()) {
+      Subtitle selected = document()->subtitles().get_first_selected();
+      if (selected) {
+         SubtitleTime start = selected.get_start();
+         SubtitleTime duration = selected.get_duration();
 
-      glRasterPos2f(s, height);
+         int sub_center = get_pos_by_time(start.totalmsecs + duration.totalmsecs / 2);
 
-      std::string text = sub.get_text();
-      // glRectf(s, 0, e, height);
-      glCallLists(text.length(), GL_UNSIGNED_BYTE, text.c_str());
+         cr->move_to(sub_center - get_start_area() - text_width * 0.5, ypos + text_height * 2);
+         cr->show_text(duration.str());
+      }
    }
+}
+
+// Add a line of 'width' pixels (or msecs) centered on x
+void WaveformRendererGL::add_line(Primitives& primitives, float x, float y0, float y1, float width, const float color[4]) {
+   add_rect(primitives, x - width * 0.5f, y0, x + width * 0.5f, y1, color);
+}
 
-   glPopMatrix();
+void WaveformRendererGL::add_rect(Primitives& primitives, float x0, float y0, float x1, float y1, const float color[4], bool triangle) {
+   Primitive p = {{x0, y0, x1, y1}, {color[0], color[1], color[2], color[3]}, triangle ? 1.0f : 0.0f};
+   primitives.push_back(p);
 }
 
 // The waveform is changed.
-// Need to force to redisplay the waveform.
-// Delete the display list
+// Need to upload again the peak pyramid.
 void WaveformRendererGL::waveform_changed() {
-   delete_display_lists();
+   se_dbg(SE_DBG_WAVEFORM);
 
-   queue_draw();
+   m_waveform_dirty = m_text_dirty = true;
+   queue_render();
 }
 
 void WaveformRendererGL::keyframes_changed() {
-   queue_draw();
+   se_dbg(SE_DBG_WAVEFORM);
+
+   m_keyframes_dirty = true;
+   queue_render();
 }
 
-// Call queue_draw
+void WaveformRendererGL::subtitles_changed() {
+   se_dbg(SE_DBG_WAVEFORM);
+
+   m_subtitles_dirty = m_text_dirty = true;
+   queue_render();
+}
+
+void WaveformRendererGL::selection_changed() {
+   se_dbg(SE_DBG_WAVEFORM);
+
+   m_subtitles_dirty = true;
+   queue_render();
+}
+
+// Call queue_render
 void WaveformRendererGL::redraw_all() {
-   queue_draw();
+   se_dbg(SE_DBG_WAVEFORM);
+
+   queue_render();
 }
 
-// Delete display list and redraw
+// Rebuild all the buffers and redraw
 void WaveformRendererGL::force_redraw_all() {
-   delete_display_lists();
+   se_dbg(SE_DBG_WAVEFORM);
 
-   queue_draw();
+   m_waveform_dirty = m_subtitles_dirty = m_keyframes_dirty = m_text_dirty = true;
+   queue_render();
 }
 
 // HACK!
-WaveformRenderer* create_waveform_renderer_gl() {
+// Return NULL if the window isn't realized or if the window system can't
+// create an OpenGL context, the caller falls back to another renderer.
+WaveformRenderer* create_waveform_renderer_gl(const Glib::RefPtr<Gdk::Window>& window) {
+   if (!window)
+      return NULL;
+
+   try {
+      Glib::RefPtr<Gdk::GLContext> context = window->create_gl_context();
+      context->set_required_version(3, 3);
+      context->realize();
+   } catch (const Glib::Error& ex) {
+      std::cerr << "OpenGL is not available, used another Waveform Renderer: " << ex.what() << std::endl;
+      return NULL;
+   }
    return manage(new WaveformRendererGL());
 }
 